@@ -0,0 +1,71 @@
+#ifndef QALGORITHMS_COLUMNAR_INCLUDED
+#define QALGORITHMS_COLUMNAR_INCLUDED
+
+#include <cstdint>
+#include <cstddef>
+
+// layout of the columnar binary output (.qcol). This header has no dependencies on the rest of qAlgorithms,
+// so it can be included by external readers (see tools/qalgo_utility.cpp). The layout is described in the README.
+// All values are stored little-endian, all offsets are counted from the start of the file:
+//  | ColumnarHeader (32 bytes) | ColumnEntry * columnCount (64 bytes each) | padding | column block | padding | column block ...
+// Every column block starts at a multiple of COLUMN_ALIGNMENT and is a plain array of count values of the column type,
+// so a memory-mapped file can be read without copying. Most columns contain exactly rowCount values. Columns with a
+// variable number of values per row (the b0 of components) are stored as a value column and an offset column
+// with rowCount + 1 entries, the values of row i are in [offset[i], offset[i + 1]).
+
+namespace qAlgorithms
+{
+    constexpr char COLUMNAR_MAGIC[8] = {'Q', 'A', 'L', 'G', 'C', 'O', 'L', '\0'};
+    constexpr uint32_t COLUMNAR_VERSION = 1;
+    constexpr size_t COLUMN_ALIGNMENT = 64;
+    constexpr size_t COLUMN_NAME_LENGTH = 40; // including the terminating zero
+
+    enum class ColumnType : uint32_t
+    {
+        uint8 = 0, // also used for booleans
+        int32 = 1,
+        uint32 = 2,
+        uint64 = 3,
+        float32 = 4,
+        float64 = 5
+    };
+
+    constexpr size_t columnTypeSize(ColumnType type)
+    {
+        switch (type)
+        {
+        case ColumnType::uint8:
+            return 1;
+        case ColumnType::int32:
+        case ColumnType::uint32:
+        case ColumnType::float32:
+            return 4;
+        case ColumnType::uint64:
+        case ColumnType::float64:
+            return 8;
+        }
+        return 0;
+    }
+
+    struct ColumnarHeader
+    {
+        char magic[8];         // COLUMNAR_MAGIC
+        uint32_t version;      // COLUMNAR_VERSION
+        uint32_t columnCount;  // number of ColumnEntry that directly follow the header
+        uint64_t rowCount;     // number of rows in the table
+        uint64_t reserved = 0; // always 0 for version 1
+    };
+    static_assert(sizeof(ColumnarHeader) == 32);
+
+    struct ColumnEntry
+    {
+        char name[COLUMN_NAME_LENGTH]; // zero-terminated, same as the column name in the csv output
+        ColumnType type;
+        uint32_t reserved = 0;
+        uint64_t offset; // start of the column block
+        uint64_t count;  // number of values in the column block
+    };
+    static_assert(sizeof(ColumnEntry) == 64);
+}
+
+#endif
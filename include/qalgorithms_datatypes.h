@@ -3,6 +3,10 @@
 #define QALGORITHMS_DATATYPE_PEAK_H
 
 #include <vector>
+#include <span>
+#include <cstddef>
+#include <memory>
+#include <algorithm>
 
 /* This file includes the structs used for data management in qAlgorithms*/
 
@@ -31,6 +35,13 @@ namespace qAlgorithms
         unsigned int largestScan;
     };
 
+    // the decoded arrays of one mass spectrum, see findCentroids_MZML
+    struct SpectrumArrays
+    {
+        std::span<const double> mz;
+        std::span<const double> intensity;
+    };
+
     struct ProfileBlock
     {
         std::vector<float> intensity;
@@ -91,22 +102,133 @@ namespace qAlgorithms
         unsigned int cenID;
     };
 
-    struct EIC // Extracted Ion Chromatogram
+    /// @brief position of the columns of one bin in a contiguous block of memory, see EIC and EICStore
+    /// @details the interpolated IDs are stored first, followed by the ten columns with one value per centroid
+    /// and the interpolated DQSB. Since all other columns are four bytes wide, every column is aligned.
+    struct EICLayout
     {
-        std::vector<unsigned int> scanNumbers;
-        std::vector<float> rententionTimes;
-        std::vector<float> mz;
-        std::vector<float> predInterval;
-        std::vector<float> ints_area;
-        std::vector<float> ints_height;
-        std::vector<unsigned int> df;
-        std::vector<float> DQSB;
-        std::vector<float> DQSC;
-        std::vector<unsigned int> cenID;
-        std::vector<size_t> interpolatedIDs;
-        std::vector<float> interpolatedDQSB;
-        size_t componentID = 0; // this is only set during componentisation
-        bool interpolations;    // @todo probably redundant
+        size_t length;             // number of centroids in the bin
+        size_t interpolatedLength; // number of points including interpolations and the two extrapolated points per side
+
+        // the columns with one value per centroid, in the order they are stored in
+        enum Column : size_t
+        {
+            scanNumbers,
+            rententionTimes,
+            mz,
+            predInterval,
+            ints_area,
+            ints_height,
+            df,
+            DQSB,
+            DQSC,
+            cenID,
+            columnCount
+        };
+
+        size_t offset(Column column) const { return interpolatedLength * sizeof(size_t) + column * length * 4; }
+        size_t offsetInterpolatedDQSB() const { return offset(columnCount); }
+        // end of the last column, the bytes after it are padding
+        size_t used() const { return offsetInterpolatedDQSB() + interpolatedLength * sizeof(float); }
+        // the size is rounded up so that the next block starts aligned
+        size_t bytes() const { return (used() + alignof(size_t) - 1) / alignof(size_t) * alignof(size_t); }
+    };
+    static_assert(sizeof(float) == 4 && sizeof(unsigned int) == 4);
+
+    /// @brief non-owning view on one bin, the members have the same names as the columns of the EIC
+    struct BinView
+    {
+        std::span<const unsigned int> scanNumbers;
+        std::span<const float> rententionTimes;
+        std::span<const float> mz;
+        std::span<const float> predInterval;
+        std::span<const float> ints_area;
+        std::span<const float> ints_height;
+        std::span<const unsigned int> df;
+        std::span<const float> DQSB;
+        std::span<const float> DQSC;
+        std::span<const unsigned int> cenID;
+        std::span<const size_t> interpolatedIDs;
+        std::span<const float> interpolatedDQSB;
+        size_t componentID = 0;
+        bool interpolations;
+    };
+
+    template <typename T>
+    std::span<T> blockColumn(std::byte *block, size_t offset, size_t length)
+    {
+        return std::span<T>(reinterpret_cast<T *>(block + offset), length);
+    }
+
+    template <typename T>
+    std::span<const T> blockColumn(const std::byte *block, size_t offset, size_t length)
+    {
+        return std::span<const T>(reinterpret_cast<const T *>(block + offset), length);
+    }
+
+    // create the view on a block that is laid out as described by layout
+    inline BinView viewBlock(const std::byte *block, EICLayout layout, size_t componentID, bool interpolations)
+    {
+        const size_t length = layout.length;
+        return BinView{
+            blockColumn<unsigned int>(block, layout.offset(EICLayout::scanNumbers), length),
+            blockColumn<float>(block, layout.offset(EICLayout::rententionTimes), length),
+            blockColumn<float>(block, layout.offset(EICLayout::mz), length),
+            blockColumn<float>(block, layout.offset(EICLayout::predInterval), length),
+            blockColumn<float>(block, layout.offset(EICLayout::ints_area), length),
+            blockColumn<float>(block, layout.offset(EICLayout::ints_height), length),
+            blockColumn<unsigned int>(block, layout.offset(EICLayout::df), length),
+            blockColumn<float>(block, layout.offset(EICLayout::DQSB), length),
+            blockColumn<float>(block, layout.offset(EICLayout::DQSC), length),
+            blockColumn<unsigned int>(block, layout.offset(EICLayout::cenID), length),
+            blockColumn<size_t>(block, 0, layout.interpolatedLength),
+            blockColumn<float>(block, layout.offsetInterpolatedDQSB(), layout.interpolatedLength),
+            componentID,
+            interpolations};
+    }
+
+    /// @brief Extracted Ion Chromatogram, all columns are stored in a single allocation
+    /// @details the buffer is laid out as described by EICLayout, so the EIC can be copied into the EICStore
+    /// as one block. The columns are written through the span accessors, view() gives read-only access to all of them.
+    struct EIC
+    {
+        EIC() = default;
+        // the columns are not initialised, only the padding at the end of the buffer is set to zero
+        explicit EIC(EICLayout layout)
+            : layout(layout), buffer(std::make_unique_for_overwrite<std::byte[]>(layout.bytes()))
+        {
+            std::fill(buffer.get() + layout.used(), buffer.get() + layout.bytes(), std::byte{0});
+        }
+
+        EICLayout layout = {0, 0};
+        std::unique_ptr<std::byte[]> buffer;
+        size_t componentID = 0;      // this is only set during componentisation
+        bool interpolations = false; // @todo probably redundant
+
+        std::span<unsigned int> scanNumbers() { return column<unsigned int>(EICLayout::scanNumbers); }
+        std::span<float> rententionTimes() { return column<float>(EICLayout::rententionTimes); }
+        std::span<float> mz() { return column<float>(EICLayout::mz); }
+        std::span<float> predInterval() { return column<float>(EICLayout::predInterval); }
+        std::span<float> ints_area() { return column<float>(EICLayout::ints_area); }
+        std::span<float> ints_height() { return column<float>(EICLayout::ints_height); }
+        std::span<unsigned int> df() { return column<unsigned int>(EICLayout::df); }
+        std::span<float> DQSB() { return column<float>(EICLayout::DQSB); }
+        std::span<float> DQSC() { return column<float>(EICLayout::DQSC); }
+        std::span<unsigned int> cenID() { return column<unsigned int>(EICLayout::cenID); }
+        std::span<size_t> interpolatedIDs() { return blockColumn<size_t>(buffer.get(), 0, layout.interpolatedLength); }
+        std::span<float> interpolatedDQSB()
+        {
+            return blockColumn<float>(buffer.get(), layout.offsetInterpolatedDQSB(), layout.interpolatedLength);
+        }
+
+        BinView view() const { return viewBlock(buffer.get(), layout, componentID, interpolations); }
+
+    private:
+        template <typename T>
+        std::span<T> column(EICLayout::Column column)
+        {
+            return blockColumn<T>(buffer.get(), layout.offset(column), layout.length);
+        }
     };
 
     struct FeaturePeak
@@ -0,0 +1,64 @@
+#ifndef QALGORITHMS_EIC_STORE_H
+#define QALGORITHMS_EIC_STORE_H
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <vector>
+#include "qalgorithms_datatypes.h"
+
+namespace qAlgorithms
+{
+    /// @brief all bins of one measurement, packed into a single contiguous arena
+    /// @details every bin is one block in the arena, laid out as described by EICLayout, and the blocks are
+    /// found through one offset per bin. If a spill directory is given, the arena is a memory-mapped temporary
+    /// file in that directory, so the operating system can write bins that are not accessed to disk instead of
+    /// keeping all of them in memory. The file is deleted as soon as it is mapped, nothing is left behind if the
+    /// program crashes. If the file cannot be created (or on windows), the arena is allocated on the heap.
+    class EICStore
+    {
+    public:
+        EICStore() = default;
+        /// @brief copy the bins into the arena. Every bin is released once it was copied, the vector is empty afterwards
+        EICStore(std::vector<EIC> *bins, const std::filesystem::path &spillDirectory);
+        /// @brief allocate the arena for bins of the given size, the content is filled through arena()
+        EICStore(std::vector<EICLayout> binLayouts, const std::filesystem::path &spillDirectory);
+        ~EICStore();
+        EICStore(EICStore &&other) noexcept;
+        EICStore &operator=(EICStore &&other) noexcept;
+        EICStore(const EICStore &) = delete;
+        EICStore &operator=(const EICStore &) = delete;
+
+        size_t size() const { return layouts.size(); }
+        bool empty() const { return layouts.empty(); }
+        bool spilled() const { return mapped; }
+
+        BinView at(size_t binID) const;
+        BinView operator[](size_t binID) const { return at(binID); }
+
+        // this is only set during componentisation
+        void setComponentID(size_t binID, size_t componentID) { componentIDs[binID] = componentID; }
+
+        // access to the raw data, used for checkpoints
+        const std::vector<EICLayout> *blockLayouts() const { return &layouts; }
+        const std::vector<size_t> *binComponentIDs() const { return &componentIDs; }
+        const std::vector<unsigned char> *binInterpolations() const { return &interpolations; }
+        std::span<const std::byte> arena() const { return {data, arenaSize}; }
+        std::span<std::byte> arena() { return {data, arenaSize}; }
+        void setBinInfo(size_t binID, size_t componentID, bool interpolated);
+
+    private:
+        void allocate(const std::filesystem::path &spillDirectory);
+        void release();
+
+        std::vector<EICLayout> layouts;
+        std::vector<size_t> offsets; // start of every block in the arena
+        std::vector<size_t> componentIDs;
+        std::vector<unsigned char> interpolations;
+        std::byte *data = nullptr;
+        size_t arenaSize = 0;
+        bool mapped = false; // the arena is a memory-mapped file and not allocated with new
+    };
+}
+
+#endif
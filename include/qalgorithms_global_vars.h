@@ -2,19 +2,49 @@
 #define _QALGORITHMS_GLOBALS_INCLUDED
 
 #include <array>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
 
 namespace qAlgorithms
 {
     extern float PPM_PRECENTROIDED;
     extern float MZ_ABSOLUTE_PRECENTROIDED;
 
+    // critical f-values for the merge test of qPattern, precalculated using cdff() from CDFlib with alpha = 0.05.
+    // the numerator degrees of freedom are always 3, given are the values for df2 = index + 1.
+    static constexpr double F_VALUES_MERGE[256] = {215.7073454, 19.16429213, 9.276628153, 6.591382116, 5.409451318, 4.757062663, 4.346831402, 4.066180551, 3.862548358, 3.708264819, 3.587433702, 3.49029482, 3.410533645, 3.343888678, 3.287382105, 3.238871517, 3.196776841, 3.15990759, 3.127350001, 3.098391212, 3.072466986, 3.049124989, 3.027998382, 3.00878657, 2.99124091, 2.975153964, 2.960351318, 2.946685266, 2.93402989, 2.922277191, 2.911334014, 2.901119584, 2.891563517, 2.882604204, 2.874187484, 2.866265551, 2.858796054, 2.851741336, 2.845067805, 2.838745398, 2.83274713, 2.827048712, 2.82162822, 2.816465817, 2.811543506, 2.806844929, 2.802355176, 2.798060635, 2.793948852, 2.790008406, 2.786228813, 2.782600423, 2.779114345, 2.77576237, 2.772536908, 2.769430932, 2.766437926, 2.763551837, 2.76076704, 2.758078296, 2.75548072, 2.752969754, 2.750541138, 2.748190888, 2.745915273, 2.743710792, 2.741574163, 2.739502302, 2.737492308, 2.735541451, 2.73364716, 2.73180701, 2.730018714, 2.72828011, 2.726589156, 2.72494392, 2.723342573, 2.721783382, 2.720264704, 2.718784982, 2.717342734, 2.715936556, 2.714565112, 2.713227129, 2.7119214, 2.710646771, 2.709402145, 2.708186474, 2.706998761, 2.705838051, 2.704703435, 2.703594041, 2.70250904, 2.701447634, 2.700409063, 2.699392598, 2.69839754, 2.69742322, 2.696468997, 2.695534255, 2.694618404, 2.693720877, 2.692841129, 2.691978638, 2.691132901, 2.690303434, 2.689489772, 2.688691468, 2.687908091, 2.687139227, 2.686384475, 2.685643451, 2.684915784, 2.684201116, 2.683499101, 2.682809407, 2.682131712, 2.681465706, 2.680811088, 2.68016757, 2.679534871, 2.678912721, 2.678300858, 2.677699029, 2.677106989, 2.676524502, 2.675951338, 2.675387275, 2.674832098, 2.674285598, 2.673747575, 2.673217831, 2.672696178, 2.672182432, 2.671676414, 2.671177951, 2.670686875, 2.670203023, 2.669726237, 2.669256364, 2.668793253, 2.668336761, 2.667886745, 2.66744307, 2.667005603, 2.666574213, 2.666148776, 2.665729168, 2.665315271, 2.66490697, 2.66450415, 2.664106703, 2.663714522, 2.663327503, 2.662945545, 2.662568549, 2.662196419, 2.661829061, 2.661466384, 2.6611083, 2.660754721, 2.660405564, 2.660060745, 2.659720184, 2.659383804, 2.659051527, 2.658723278, 2.658398986, 2.658078579, 2.657761987, 2.657449143, 2.65713998, 2.656834435, 2.656532443, 2.656233944, 2.655938877, 2.655647183, 2.655358805, 2.655073686, 2.654791771, 2.654513008, 2.654237343, 2.653964724, 2.653695103, 2.653428428, 2.653164654, 2.652903731, 2.652645615, 2.652390261, 2.652137624, 2.651887661, 2.65164033, 2.651395589, 2.651153399, 2.650913719, 2.65067651, 2.650441735, 2.650209357, 2.649979338, 2.649751643, 2.649526238, 2.649303087, 2.649082157, 2.648863415, 2.648646829, 2.648432366, 2.648219997, 2.64800969, 2.647801415, 2.647595144, 2.647390847, 2.647188496, 2.646988063, 2.646789522, 2.646592846, 2.646398009, 2.646204984, 2.646013747, 2.645824273, 2.645636537, 2.645450517, 2.645266188, 2.645083528, 2.644902514, 2.644723123, 2.644545335, 2.644369127, 2.644194479, 2.64402137, 2.64384978, 2.64367969, 2.643511078, 2.643343927, 2.643178217, 2.643013929, 2.642851047, 2.64268955, 2.642529423, 2.642370648, 2.642213207, 2.642057083, 2.641902261, 2.641748724, 2.641596457, 2.641445443, 2.641295667, 2.641147114, 2.640999769, 2.640853617, 2.640708644, 2.640564836, 2.640422179, 2.640280659, 2.640140262, 2.640000975, 2.639862785};
     static constexpr float T_VALUES[256] = {6.313751515, 2.91998558, 2.353363435, 2.131846781, 2.015048373, 1.94318028, 1.894578605, 1.859548038, 1.833112933, 1.812461123, 1.795884819, 1.782287556, 1.770933396, 1.761310136, 1.753050356, 1.745883676, 1.739606726, 1.734063607, 1.729132812, 1.724718243, 1.720742903, 1.717144374, 1.713871528, 1.71088208, 1.708140761, 1.70561792, 1.703288446, 1.701130934, 1.699127027, 1.697260894, 1.695518789, 1.693888742, 1.692360304, 1.690924251, 1.689572454, 1.688297711, 1.687093617, 1.685954458, 1.684875119, 1.683851011, 1.682878, 1.681952356, 1.681070702, 1.680229975, 1.679427392, 1.678660413, 1.677926721, 1.677224195, 1.676550892, 1.675905025, 1.67528495, 1.674689153, 1.674116236, 1.673564906, 1.673033965, 1.672522303, 1.672028888, 1.671552762, 1.671093032, 1.670648865, 1.670219484, 1.669804162, 1.669402222, 1.669013025, 1.668635976, 1.668270514, 1.667916114, 1.667572281, 1.667238549, 1.666914479, 1.666599658, 1.666293696, 1.665996224, 1.665706893, 1.665425373, 1.665151353, 1.664884537, 1.664624644, 1.664371409, 1.664124579, 1.663883913, 1.663649184, 1.663420175, 1.663196679, 1.6629785, 1.662765449, 1.662557349, 1.662354029, 1.662155326, 1.661961084, 1.661771155, 1.661585397, 1.661403674, 1.661225855, 1.661051817, 1.66088144, 1.66071461, 1.660551217, 1.660391156, 1.660234326, 1.66008063, 1.659929976, 1.659782273, 1.659637437, 1.659495383, 1.659356034, 1.659219312, 1.659085144, 1.658953458, 1.658824187, 1.658697265, 1.658572629, 1.658450216, 1.658329969, 1.65821183, 1.658095744, 1.657981659, 1.657869522, 1.657759285, 1.657650899, 1.657544319, 1.657439499, 1.657336397, 1.65723497, 1.657135178, 1.657036982, 1.656940344, 1.656845226, 1.656751594, 1.656659413, 1.656568649, 1.65647927, 1.656391244, 1.656304542, 1.656219133, 1.656134988, 1.65605208, 1.655970382, 1.655889868, 1.655810511, 1.655732287, 1.655655173, 1.655579143, 1.655504177, 1.655430251, 1.655357345, 1.655285437, 1.655214506, 1.655144534, 1.6550755, 1.655007387, 1.654940175, 1.654873847, 1.654808385, 1.654743774, 1.654679996, 1.654617035, 1.654554875, 1.654493503, 1.654432901, 1.654373057, 1.654313957, 1.654255585, 1.654197929, 1.654140976, 1.654084713, 1.654029128, 1.653974208, 1.653919942, 1.653866317, 1.653813324, 1.653760949, 1.653709184, 1.653658017, 1.653607437, 1.653557435, 1.653508002, 1.653459126, 1.6534108, 1.653363013, 1.653315758, 1.653269024, 1.653222803, 1.653177088, 1.653131869, 1.653087138, 1.653042889, 1.652999113, 1.652955802, 1.652912949, 1.652870547, 1.652828589, 1.652787068, 1.652745977, 1.65270531, 1.652665059, 1.652625219, 1.652585784, 1.652546746, 1.652508101, 1.652469842, 1.652431964, 1.65239446, 1.652357326, 1.652320556, 1.652284144, 1.652248086, 1.652212376, 1.652177009, 1.652141981, 1.652107286, 1.65207292, 1.652038878, 1.652005156, 1.651971748, 1.651938651, 1.651905861, 1.651873373, 1.651841182, 1.651809286, 1.651777679, 1.651746359, 1.65171532, 1.65168456, 1.651654074, 1.651623859, 1.651593912, 1.651564228, 1.651534805, 1.651505638, 1.651476725, 1.651448062, 1.651419647, 1.651391475, 1.651363544, 1.65133585, 1.651308391, 1.651281164, 1.651254165, 1.651227393, 1.651200843, 1.651174514, 1.651148402, 1.651122505, 1.65109682, 1.651071345, 1.651046077, 1.651021013, 1.650996152, 1.65097149, 1.650947025, 1.650922755, 1.650898678, 1.650874791, 1.650851092, 1.650827579};
+    // T_VALUES[df - 5] is the t quantile for df degrees of freedom. Multi-regressions sum the degrees of freedom
+    // over all members and can exceed the table, these use the last entry (the values converge towards 1.645)
+    inline float tQuantile(size_t df)
+    {
+        assert(df >= 5); // below the table, df - 5 would wrap around
+        constexpr size_t lastIdx = sizeof(T_VALUES) / sizeof(T_VALUES[0]) - 1;
+        return T_VALUES[std::min(df - 5, lastIdx)];
+    }
     static constexpr float CHI_SQUARES[256] = {3.84146, 5.99146, 7.81473, 9.48773, 11.0705, 12.59159, 14.06714, 15.50731, 16.91898, 18.30704, 19.67514, 21.02607, 22.36203, 23.68479, 24.99579, 26.29623, 27.58711, 28.8693, 30.14353, 31.41043, 32.67057, 33.92444, 35.17246, 36.41503, 37.65248, 38.88514, 40.11327, 41.33714, 42.55697, 43.77297, 44.98534, 46.19426, 47.39988, 48.60237, 49.80185, 50.99846, 52.19232, 53.38354, 54.57223, 55.75848, 56.94239, 58.12404, 59.30351, 60.48089, 61.65623, 62.82962, 64.00111, 65.17077, 66.33865, 67.50481, 68.66929, 69.83216, 70.99345, 72.15322, 73.31149, 74.46832, 75.62375, 76.7778, 77.93052, 79.08194, 80.2321, 81.38102, 82.52873, 83.67526, 84.82065, 85.96491, 87.10807, 88.25016, 89.39121, 90.53123, 91.67024, 92.80827, 93.94534, 95.08147, 96.21667, 97.35097, 98.48438, 99.61693, 100.74862, 101.87947, 103.00951, 104.13874, 105.26718, 106.39484, 107.52174, 108.64789, 109.77331, 110.898, 112.02199, 113.14527, 114.26787, 115.38979, 116.51105, 117.63165, 118.75161, 119.87094, 120.98964, 122.10773, 123.22522, 124.34211, 125.45842, 126.57415, 127.68931, 128.80391, 129.91796, 131.03146, 132.14442, 133.25686, 134.36878, 135.48018, 136.59107, 137.70146, 138.81136, 139.92077, 141.0297, 142.13816, 143.24615, 144.35367, 145.46074, 146.56736, 147.67353, 148.77926, 149.88456, 150.98943, 152.09388, 153.1979, 154.30152, 155.40472, 156.50752, 157.60992, 158.71193, 159.81355, 160.91478, 162.01563, 163.1161, 164.2162, 165.31593, 166.4153, 167.5143, 168.61295, 169.71125, 170.8092, 171.9068, 173.00406, 174.10098, 175.19757, 176.29382, 177.38975, 178.48535, 179.58063, 180.6756, 181.77025, 182.86458, 183.95861, 185.05233, 186.14575, 187.23887, 188.33169, 189.42422, 190.51646, 191.6084, 192.70007, 193.79144, 194.88254, 195.97336, 197.06391, 198.15418, 199.24418, 200.33391, 201.42337, 202.51258, 203.60152, 204.6902, 205.77863, 206.8668, 207.95472, 209.04239, 210.12981, 211.21698, 212.30391, 213.3906, 214.47705, 215.56326, 216.64924, 217.73498, 218.82049, 219.90577, 220.99082, 222.07565, 223.16025, 224.24462, 225.32878, 226.41272, 227.49644, 228.57994, 229.66323, 230.7463, 231.82917, 232.91182, 233.99427, 235.07651, 236.15855, 237.24038, 238.32201, 239.40344, 240.48467, 241.56571, 242.64654, 243.72719, 244.80764, 245.8879, 246.96797, 248.04784, 249.12754, 250.20704, 251.28636, 252.3655, 253.44445, 254.52322, 255.60182, 256.68023, 257.75847, 258.83653, 259.91441, 260.99212, 262.06966, 263.14702, 264.22422, 265.30124, 266.3781, 267.45479, 268.53131, 269.60767, 270.68387, 271.7599, 272.83577, 273.91148, 274.98703, 276.06242, 277.13765, 278.21272, 279.28764, 280.36241, 281.43702, 282.51148, 283.58578, 284.65994, 285.73394, 286.80779, 287.8815, 288.95506, 290.02847, 291.10174, 292.17486, 293.24784, 294.32067};
 
+    // CHI_SQUARES[df - 5] is used as the critical chi-square value for df degrees of freedom. Entry i of
+    // the table has i + 1 degrees of freedom. Beyond the table, the Wilson-Hilferty approximation is used.
+    inline float chiSquareQuantile(size_t df)
+    {
+        assert(df >= 5);
+        constexpr size_t tableSize = sizeof(CHI_SQUARES) / sizeof(CHI_SQUARES[0]);
+        if (df - 5 < tableSize)
+        {
+            return CHI_SQUARES[df - 5];
+        }
+        const double k = double(df - 4);
+        const double z = 1.6448536269514722; // normal quantile for alpha = 0.05
+        const double term = 1 - 2 / (9 * k) + z * std::sqrt(2 / (9 * k));
+        return k * term * term * term;
+    }
+
     static const double SQRTPI_2 = 0.886226925452758013649;
     extern bool PRINT_PPM_WARNING;
-    static const double OS_CRIT_A = 0.1443340625173891; // this value is determined empirically (see https://github.com/GeRe87/OS_critVal)
-    static const double OS_CRIT_B = 3.2412322699344687; // this value is determined empirically (see https://github.com/GeRe87/OS_critVal)
+    static constexpr double OS_CRIT_A = 0.1443340625173891; // this value is determined empirically (see https://github.com/GeRe87/OS_critVal)
+    static constexpr double OS_CRIT_B = 3.2412322699344687; // this value is determined empirically (see https://github.com/GeRe87/OS_critVal)
 
     // f-values precalculated using the qf() function in R with alpha = 0.05
     // given are the values for df1 = n - 1, df2 = n - 4.
@@ -4,13 +4,34 @@
 #include <vector>
 #include <filesystem>
 #include <string>
+#include <type_traits>
+#include <fstream>
+#include <charconv>
+#include <string_view>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <unordered_map>
 #include "qalgorithms_datatypes.h"
+#include "qalgorithms_eic_store.h"
+#include "qalgorithms_columnar.h"
 #include "qalgorithms_qpattern.h" // @todo remove this once MultiRegression is a global type
 
 namespace qAlgorithms
 {
 
 #pragma region "command line arguments"
+    // checkpoints are written after these stages, processing can be resumed from each of them
+    enum class CheckpointStage
+    {
+        none = 0,
+        centroids = 1,
+        bins = 2,
+        features = 3
+    };
+
     struct UserInputSettings
     {
         // user input for input and output
@@ -26,6 +47,8 @@ namespace qAlgorithms
         bool printFeatCens = false;
         bool printComponentRegs = false;
         bool printComponentBins = false;
+        bool printBinary = false; // write the columnar binary format (.qcol) instead of csv
+        bool printCompressed = false; // gzip all output files, ".gz" is appended to the file name
         // progress reporting
         bool silent = false;
         bool verboseProgress = false;
@@ -36,6 +59,16 @@ namespace qAlgorithms
         float newPPM = 0;               // @todo not a good idea
         bool tasklistSpecified = false; // @todo implement
         bool interactive = false;
+        // algorithm settings
+        bool incrementalBinning = false; // only repeat subsetting in mass regions that changed
+        bool onlineBinning = false;      // bin the centroids scan by scan
+        // checkpoints
+        bool writeCheckpoints = false;                      // write the result of every stage to the output directory
+        CheckpointStage resumeFrom = CheckpointStage::none; // skip all stages up to and including this one
+        bool useCache = false;                              // skip files whose results are already in the output directory
+        bool useSpectrumCache = false;                      // store the decoded spectra next to the input file
+        // memory use
+        std::string spillDirectory = ""; // if set, the bins are stored in a memory-mapped file in this directory
     };
 
     UserInputSettings passCliArgs(int argc, char *argv[]);
@@ -65,9 +98,214 @@ namespace qAlgorithms
 
     std::vector<std::filesystem::path> controlInput(const std::vector<std::string> *inputTasks, const bool skipError);
 
+    // increase this whenever a change alters the results, so results of older versions are not taken from the cache
+    constexpr unsigned int PIPELINE_VERSION = 2;
+
+    // identifies the content of a file independent of its name: the size, crc32 and adler32 of the file
+    std::string contentHash(const std::filesystem::path &path);
+
+    /// @brief persistent record of the input files that were already processed, stored in the output directory
+    /// @details every entry is keyed by the content hash of an input file and stores the pipeline version and
+    /// all settings that change the results, together with the size and modification time of every output file.
+    /// A file is only skipped if all of these match, so changed settings, a new version or a deleted or modified
+    /// output cause the file to be processed again.
+    class ResultCache
+    {
+    public:
+        // reads the cache of the output directory if one exists
+        ResultCache(const std::filesystem::path &pathOutput, const UserInputSettings *args);
+
+        // true if the results of the file were written with the current settings and are unchanged. The outputs
+        // are named after the input file, so a renamed file is not current
+        bool isCurrent(const std::string &hash, const std::string &stem) const;
+
+        // replace the entry of a file once all its outputs are written. If one of the outputs does not exist,
+        // the entry is removed instead so the file is processed again. Returns false in that case
+        bool record(const std::string &hash, const std::string &stem, const std::vector<std::filesystem::path> *outputs);
+
+        // the cache file is replaced completely, so it is always complete even if processing is interrupted later
+        bool save() const;
+
+    private:
+        struct OutputFile
+        {
+            std::string name; // relative to the output directory
+            uintmax_t size;
+            int64_t writeTime;
+        };
+        struct Entry
+        {
+            std::string settings;
+            std::string stem; // name of the input file without the extension
+            std::vector<OutputFile> outputs;
+        };
+
+        std::filesystem::path pathOutput;
+        std::filesystem::path pathCache;
+        std::string settings;
+        std::unordered_map<std::string, Entry> entries;
+    };
+
 #pragma endregion "file reading"
 
 #pragma region "print functions"
+    // one column of a table in the columnar binary format, the data is not copied
+    struct BinaryColumn
+    {
+        const char *name;
+        ColumnType type;
+        const void *data;
+        size_t count;
+    };
+
+    template <typename T>
+    BinaryColumn binaryColumn(const char *name, const std::vector<T> *values)
+    {
+        ColumnType type;
+        if constexpr (std::is_same_v<T, unsigned char> || std::is_same_v<T, bool>)
+        {
+            static_assert(!std::is_same_v<T, bool>, "std::vector<bool> is not contiguous, use unsigned char");
+            type = ColumnType::uint8;
+        }
+        else if constexpr (std::is_same_v<T, int>)
+        {
+            type = ColumnType::int32;
+        }
+        else if constexpr (std::is_same_v<T, unsigned int>)
+        {
+            type = ColumnType::uint32;
+        }
+        else if constexpr (std::is_same_v<T, uint64_t>)
+        {
+            type = ColumnType::uint64;
+        }
+        else if constexpr (std::is_same_v<T, float>)
+        {
+            type = ColumnType::float32;
+        }
+        else
+        {
+            static_assert(std::is_same_v<T, double>, "no column type exists for T");
+            type = ColumnType::float64;
+        }
+        return BinaryColumn{name, type, values->data(), values->size()};
+    }
+
+    /// @brief write a table in the columnar binary format described in qalgorithms_columnar.h
+    /// @details the header and the column directory are written first, then every column is written as one
+    /// contiguous block. No values are formatted, so writing is limited by the speed of the storage.
+    /// @param rowCount number of rows in the table. Columns may contain more values than rows, see qalgorithms_columnar.h
+    /// @param compress write a gzip-compressed file, see BufferedWriter
+    /// @return false if the file could not be written
+    bool writeColumnar(const std::filesystem::path &pathOutput, const std::vector<BinaryColumn> *columns, size_t rowCount,
+                       bool compress);
+
+    // floating point value that is written with a fixed number of decimals, same as "%0.<precision>f"
+    struct Fixed
+    {
+        double value;
+        int precision;
+    };
+
+    /// @brief write formatted csv rows to a file through a fixed-size buffer
+    /// @details values are formatted with std::to_chars directly into the buffer, which is written to the file
+    /// once it is almost full. Unlike building the table in a stringstream, the memory use does not depend
+    /// on the size of the table. The buffer is flushed when the writer is destroyed.
+    /// If compress is set, the output is a gzip stream. Every flushed block is split into chunks of GZIP_CHUNK
+    /// bytes which are compressed in parallel, each chunk is written as an independent gzip member. A file of
+    /// concatenated members is a valid gzip file (RFC 1952), it can be read by gunzip, zlib and R without changes.
+    /// The file must be opened in binary mode in this case. The chunks are compressed by as many threads as
+    /// omp_get_max_threads() returns on the thread that creates the writer, see AsyncWriter for the output thread.
+    class BufferedWriter
+    {
+    public:
+        static constexpr size_t GZIP_CHUNK = 1 << 18;
+
+        explicit BufferedWriter(std::ofstream *file, bool compress = false, size_t capacity = 1 << 16);
+        ~BufferedWriter();
+        BufferedWriter(const BufferedWriter &) = delete;
+        BufferedWriter &operator=(const BufferedWriter &) = delete;
+
+        // write the values separated by commas, followed by a newline
+        template <typename... Values>
+        void row(const Values &...values)
+        {
+            size_t idx = 0;
+            ((idx++ == 0 ? void() : put(','), field(values)), ...);
+            put('\n');
+        }
+
+        template <typename T>
+            requires std::is_integral_v<T>
+        void field(T value)
+        {
+            reserve(24);
+            used = std::to_chars(buffer.data() + used, buffer.data() + buffer.size(), value).ptr - buffer.data();
+        }
+        void field(Fixed value);
+        void field(std::string_view text);
+        void field(const char *text) { field(std::string_view(text)); }
+        void put(char c)
+        {
+            reserve(1);
+            buffer[used++] = c;
+        }
+
+        void flush();
+
+    private:
+        // flush if less than count bytes are free
+        void reserve(size_t count)
+        {
+            if (buffer.size() - used < count)
+            {
+                flush();
+            }
+        }
+
+        // write the data to the file, compressing it first if required
+        void writeOut(const char *data, size_t length);
+
+        std::ofstream *file;
+        bool compress;
+        int threads = 1; // size of the team that compresses the chunks
+        std::vector<char> buffer;
+        size_t used = 0;
+    };
+
+    /// @brief execute print jobs on a dedicated thread, so processing can continue while the results are written
+    /// @details a job must own all data it writes, the finished tables are moved into it. Jobs are executed in
+    /// the order in which they were submitted. If more than maxPending jobs are waiting, submit() blocks until
+    /// one is complete, which limits the memory held by the queue. The destructor waits for all jobs.
+    /// The jobs run while the main thread processes the next file with all cores. Parallel regions inside a job
+    /// (the gzip compression of BufferedWriter) are limited to `threads` threads so the CPU is not oversubscribed,
+    /// the default is a quarter of omp_get_max_threads().
+    class AsyncWriter
+    {
+    public:
+        explicit AsyncWriter(size_t maxPending = 16, int threads = 0);
+        ~AsyncWriter();
+        AsyncWriter(const AsyncWriter &) = delete;
+        AsyncWriter &operator=(const AsyncWriter &) = delete;
+
+        void submit(std::function<void()> job);
+
+        // block until all submitted jobs are complete
+        void finish();
+
+    private:
+        void run();
+
+        std::mutex lock;
+        std::condition_variable changed; // signals new jobs, completed jobs and shutdown
+        std::deque<std::function<void()>> queue;
+        size_t maxPending;
+        int threads;
+        bool busy = false; // a job was taken from the queue but is not complete yet
+        bool stop = false;
+        std::thread worker; // started last, after all other members are initialised
+    };
+
     struct ProfilePoint
     {
         float mz;
@@ -76,44 +314,88 @@ namespace qAlgorithms
         float intensity;
     };
 
+    // "<filename><table>.csv", the extension depends on the selected output format
+    std::filesystem::path outputFilePath(std::filesystem::path pathOutput, std::string filename, const char *table,
+                                         bool binary, bool compress);
+
     void printCentroids(const std::vector<CentroidPeak> *peaktable,
-                        std::vector<float> *convertRT,
+                        const std::vector<float> *convertRT,
                         std::filesystem::path pathOutput,
                         std::string filename,
-                        bool silent, bool skipError, bool noOverwrite);
+                        bool silent, bool skipError, bool noOverwrite, bool binary, bool compress);
 
     void printBins(const std::vector<qCentroid> *centroids,
-                   const std::vector<EIC> *bins,
+                   const EICStore *bins,
                    std::filesystem::path pathOutput,
                    std::string filename,
-                   bool silent, bool skipError, bool noOverwrite);
+                   bool silent, bool skipError, bool noOverwrite, bool binary, bool compress);
 
     void printFeatureList(const std::vector<FeaturePeak> *peaktable,
                           std::filesystem::path pathOutput,
                           std::string filename,
-                          const std::vector<EIC> *originalBins,
-                          bool verbose, bool silent, bool skipError, bool noOverwrite);
+                          const EICStore *originalBins,
+                          bool verbose, bool silent, bool skipError, bool noOverwrite, bool binary, bool compress);
 
     void printFeatureCentroids(const std::vector<FeaturePeak> *peaktable,
                                std::filesystem::path pathOutput,
                                std::string filename,
-                               const std::vector<EIC> *originalBins,
-                               bool verbose, bool silent, bool skipError, bool noOverwrite);
+                               const EICStore *originalBins,
+                               bool verbose, bool silent, bool skipError, bool noOverwrite, bool binary, bool compress);
 
     void printComponentRegressions(const std::vector<MultiRegression> *compRegs,
                                    std::filesystem::path pathOutput,
                                    std::string filename,
-                                   bool verbose, bool silent, bool skipError, bool noOverwrite);
+                                   bool verbose, bool silent, bool skipError, bool noOverwrite, bool binary, bool compress);
 
     void printComponentCentroids(const std::vector<MultiRegression> *compRegs,
-                                 const std::vector<EIC> *bins,
+                                 const EICStore *bins,
                                  std::filesystem::path pathOutput,
                                  std::string filename,
-                                 bool verbose, bool silent, bool skipError, bool noOverwrite);
+                                 bool verbose, bool silent, bool skipError, bool noOverwrite, bool binary, bool compress);
 
     void printLogfile(std::filesystem::path pathLogfile); // @todo
 
+    /// @brief write the componentisation statistics of all processed files as a JSON array
+    /// @details the file is rewritten completely after every processed file, so it is always valid JSON
+    /// @param stats the filename and the statistics of every processed file, in processing order
+    /// @param pathLogfile the statistics are written next to the log file, with the extension replaced by "_components.json"
+    void printComponentStats(const std::vector<std::pair<std::string, ComponentStats>> *stats,
+                             std::filesystem::path pathLogfile);
+
 #pragma endregion "print functions"
+
+#pragma region "checkpoints"
+    // everything later stages need from centroiding, the mzML file does not have to be read again
+    struct CentroidState
+    {
+        size_t spectrumCount = 0;
+        size_t centroidCount = 0; // number of centroids before binning
+        float diff_rt = 0;
+        float minCenArea = 0; // lowest centroid area, used as baseline during componentisation
+        std::vector<float> convertRT;
+        std::vector<qCentroid> centroids; // input of the binning, the first centroid is a dummy value
+    };
+
+    // "<filename>_<stage>.qchk" in the output directory
+    std::filesystem::path checkpointPath(std::filesystem::path pathOutput, std::string filename, CheckpointStage stage);
+
+    /// @brief save the result of one processing stage, so processing can be resumed from it with -resume
+    /// @details checkpoints store the structs in their in-memory layout. They are meant for repeating the later
+    /// stages with the same build and cannot be exchanged between different versions or platforms. The file is
+    /// written under a temporary name and renamed once it is complete, so an interrupted run does not leave
+    /// a damaged checkpoint behind.
+    /// @return false if the checkpoint could not be written
+    bool writeCheckpoint(const std::filesystem::path &pathOutput, const CentroidState *state);
+    bool writeCheckpoint(const std::filesystem::path &pathOutput, const EICStore *bins);
+    bool writeCheckpoint(const std::filesystem::path &pathOutput, const std::vector<FeaturePeak> *features);
+
+    // the read functions print an error and return false if the file is not a valid checkpoint of this build
+    bool readCheckpoint(const std::filesystem::path &pathInput, CentroidState *state);
+    // the arena of the bins is placed in spillDirectory if it is not empty, see EICStore
+    bool readCheckpoint(const std::filesystem::path &pathInput, const std::filesystem::path &spillDirectory, EICStore *bins);
+    bool readCheckpoint(const std::filesystem::path &pathInput, std::vector<FeaturePeak> *features);
+
+#pragma endregion "checkpoints"
 }
 
 #endif
\ No newline at end of file
@@ -2,10 +2,14 @@
 #define QALGORITHMS_MEASUREMENT_DATA_H
 
 #include "qalgorithms_datatypes.h"
+#include "qalgorithms_eic_store.h"
+#include "qalgorithms_spectrum_cache.h"
 #include "../external/StreamCraft/src/StreamCraft_mzml.hpp"
 
 #include <vector>
 #include <array>
+#include <functional>
+#include <span>
 
 namespace qAlgorithms
 {
@@ -18,32 +22,45 @@ namespace qAlgorithms
         const int start_index,
         double PPMerror);
 
-    double calcExpectedDiff(const std::vector<std::vector<double>> *spectrum);
+    double calcExpectedDiff(const SpectrumArrays spectrum);
 
     /**
      * @brief Inter/extrapolate gaps in data and define separation markers for data blocks.
      * @param dataPoints : {x, y, df, DQSC, DQSB, scanNumber}
      * @return std::vector<std::vector<dataPoint>::iterator> : separation markers for data blocks
      */
-    treatedData pretreatEIC(EIC &dataPoints,
+    treatedData pretreatEIC(const BinView *eic,
                             // std::vector<unsigned int> &binIdx,
                             float expectedDifference,
                             size_t maxScan);
 
-    std::vector<ProfileBlock> pretreatDataCentroids(const std::vector<std::vector<double>> *spectrum, float expectedDifference);
+    std::vector<ProfileBlock> pretreatDataCentroids(const SpectrumArrays spectrum, float expectedDifference);
 
     void extrapolateEIC(const std::vector<size_t> scanNums, std::vector<float> *intensity);
 
     inline float calcRTDiff(const std::vector<double> *retention_times);
 
+    // receives the centroids of one spectrum as soon as it was processed, in the order of the scans
+    using ScanCallback = std::function<void(std::span<const CentroidPeak>)>;
+
     std::vector<CentroidPeak> findCentroids_MZML(
         StreamCraft::MZML &data,
         std::vector<float> &convertRT,
         float &rt_diff,
         const bool polarity,
-        const bool ms1only = true);
+        const bool ms1only = true,
+        const ScanCallback &scanFinished = nullptr);
+
+    // same as findCentroids_MZML, but the spectra are read from the spectrum cache of the file
+    std::vector<CentroidPeak> findCentroids_cache(
+        const SpectrumCache *cache,
+        std::vector<float> &convertRT,
+        float &rt_diff,
+        const bool polarity,
+        const bool ms1only = true,
+        const ScanCallback &scanFinished = nullptr);
 
-    std::vector<FeaturePeak> findPeaks_QBIN(std::vector<EIC> &data, float rt_diff, size_t maxScan);
+    std::vector<FeaturePeak> findPeaks_QBIN(const EICStore *bins, float rt_diff, size_t maxScan);
 }
 
 #endif
\ No newline at end of file
@@ -3,6 +3,9 @@
 
 #include <vector>
 #include <string>
+#include <deque>
+#include <map>
+#include <span>
 
 #include "qalgorithms_datatypes.h"
 
@@ -10,13 +13,23 @@ namespace qAlgorithms
 {
     // ####################################################################################################### //
 
+    struct BinningStats
+    {
+        size_t iterations = 0;                  // number of subsetting passes until the bin count was stable
+        std::vector<size_t> pointsPerIteration; // number of centroids that were subset during every pass
+    };
+
     /// @brief wrapper function to execute qbinning on a std::vector<qCentroid> struct
     /// @param centroidedData centroid vector generated by qPeaks.passToBinning(...), defined in qalgorithms_qpeaks.cpp
     /// @param convertRT vector containing the retention time for every scan number
+    /// @param incremental if this option is selected, only unbinned points close to a mass region that changed
+    /// during the previous iteration are subset again. Otherwise, all unbinned points are subset in every iteration.
+    /// @param stats iteration count and number of processed points per iteration are written to this
     /// @param verbose if this option is selected, additional progress report is written to standard out
     /// @return returns the centroids as a collection of vectors
     std::vector<EIC> performQbinning(const std::vector<qCentroid> *centroidedData,
-                                     const std::vector<float> *convertRT, bool verbose);
+                                     const std::vector<float> *convertRT,
+                                     bool incremental, BinningStats *stats, bool verbose);
 
     // ###################################################################################################### //
 #pragma region "utility"
@@ -125,14 +138,97 @@ namespace qAlgorithms
 
     std::string subsetBins(BinContainer &bincontainer);
 
+    /// @brief subset all bins in processBinsF until the number of final bins no longer changes
+    /// @details after every pass, bins with duplicate scans are deduplicated and subset again. All unbinned
+    /// points (or only those close to a changed region in incremental mode) are added as a new bin. Once
+    /// the loop terminates, all points that were not assigned to a final bin are in notInBins.
+    /// @param idCount one past the largest cenID of all centroids in the container
+    /// @return log of the bin counts during subsetting
+    std::string repeatBinning(BinContainer &activeBins, bool incremental, size_t idCount, BinningStats *stats);
+
+    // calculate the DQSB of all final bins against notInBins and convert them to EICs
+    std::vector<EIC> finaliseBins(BinContainer &activeBins, const std::vector<float> *convertRT);
+
+    // copy the DQSB of every point into the EIC, DQSB must be in the order of the points in the EIC
+    void writeDQSB(EIC *eic, const std::vector<float> *DQSB);
+
     int selectRebin(BinContainer *bins, const std::vector<qCentroid> *rawdata);
 
+    /// @brief move all unbinned points close to a changed mass region into new bins so they are subset again
+    /// @details notInBins is sorted by mz and divided at every gap that exceeds the critical value for a bin
+    /// of five points. Such gaps can (almost) never exist within a bin, so every resulting region can be subset
+    /// independently of its neighbours. Regions that overlap a dirty interval and contain at least five points
+    /// are added to processBinsF, all other points remain in notInBins.
+    /// @param dirtyRegions mz intervals that changed during the previous iteration, is sorted by this function
+    /// @return number of points that were moved into processBinsF
+    size_t collectDirtyRegions(BinContainer &bincontainer, std::vector<std::pair<double, double>> &dirtyRegions);
+
     // remove points with duplicate scans from a bin by choosing the one closest to the median
     void deduplicateBin(std::vector<Bin> *target, std::vector<const qCentroid *> *notInBins, Bin bin);
 
     void removeMassJumps(std::vector<Bin> *target, std::vector<const qCentroid *> *notInBins, Bin bin);
 
 #pragma endregion "Bin Container"
+
+#pragma region "online binning"
+
+    /// @brief binning engine that receives the centroids scan by scan, for example while centroiding is still in progress
+    /// @details centroids are sorted into open mass traces, which are kept in a map ordered by their mean mz. A centroid
+    /// is added to the closest trace if it is within ten times the critical value of a five-point bin, otherwise it starts a
+    /// new trace. The tolerance is generous since the reported centroid error often underestimates the scatter within
+    /// a bin. A trace that contains more than one bin is separated during subsetting, a split bin cannot be recovered.
+    /// Once no centroid was added to a trace for more than maxdist scans, it can no longer be extended by a valid bin
+    /// and is closed. Closed traces are subset with the regular qBinning loop (repeatBinning), so all bins pass the same
+    /// validity checks as during performQbinning. The bins of a closed trace are converted to EICs right away and the
+    /// centroids of the trace are released, only the unbinned points are kept. These are binned once more when finish()
+    /// is called, since they can form bins across trace borders. The DQSB of all bins is calculated against the points
+    /// that remain unbinned after that step.
+    /// The results can differ from performQbinning, since the traces replace the first mass-based subsetting step.
+    class OnlineBinner
+    {
+    public:
+        /// @param convertRT retention time of every scan, must be complete before the first trace is closed
+        OnlineBinner(const std::vector<float> *convertRT, bool incremental);
+
+        /// @brief add all centroids of one scan to the open traces and close all traces that can no longer be extended
+        /// @param centroids all centroids of the scan, they are copied into the traces
+        void addScan(std::span<const qCentroid> centroids);
+
+        /// @brief close all open traces, bin the points that were not binned within their trace and create the EICs
+        /// @param stats the statistics of the final binning step over all unbinned points are written to this
+        std::vector<EIC> finish(BinningStats *stats);
+
+        size_t closedTraceCount = 0;
+
+    private:
+        struct Trace
+        {
+            std::vector<qCentroid> points;
+            double mzSum = 0;
+            unsigned int lastScan = 0;
+        };
+
+        // bin of a closed trace, the DQSB of the EIC is only set in finish()
+        struct ClosedBin
+        {
+            EIC eic;
+            std::vector<double> mz; // the EIC only contains the mz as float, the DQSB is calculated with full precision
+            float mzMin;
+            float mzMax;
+        };
+
+        void closeTrace(Trace &trace);
+
+        const std::vector<float> *convertRT;
+        bool incremental;
+        std::multimap<double, Trace> openTraces;
+        std::vector<ClosedBin> closedBins;
+        std::deque<qCentroid> unbinned; // centroids must remain at the same address until finish() is called
+        unsigned int currentScan = 0;
+        size_t idCount = 0;
+    };
+
+#pragma endregion "online binning"
 }
 
 #endif
\ No newline at end of file
@@ -2,16 +2,56 @@
 #define _QALGORITHMS_QPATTERN_INCLUDED
 
 #include "qalgorithms_datatypes.h"
+#include "qalgorithms_eic_store.h"
 
 #include <vector>
+#include <span>
+#include <cassert>
 
 namespace qAlgorithms
 {
+    // number of b0 coefficients that are stored without a heap allocation
+    constexpr size_t B0_INLINE = 8;
+
+    /// @brief one b0 coefficient per member of a component
+    /// @details almost all components consist of very few features, so the first B0_INLINE values are
+    /// stored inside the struct. Components with more members spill over into a vector, there is no upper limit.
+    class B0Coeffs
+    {
+    public:
+        B0Coeffs() = default;
+        explicit B0Coeffs(size_t count) { resize(count); }
+
+        void resize(size_t count)
+        {
+            numCoeffs = count;
+            spill.resize(count > B0_INLINE ? count - B0_INLINE : 0);
+        }
+
+        size_t size() const { return numCoeffs; }
+
+        float &operator[](size_t idx)
+        {
+            assert(idx < numCoeffs);
+            return idx < B0_INLINE ? local[idx] : spill[idx - B0_INLINE];
+        }
+
+        const float &operator[](size_t idx) const
+        {
+            assert(idx < numCoeffs);
+            return idx < B0_INLINE ? local[idx] : spill[idx - B0_INLINE];
+        }
+
+    private:
+        float local[B0_INLINE] = {0};
+        std::vector<float> spill;
+        size_t numCoeffs = 0;
+    };
+
     struct MultiRegression // @todo this will need to contain all the uncertainties of the original features and find a better solution to the whole bin window output
     {
-        float b0_vec[32];
+        B0Coeffs b0_vec;
         std::vector<float> cum_RSS; // one element per scan of the subgroup @todo this should is limited by 2*maxscale + 1
-        // std::vector<float> b0_vec;
         // all indices relate to the full subgroup!
         size_t idxStart;
         size_t idxEnd;
@@ -27,20 +67,55 @@ namespace qAlgorithms
         float DQS;
     };
 
+    struct ComponentStats
+    {
+        // pre-grouping
+        std::vector<size_t> preGroupSizes; // entry i is the number of pre-groups with i members
+        size_t valleys_single = 0;         // features with a valley point that are the only member of their pre-group
+        size_t valleys_other = 0;          // features with a valley point in larger pre-groups
+        size_t invalidFeatures = 0;        // features whose apex is at the border of the feature, they are not componentised
+        // pair comparison
+        size_t pairsEnumerated = 0;       // all pairs of features within the same pre-group
+        size_t pairsRejectedRT = 0;       // pairs that were excluded by their retention time before the regression
+        size_t pairRegressionsFailed = 0; // no valid multi-regression exists for the pair
+        size_t pairsValid = 0;            // pairs that can form a component by themselves
+        // component assignment
+        size_t regressionsFitted = 0; // all multi-regressions, including those of the pairs
+        size_t growAccepted = 0;      // a single feature was added to a component
+        size_t growRejected = 0;
+        size_t mergesAccepted = 0; // two components were combined
+        size_t mergesRejected = 0;
+        size_t identicalComponents = 0; // components whose EICs are identical, see tanimotoScore
+        // results
+        size_t components = 0;
+        size_t featuresInComponents = 0;
+        // time per phase in seconds. The per-group phases run in parallel, so they are summed over
+        // all threads and can exceed the wall time of the componentisation
+        double time_preGroup = 0;   // partition the features into pre-groups
+        double time_harmonise = 0;  // per group: create the shared EIC matrix
+        double time_pairs = 0;      // per group: regressions over all candidate pairs
+        double time_assign = 0;     // per group: grow and merge components, calculate their DQS
+        double time_collect = 0;    // assign the global component IDs
+        double time_wall = 0;       // total time spent in findComponents
+    };
+
+    // add the counters and per-group times of source to target
+    void addStats(ComponentStats *target, const ComponentStats *source);
+
     // main function to execute a componentiation step on data
     std::vector<MultiRegression> findComponents(
         // note: both features and bins contain a "componentID" field that is 0 by default.
         // the componentisation function updates these fields in addition to returning the component regressions
         std::vector<FeaturePeak> *features,
-        std::vector<EIC> *bins,
+        EICStore *bins,
         const std::vector<float> *convertRT, // this is needed to perform interpolation at the same RT as in qPeaks
         float lowestArea,
-        size_t *featuresInComponents);
+        ComponentStats *stats); // is reset at the start of every call
 
     struct PreGrouping
     {
         std::vector<FeaturePeak *> features; // this reference is used to modify the original feature
-        std::vector<EIC *> EICs;             // update component ID in bin
+        std::vector<BinView> EICs;           // bin of every feature, same order as features
 
         // add a sample ID thing here eventually
     };
@@ -51,18 +126,43 @@ namespace qAlgorithms
         size_t end;
     };
 
+    struct GroupComponents
+    {
+        std::vector<MultiRegression> regressions; // one regression per valid component of the pre-group
+        std::vector<PreGrouping> members;         // features and EICs of every component, same order as regressions
+        ComponentStats stats; // only the counters and per-group times are set
+    };
+
+    /// @brief perform the componentisation for a single pre-group
+    /// @details no shared state is modified by this function, so multiple pre-groups can be processed in parallel.
+    /// The component IDs of features and bins are not updated, since they are only known once all groups are complete.
+    GroupComponents componentiseGroup(std::vector<FeaturePeak> *peaks,
+                                      const EICStore *bins,
+                                      const std::vector<float> *convertRT,
+                                      const GroupLims limits);
+
     struct RSS_pair
     {
         MultiRegression regression;
         std::vector<float> cumRSS;
-        size_t idx_S;          // relates to half matrix
-        size_t idx_L;          // relates to half matrix
+        size_t idx_S;          // smaller index of the two features in the pre-group
+        size_t idx_L;          // larger index of the two features in the pre-group
         unsigned int idxStart; // relates to harmonised EIC space
         unsigned int idxEnd;   // relates to harmonised EIC space
         float RSS;             // residual sum of squares
         int component = -1;    // no pair is assigned by default
     };
 
+    // prefix sums over the log intensity y of one or more harmonised EICs, x is the index on the scan axis of the
+    // pre-group. Element i is the sum over [0, i), so the product sums xT * y of the multi-regression can be
+    // calculated for every window in constant time. The sums of multiple EICs are the element-wise sum of their prefix sums.
+    struct ProductSums
+    {
+        std::vector<double> y;
+        std::vector<double> xy;
+        std::vector<double> xxy;
+    };
+
     struct CompAssignment
     {
         MultiRegression regression;
@@ -71,21 +171,35 @@ namespace qAlgorithms
         unsigned int limit_R;  // refers to harmonised EIC space
         unsigned int numPeaks; // number of peaks included in this component
         float RSS = INFINITY;
-        int component = -1; // -1 means unassigned, groups start at 0
+        int component = -1;      // -1 means unassigned, groups start at 0
+        ProductSums productSums; // combined prefix sums of all members, updated when the component grows
     };
 
     // pre-group the region relevant to componentisation based on retention time uncertainty
     std::vector<GroupLims> preGroup(const std::vector<FeaturePeak> *peaks);
 
-    struct ReducedEIC
+    /// @brief harmonised EICs of all features in a pre-group, stored as one row per feature
+    /// @details all rows share the scan axis from the smallest to the largest scan of the pre-group. The
+    /// values of feature i are found at [i * length, (i + 1) * length) in every vector.
+    struct EICMatrix
     {
-        // the reduced EIC only contains those centroids relevant for a feature (equivalent to featCens result file)
-        // points in the EIC are already interpolated using the origin feature
         std::vector<float> intensity;
         std::vector<float> intensity_log;
-        std::vector<unsigned int> scanNo;
-        std::vector<float> RSS_cum; // cumulative RSS - considers the entire possible block
-        std::vector<bool> df;       // @todo get rid of this somehow
+        std::vector<float> RSS_cum;    // cumulative RSS - considers the entire possible block
+        std::vector<unsigned char> df; // 1 if the point was measured, 0 if it was interpolated
+        std::vector<ProductSums> productSums; // one per row
+        size_t length = 0;
+    };
+
+    struct ReducedEIC
+    {
+        // the reduced EIC only contains those centroids relevant for a feature (equivalent to featCens result file)
+        // points in the EIC are already interpolated using the origin feature. All values are a row of the EICMatrix
+        // of the pre-group, the ReducedEIC must not outlive it
+        std::span<const float> intensity;
+        std::span<const float> intensity_log;
+        std::span<const float> RSS_cum; // cumulative RSS - considers the entire possible block
+        std::span<const unsigned char> df;
         // std::vector<int> DF_cum;    // cumulative degrees of freedom, @todo use this to ensure at least five points overlap
         unsigned int feature_ID;
         unsigned int bin_ID;
@@ -98,8 +212,12 @@ namespace qAlgorithms
         // if that region is to be valid. They are set to the fifth real point from every direction
         unsigned int minIncludedIndex;
         unsigned int maxIncludedIndex;
+        const ProductSums *productSums = nullptr; // prefix sums of this EIC, part of the EICMatrix
     };
 
+    // non-owning view on the harmonised EICs that are combined in one regression, sorted by retention time
+    using EICView = std::span<const ReducedEIC *const>;
+
     struct MergedEIC
     {
         // combined EICs have only one axis for RT / scans, but combine multiple intensity values. This means that the vectors now
@@ -117,33 +235,78 @@ namespace qAlgorithms
         unsigned int minScan;       // needed for one-axis position of regression at the end
     };
 
+    /// @brief create the harmonised EICs for all features of a pre-group
+    /// @details the matrix is allocated once for the whole pre-group and every feature is written into its row
+    /// by harmoniseEIC. The returned EICs are views on the matrix and are in the same order as pregroup->features.
+    /// @param matrix workspace that is resized to fit the pre-group
+    std::vector<ReducedEIC> harmoniseGroup(const PreGrouping *pregroup,
+                                           const unsigned int minScan,
+                                           const unsigned int maxScan,
+                                           EICMatrix *matrix);
+
+    // fill row "row" of the matrix with the interpolated EIC of the feature
     ReducedEIC harmoniseEIC(const FeaturePeak *feature,
-                            const EIC *bin,
-                            const std::vector<float> *RTs,
+                            const BinView *bin,
+                            const size_t row,
+                            EICMatrix *matrix,
                             const unsigned int minScan,
                             const unsigned int maxScan);
 
     // always calculate the RSS over the entire region of intensities. Since the regression is always
     // centered, only the index where x is 0 must be known in advance
-    std::vector<float> cumulativeRSS(const std::vector<float> *intensities,
+    std::vector<float> cumulativeRSS(std::span<const float> intensities,
                                      const RegCoeffs *coeff,
                                      size_t index_x0);
 
-    MergedEIC mergeEICs(const std::vector<ReducedEIC> *eics,
-                        const std::vector<size_t> *selection,
+    // collect pointers to all EICs referenced by selection, the order of selection is kept
+    std::vector<const ReducedEIC *> selectEICs(const std::vector<ReducedEIC> *eics,
+                                               const std::vector<size_t> *selection);
+
+    MergedEIC mergeEICs(const EICView eics,
                         size_t idxStart,
                         size_t idxEnd);
 
+    // the seven unique values of (xTx)^-1 for a multi-regression, see findCoefficients_multi for the layout
+    struct MultiInverse
+    {
+        double A1;
+        double A2;
+        double B;
+        double C;
+        double D;
+        double E;
+        double F;
+    };
+
+    // inverse values are precalculated for all scales and up to this many peaks
+    constexpr size_t MULTI_INV_PEAKS = 16;
+
+    /// @brief access the inverse matrix values of a multi-regression over numPeaks peaks
+    /// @details values for up to MULTI_INV_PEAKS are read from a table that is constructed at compile time,
+    /// for larger components they are calculated from the single-peak inverse.
+    MultiInverse multiInverse(size_t scale, size_t numPeaks);
+
+    ProductSums makeProductSums(std::span<const float> intensity_log);
+
+    // element-wise sum of the prefix sums of all parts
+    ProductSums combineSums(std::span<const ProductSums *const> parts);
+
+    /// @brief calculate the coefficients of all multi-regressions within a window of the pre-group
+    /// @param parts prefix sums which add up to the sums over all members, for example a component and a new member
+    /// @param eics members of the regression, their own prefix sums are used for the b0 coefficients
+    /// @param idxStart first index of the window on the scan axis of the pre-group
     std::vector<MultiRegression> findCoefficients_multi(
-        const std::vector<float> *intensity_log,
+        std::span<const ProductSums *const> parts,
+        const EICView eics,
+        const size_t idxStart,
         const unsigned int scale,      // maximum scale that will be checked. Should generally be limited by peakFrame
         const unsigned int numPeaks,   // only > 1 during componentisation (for now? @todo)
         const unsigned int peakFrame); // how many points are covered per peak? For single-peak data, this is the length of intensity_log
 
     MultiRegression runningRegression_multi(
         const MergedEIC *eic,
-        const std::vector<ReducedEIC> *eics,
-        const std::vector<size_t> *selection,
+        const EICView eics,
+        std::span<const ProductSums *const> parts,
         const size_t idxStart,
         const size_t idxEnd,
         const unsigned int numPeaks);
@@ -168,16 +331,15 @@ namespace qAlgorithms
                      size_t n_total,
                      size_t p_complex);
 
-    float simpleRSS(std::vector<float> *RSS_simple_cum,
-                    std::vector<float> *RSS_complex_cum_A,
-                    std::vector<float> *RSS_complex_cum_B,
+    float simpleRSS(std::span<const float> RSS_simple_cum,
+                    std::span<const float> RSS_complex_cum_A,
+                    std::span<const float> RSS_complex_cum_B,
                     size_t idxStart,
                     size_t idxEnd,
                     size_t peakCount,
                     size_t p_complex); // needed for the F-test, should be replaced by a better solution sometime
 
-    float tanimotoScore(const std::vector<ReducedEIC> *eics,
-                        const std::vector<size_t> *selection,
+    float tanimotoScore(const EICView eics,
                         size_t idxStart,
                         size_t idxEnd);
 }
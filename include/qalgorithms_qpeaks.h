@@ -9,6 +9,7 @@
 // external
 #include <vector>
 #include <array>
+#include <span>
 #include <immintrin.h> // AVX
 
 namespace qAlgorithms
@@ -25,6 +26,9 @@ namespace qAlgorithms
 
     const std::vector<qCentroid> passToBinning(const std::vector<CentroidPeak> *allPeaks);
 
+    // the centroid as it is used during binning, cenID is its position in the output of passToBinning
+    qCentroid binningCentroid(const CentroidPeak *peak, unsigned int cenID);
+
     void runningRegression(
         const std::vector<float> *intensities,
         const std::vector<float> *ylog_start,
@@ -238,8 +242,8 @@ namespace qAlgorithms
                                     size_t left_limit,
                                     size_t right_limit);
 
-    MeanVar weightedMeanAndVariance_EIC(const std::vector<float> *weight,
-                                        const std::vector<float> *values,
+    MeanVar weightedMeanAndVariance_EIC(std::span<const float> weight,
+                                        std::span<const float> values,
                                         size_t left_limit,
                                         size_t right_limit);
 
@@ -0,0 +1,84 @@
+#ifndef QALGORITHMS_SPECTRUM_CACHE_H
+#define QALGORITHMS_SPECTRUM_CACHE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
+#include "qalgorithms_datatypes.h"
+#include "../external/StreamCraft/src/StreamCraft_mzml.hpp"
+
+// binary copy of the decoded spectra of one mzML file (.qcache), stored next to the file. It is written the first
+// time a file is processed with -spectrum-cache and replaces parsing the mzML in all later runs, as long as the
+// content hash of the mzML matches the one recorded in the cache. The layout is that of the structs below,
+// so the cache is only valid for the same platform:
+//  | SpectrumCacheHeader | SpectrumEntry * spectrumCount | m/z and intensity arrays of every MS1 spectrum ...
+// All arrays are plain doubles, the m/z values of a spectrum are directly followed by its intensities.
+
+namespace qAlgorithms
+{
+    constexpr char SPECTRUM_CACHE_MAGIC[8] = {'Q', 'A', 'L', 'G', 'S', 'P', 'C', '\0'};
+    constexpr uint32_t SPECTRUM_CACHE_VERSION = 1;
+    constexpr size_t SPECTRUM_CACHE_HASH_LENGTH = 64; // including the terminating zero
+
+    struct SpectrumCacheHeader
+    {
+        char magic[8];                                // SPECTRUM_CACHE_MAGIC
+        uint32_t version;                             // SPECTRUM_CACHE_VERSION
+        uint32_t reserved = 0;                        // always 0 for version 1
+        char sourceHash[SPECTRUM_CACHE_HASH_LENGTH];  // contentHash of the mzML
+        uint64_t spectrumCount;                       // number of SpectrumEntry that directly follow the header
+    };
+    static_assert(sizeof(SpectrumCacheHeader) == 88);
+
+    // metadata of one spectrum, in the order of the spectra in the mzML
+    struct SpectrumEntry
+    {
+        double retentionTime;
+        uint64_t index;      // index of the spectrum as reported by the mzML
+        uint64_t dataOffset; // position of the m/z array from the start of the file, 0 if the arrays are not stored
+        uint64_t pointCount; // number of values in the m/z and intensity array
+        int32_t level;       // MS level
+        uint8_t profile;     // 1 for profile mode, 0 for centroided spectra
+        uint8_t positive;    // 1 for positive polarity
+        uint8_t reserved[2] = {0, 0};
+    };
+    static_assert(sizeof(SpectrumEntry) == 40);
+
+    // the cache of "measurement.mzML" is "measurement.mzML.qcache"
+    std::filesystem::path spectrumCachePath(const std::filesystem::path &pathSource);
+
+    /// @brief decode all MS1 spectra of the file and write them to pathCache
+    /// @details the file is written under a temporary name and renamed once it is complete
+    /// @return false if the cache could not be written
+    bool writeSpectrumCache(StreamCraft::MZML *data, const std::filesystem::path &pathCache, const std::string &sourceHash);
+
+    /// @brief read-only view on a spectrum cache
+    /// @details the file is memory-mapped where possible, so the spectra are accessed without copying them.
+    /// If the file does not exist, is damaged or was created from a different version of the mzML, valid() is false.
+    class SpectrumCache
+    {
+    public:
+        SpectrumCache(const std::filesystem::path &pathCache, const std::string &sourceHash);
+        ~SpectrumCache();
+        SpectrumCache(const SpectrumCache &) = delete;
+        SpectrumCache &operator=(const SpectrumCache &) = delete;
+
+        bool valid() const { return data != nullptr; }
+        std::span<const SpectrumEntry> spectra() const;
+        // the arrays are empty if only the metadata of the spectrum was stored
+        SpectrumArrays spectrum(size_t position) const;
+
+    private:
+        void release();
+
+        const char *data = nullptr;
+        size_t size = 0;
+        bool mapped = false;
+        std::vector<char> buffer; // only used if the file could not be mapped
+    };
+}
+
+#endif
@@ -0,0 +1,153 @@
+#include "qalgorithms_eic_store.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#ifndef _WIN32
+#include <stdlib.h> // mkstemp
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace qAlgorithms
+{
+    EICStore::EICStore(std::vector<EIC> *bins, const std::filesystem::path &spillDirectory)
+    {
+        layouts.reserve(bins->size());
+        for (const EIC &bin : *bins)
+        {
+            layouts.push_back(bin.layout);
+        }
+        allocate(spillDirectory);
+
+        for (size_t binID = 0; binID < bins->size(); binID++)
+        {
+            EIC *bin = &bins->at(binID);
+            // the EIC has the same layout as the block, so it is copied as a whole
+            memcpy(data + offsets[binID], bin->buffer.get(), layouts[binID].bytes());
+            setBinInfo(binID, bin->componentID, bin->interpolations);
+            // the bin is released right away so the memory use does not double while the arena is filled
+            *bin = EIC{};
+        }
+        bins->clear();
+        bins->shrink_to_fit();
+    }
+
+    EICStore::EICStore(std::vector<EICLayout> binLayouts, const std::filesystem::path &spillDirectory)
+        : layouts(std::move(binLayouts))
+    {
+        allocate(spillDirectory);
+    }
+
+    EICStore::~EICStore()
+    {
+        release();
+    }
+
+    EICStore::EICStore(EICStore &&other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    EICStore &EICStore::operator=(EICStore &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            layouts = std::move(other.layouts);
+            offsets = std::move(other.offsets);
+            componentIDs = std::move(other.componentIDs);
+            interpolations = std::move(other.interpolations);
+            data = other.data;
+            arenaSize = other.arenaSize;
+            mapped = other.mapped;
+            other.data = nullptr;
+            other.arenaSize = 0;
+            other.mapped = false;
+        }
+        return *this;
+    }
+
+    BinView EICStore::at(size_t binID) const
+    {
+        assert(binID < layouts.size());
+        return viewBlock(data + offsets[binID], layouts[binID], componentIDs[binID], interpolations[binID] != 0);
+    }
+
+    void EICStore::setBinInfo(size_t binID, size_t componentID, bool interpolated)
+    {
+        componentIDs[binID] = componentID;
+        interpolations[binID] = interpolated;
+    }
+
+    void EICStore::allocate(const std::filesystem::path &spillDirectory)
+    {
+        offsets.resize(layouts.size());
+        componentIDs.assign(layouts.size(), 0);
+        interpolations.assign(layouts.size(), 0);
+        arenaSize = 0;
+        for (size_t binID = 0; binID < layouts.size(); binID++)
+        {
+            offsets[binID] = arenaSize;
+            arenaSize += layouts[binID].bytes();
+        }
+        if (arenaSize == 0)
+        {
+            return;
+        }
+
+        if (!spillDirectory.empty())
+        {
+#ifndef _WIN32
+            std::string pathTemplate = (spillDirectory / "qAlgorithms_bins_XXXXXX").string();
+            int fd = mkstemp(pathTemplate.data());
+            if (fd != -1)
+            {
+                // the name is removed immediately, the file only exists until it is unmapped
+                unlink(pathTemplate.c_str());
+                if (ftruncate(fd, arenaSize) == 0)
+                {
+                    void *map = mmap(nullptr, arenaSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                    if (map != MAP_FAILED)
+                    {
+                        data = static_cast<std::byte *>(map);
+                        mapped = true;
+                    }
+                }
+                close(fd);
+            }
+            if (!mapped)
+            {
+                std::cerr << "Warning: could not create a temporary file in " << spillDirectory
+                          << ", the bins are kept in memory\n";
+            }
+#else
+            std::cerr << "Warning: spilling bins to disk is not supported on windows, the bins are kept in memory\n";
+#endif
+        }
+        if (!mapped)
+        {
+            data = new std::byte[arenaSize];
+        }
+        // all offsets are multiples of the alignment of size_t, which is the widest column type
+        assert(reinterpret_cast<uintptr_t>(data) % alignof(size_t) == 0);
+    }
+
+    void EICStore::release()
+    {
+#ifndef _WIN32
+        if (mapped)
+        {
+            munmap(data, arenaSize);
+            data = nullptr;
+        }
+#endif
+        delete[] data;
+        data = nullptr;
+        arenaSize = 0;
+        mapped = false;
+    }
+}
@@ -0,0 +1,8 @@
+#include "qalgorithms_global_vars.h"
+
+namespace qAlgorithms
+{
+    /// ### set global variables ###
+    float PPM_PRECENTROIDED = -INFINITY;         // -Infinity sets it to the default value if no user input changes it
+    float MZ_ABSOLUTE_PRECENTROIDED = -INFINITY; // see above
+}
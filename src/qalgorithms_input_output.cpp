@@ -6,6 +6,15 @@
 #include <algorithm> // remove duplicates from task list
 #include <assert.h>
 #include <cmath> // isnan()
+#include <bit>   // endianness of the binary output
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <tuple>
+#include <zlib.h> // compressed output
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "qalgorithms_datatypes.h"
 #include "qalgorithms_input_output.h"
@@ -52,6 +61,10 @@ namespace qAlgorithms
                                   "      -ppb, -printcomponentsB     Print all centroids that are part of components. Similar to -ppf, but considers the range of the\n"
                                   "                                  newly constructed regression for which centroids are relevant. Also prints the components themselves.\n"
                                   "      -pa, -printall:             Print all availvable resutlts. You will probably not need to do this.\n"
+                                  "      -pbin, -printbinary:        Write all selected outputs in the columnar binary format (.qcol) instead of csv.\n"
+                                  "                                  The columns are the same as in the csv files, see the README for the file layout.\n"
+                                  "      -gz, -compress:             Write all selected outputs gzip-compressed, \".gz\" is appended to the file names.\n"
+                                  "                                  The files can be read directly by R (read.csv) and other tools that support gzip.\n"
                                   "    Program behaviour:\n"
                                   //   "      -s, -silent:    do not print progress reports to standard out.\n" // @todo add an option for printing all process stats without timing and explanations for use with CLI toolchains
                                   //   "      -v, -verbose:   print a detailed progress report to standard out.\n"
@@ -59,9 +72,31 @@ namespace qAlgorithms
                                   "      -skip-error:    If processing fails, the program will not exit and instead start processing\n"
                                   "                      the next file in the tasklist.\n"
                                   "      -skipAhead <n>  Skip the first n entries in the tasklist when starting processing \n"
+                                  "      -incremental-binning: After the first binning pass, only repeat the binning in mass regions\n"
+                                  "                      that changed during the previous pass instead of for all unbinned centroids.\n"
+                                  "      -online-binning: Bin the centroids of every scan while centroiding is still running, by following\n"
+                                  "                      open mass traces. Traces are binned as soon as they cannot be extended\n"
+                                  "                      anymore. Results differ slightly from the default binning.\n"
+                                  "      -checkpoint:    Write the results of centroiding, binning and feature construction to the output\n"
+                                  "                      directory (<filename>_<stage>.qchk). Checkpoints can only be read by the same build.\n"
+                                  "      -resume <stage>: Continue processing from the checkpoints in the output directory instead of reading\n"
+                                  "                      the input files. <stage> is the last stage that is not repeated: centroids, bins or\n"
+                                  "                      features. The input files must still be specified, they determine which checkpoints\n"
+                                  "                      are read. Centroids cannot be printed when resuming.\n"
+                                  "      -cache:         Skip input files that were already processed with the same settings and whose\n"
+                                  "                      results in the output directory are unchanged. Files are recognised by their\n"
+                                  "                      content, the record is kept in qAlgorithms_cache.tsv in the output directory.\n"
+                                  "      -spectrum-cache: Store the decoded spectra of every input file in <file>.qcache next to\n"
+                                  "                      it. Later runs read the spectra from there instead of parsing the mzML again,\n"
+                                  "                      as long as the mzML was not changed. The spectra are stored uncompressed, so\n"
+                                  "                      the cache can be larger than the mzML.\n"
+                                  "      -spill <dir>:   Keep the bins in a memory-mapped temporary file in <dir> instead of in memory.\n"
+                                  "                      This allows processing measurements whose bins do not fit into memory, the file\n"
+                                  "                      is removed automatically. Not supported on windows.\n"
                                   "      -log:           This option will create a detailed log file in the program directory.\n"
                                   "                      It will provide an overview for every processed file which can help you find and\n"
-                                  "                      reason about anomalous behaviour in the results.";
+                                  "                      reason about anomalous behaviour in the results. Statistics of the\n"
+                                  "                      componentisation are written as JSON to a second file next to the log.";
     //   "                      A name can be supplied with a string following the argument. If this is not\n"
     //   "                      done by the user, the default log will be written or overwritten.\n"
     //   "    Analysis options:\n"
@@ -272,6 +307,14 @@ namespace qAlgorithms
                 args.printComponentRegs = true;
                 args.printComponentBins = true;
             }
+            else if ((argument == "-pbin") || (argument == "-printbinary"))
+            {
+                args.printBinary = true;
+            }
+            else if ((argument == "-gz") || (argument == "-compress"))
+            {
+                args.printCompressed = true;
+            }
             else if (argument == "-log")
             {
                 args.doLogging = true;
@@ -290,6 +333,63 @@ namespace qAlgorithms
                 std::cerr << "Warning: processing will ignore defective files.\n";
                 args.skipError = true;
             }
+            else if (argument == "-incremental-binning")
+            {
+                args.incrementalBinning = true;
+            }
+            else if (argument == "-online-binning")
+            {
+                args.onlineBinning = true;
+            }
+            else if (argument == "-checkpoint")
+            {
+                args.writeCheckpoints = true;
+            }
+            else if (argument == "-resume")
+            {
+                ++i;
+                if (i == argc)
+                {
+                    std::cerr << "Error: no stage to resume from specified.\n";
+                    return args;
+                }
+                std::string stage = argv[i];
+                if (stage == "centroids")
+                {
+                    args.resumeFrom = CheckpointStage::centroids;
+                }
+                else if (stage == "bins")
+                {
+                    args.resumeFrom = CheckpointStage::bins;
+                }
+                else if (stage == "features")
+                {
+                    args.resumeFrom = CheckpointStage::features;
+                }
+                else
+                {
+                    std::cerr << "Error: unknown stage \"" << stage << "\" for -resume, use centroids, bins or features.\n";
+                    exit(1);
+                }
+            }
+            else if (argument == "-cache")
+            {
+                args.useCache = true;
+            }
+            else if (argument == "-spectrum-cache")
+            {
+                args.useSpectrumCache = true;
+            }
+            else if (argument == "-spill")
+            {
+                ++i;
+                if (i == argc)
+                {
+                    std::cerr << "Error: no directory for -spill specified.\n";
+                    return args;
+                }
+                args.spillDirectory = argv[i];
+            }
             else if (argument == "-skipAhead")
             {
                 ++i;
@@ -355,24 +455,13 @@ namespace qAlgorithms
             }
         }
         std::cout << outputPath;
+        // designated initialisers, so that new fields in UserInputSettings cannot shift the values
         return UserInputSettings{
             // user input for input and output
-            std::vector<std::string>{inputPath},
-            outputPath,
-            false,
-            false,
-            false,
-            false, // true, // only print standard feature list @todo revert!
-            false,
-            false,
-            false,
-            false,
-            false,
-            false,
-            false,
-            0,
-            false,
-            true};
+            .inputPaths = std::vector<std::string>{inputPath},
+            .outputPath = outputPath,
+            // .printFeatures = true, // only print standard feature list @todo revert!
+            .noOverwrite = true};
     }
 
     bool inputsAreSensible(UserInputSettings &args)
@@ -463,6 +552,27 @@ namespace qAlgorithms
             std::cerr << "Warning: no output files will be written.\n";
         }
 
+        if ((args.writeCheckpoints || args.resumeFrom != CheckpointStage::none) && args.outputPath.empty())
+        {
+            std::cerr << "Error: checkpoints are stored in the output directory, but no output path was supplied.\n";
+            goodInputs = false;
+        }
+        if (args.useCache && args.outputPath.empty())
+        {
+            std::cerr << "Error: the result cache is stored in the output directory, but no output path was supplied.\n";
+            goodInputs = false;
+        }
+        if (!args.spillDirectory.empty() && !std::filesystem::is_directory(args.spillDirectory))
+        {
+            std::cerr << "Error: the spill directory " << args.spillDirectory << " does not exist.\n";
+            goodInputs = false;
+        }
+        if (args.resumeFrom != CheckpointStage::none && args.printCentroids)
+        {
+            std::cerr << "Warning: centroids are not part of the checkpoints and will not be printed.\n";
+            args.printCentroids = false;
+        }
+
         if (args.newPPM < 0)
         {
             std::cerr << "Error: invalid value for ppm error supplied.\n";
@@ -490,19 +600,111 @@ namespace qAlgorithms
 
 #pragma region "file reading"
 
+    // update the checksums with up to length bytes, starting at the current position of the file
+    static uintmax_t hashBlocks(std::ifstream *file, uintmax_t length, uLong *crc, uLong *adler)
+    {
+        std::vector<char> block(1 << 20);
+        uintmax_t total = 0;
+        while (*file && total < length)
+        {
+            file->read(block.data(), std::min<uintmax_t>(block.size(), length - total));
+            const std::streamsize count = file->gcount();
+            *crc = crc32(*crc, reinterpret_cast<const Bytef *>(block.data()), count);
+            *adler = adler32(*adler, reinterpret_cast<const Bytef *>(block.data()), count);
+            total += count;
+        }
+        return total;
+    }
+
+    static std::string formatHash(uintmax_t size, uLong crc, uLong adler)
+    {
+        char hash[64];
+        snprintf(hash, 64, "%ju-%08lx-%08lx", size, crc, adler);
+        return hash;
+    }
+
+    std::string contentHash(const std::filesystem::path &path)
+    {
+        std::ifstream file_in(path, std::ios::in | std::ios::binary);
+        uLong crc = crc32(0, Z_NULL, 0);
+        uLong adler = adler32(0, Z_NULL, 0);
+        const uintmax_t size = hashBlocks(&file_in, UINTMAX_MAX, &crc, &adler);
+        return formatHash(size, crc, adler);
+    }
+
+    // files are only compared completely if they are equal in these first and last bytes
+    constexpr uintmax_t DUPLICATE_EDGE = 4 << 20;
+
+    // hash of the first and last DUPLICATE_EDGE bytes, this is the content hash for files up to twice that size
+    static std::string edgeHash(const std::filesystem::path &path, uintmax_t size)
+    {
+        if (size <= 2 * DUPLICATE_EDGE)
+        {
+            return contentHash(path);
+        }
+        std::ifstream file_in(path, std::ios::in | std::ios::binary);
+        uLong crc = crc32(0, Z_NULL, 0);
+        uLong adler = adler32(0, Z_NULL, 0);
+        hashBlocks(&file_in, DUPLICATE_EDGE, &crc, &adler);
+        file_in.seekg(size - DUPLICATE_EDGE);
+        hashBlocks(&file_in, DUPLICATE_EDGE, &crc, &adler);
+        return "edge-" + formatHash(size, crc, adler);
+    }
+
+    struct TaskEntry
+    {
+        std::filesystem::path path;
+        uintmax_t filesize;
+        std::string hash = ""; // only set if another file has the same size
+    };
+
+    // search a directory and its subdirectories for files of the given type. Every subdirectory is searched
+    // by a separate task, so directories on slow (network) storage are listed concurrently
+    static void searchDirectory(const std::filesystem::path &directory, const std::string *filetype,
+                                std::vector<TaskEntry> *tasklist, std::mutex *tasklistLock)
+    {
+        namespace fs = std::filesystem;
+        std::error_code error;
+        fs::directory_iterator iterator(directory, fs::directory_options::skip_permission_denied, error);
+        for (; !error && iterator != fs::directory_iterator(); iterator.increment(error))
+        {
+            const fs::directory_entry &entry = *iterator;
+            std::error_code entryError; // a file that cannot be accessed is skipped, the search continues
+            // symbolic links to directories are not followed, same as for recursive_directory_iterator
+            if (entry.is_directory(entryError) && !entry.is_symlink(entryError))
+            {
+                // the task may run after this function returned, so it only holds copies
+                fs::path subdirectory = entry.path();
+#pragma omp task firstprivate(subdirectory, filetype, tasklist, tasklistLock)
+                searchDirectory(subdirectory, filetype, tasklist, tasklistLock);
+            }
+            else if (entry.path().extension() == *filetype)
+            {
+                TaskEntry task{fs::canonical(entry.path(), entryError), entry.file_size(entryError)};
+                if (!entryError)
+                {
+                    std::lock_guard<std::mutex> guard(*tasklistLock);
+                    tasklist->push_back(task);
+                }
+            }
+        }
+        if (error)
+        {
+            std::stringstream message;
+            message << "Warning: the directory " << directory << " could not be searched completely: " << error.message() << "\n";
+            std::cerr << message.str();
+        }
+    }
+
     std::vector<std::filesystem::path> controlInput(const std::vector<std::string> *inputTasks, const bool skipError)
     {
         const std::string filetype = ".mzML"; // @todo change this if other filetpes should be supported
         namespace fs = std::filesystem;
         std::vector<fs::path> outputTasks;
         outputTasks.reserve(inputTasks->size());
-        struct TaskEntry
-        {
-            fs::path path;
-            uintmax_t filesize;
-        };
         std::vector<TaskEntry> tasklist;
         tasklist.reserve(inputTasks->size());
+        std::mutex tasklistLock;
         // find all valid inputs and add them to the task list
         for (std::string inputPath : *inputTasks)
         {
@@ -533,92 +735,447 @@ namespace qAlgorithms
             else if (status.type() == fs::file_type::directory)
             {
                 // recursively search for relevant files
-                for (auto const &dir_entry : fs::recursive_directory_iterator(currentPath))
-                {
-                    fs::path recursivePath = fs::canonical(dir_entry);
-                    if (recursivePath.extension() == filetype)
-                    {
-                        tasklist.push_back(TaskEntry{recursivePath, fs::file_size(recursivePath)});
-                    }
-                }
+#pragma omp parallel
+#pragma omp single
+                searchDirectory(currentPath, &filetype, &tasklist, &tasklistLock);
             }
             else
             {
                 std::cerr << "Warning: \"" << inputPath << "\" is not a supported file or directory. The file has been skipped.\n";
             }
         }
-        // remove duplicate files
-        size_t tasknumber = tasklist.size();
-        unsigned int removedEntries = 0;
-        if (tasknumber == 0)
+        if (tasklist.empty())
         {
             std::cerr << "Error: no valid files selected.\n";
             exit(1);
         }
-        std::sort(tasklist.begin(), tasklist.end(), [](const TaskEntry lhs, const TaskEntry rhs)
-                  { return lhs.filesize < rhs.filesize; });
-        size_t prevsize = tasklist[0].filesize;
-        for (size_t i = 1; i < tasknumber; i++)
-        {
-            if (tasklist[i].filesize == prevsize)
-            {
-                const size_t readLength = 25000;
-                std::ifstream fileConflict;
-                char firstChars[readLength];
-                char secondChars[readLength];
-                fileConflict.open(tasklist[i - 1].path);
-                fileConflict.read(firstChars, readLength);
-                fileConflict.close();
 
-                fileConflict.open(tasklist[i].path);
-                fileConflict.read(secondChars, readLength);
-                fileConflict.close();
+        // remove duplicate files. Only files with the same size are hashed, and only files that are also
+        // equal at the start and end are read completely. The file that comes first by path is kept
+        auto bySizeAndHash = [](const TaskEntry &lhs, const TaskEntry &rhs)
+        {
+            return std::tie(lhs.filesize, lhs.hash, lhs.path) < std::tie(rhs.filesize, rhs.hash, rhs.path);
+        };
+        std::sort(tasklist.begin(), tasklist.end(), bySizeAndHash);
+        const size_t foundEntries = tasklist.size();
+        // the same file was found more than once, for example through an input file and its directory
+        tasklist.erase(std::unique(tasklist.begin(), tasklist.end(), [](const TaskEntry &lhs, const TaskEntry &rhs)
+                                   { return lhs.path == rhs.path; }),
+                       tasklist.end());
 
-                bool sameFiles = true;
-                for (size_t j = 0; j < readLength; j++)
-                {
-                    if (firstChars[j] != secondChars[j])
-                    {
-                        sameFiles = false;
-                        break;
-                    }
-                }
-                if (sameFiles)
+        // hashes the files for which the comparison function is true with a neighbour in the sorted task list
+        auto hashCandidates = [&tasklist](auto isCandidate, auto hashFunction)
+        {
+            std::vector<size_t> candidates;
+            for (size_t i = 0; i < tasklist.size(); i++)
+            {
+                if ((i > 0 && isCandidate(tasklist[i - 1], tasklist[i])) ||
+                    (i + 1 < tasklist.size() && isCandidate(tasklist[i], tasklist[i + 1])))
                 {
-                    tasklist[i - 1].filesize = 0; // always keeps last so comparison by file size works
-                    ++removedEntries;
+                    candidates.push_back(i);
                 }
             }
-            prevsize = tasklist[i].filesize;
-        }
+#pragma omp parallel for schedule(dynamic)
+            for (size_t i = 0; i < candidates.size(); i++)
+            {
+                TaskEntry *task = &tasklist[candidates[i]];
+                task->hash = hashFunction(task);
+            }
+        };
+        hashCandidates([](const TaskEntry &lhs, const TaskEntry &rhs)
+                       { return lhs.filesize == rhs.filesize; },
+                       [](const TaskEntry *task)
+                       { return edgeHash(task->path, task->filesize); });
+        std::sort(tasklist.begin(), tasklist.end(), bySizeAndHash);
+        hashCandidates([](const TaskEntry &lhs, const TaskEntry &rhs)
+                       { return lhs.filesize == rhs.filesize && lhs.hash == rhs.hash && lhs.filesize > 2 * DUPLICATE_EDGE; },
+                       [](const TaskEntry *task)
+                       { return contentHash(task->path); });
+        std::sort(tasklist.begin(), tasklist.end(), bySizeAndHash);
+        tasklist.erase(std::unique(tasklist.begin(), tasklist.end(), [](const TaskEntry &lhs, const TaskEntry &rhs)
+                                   { return !lhs.hash.empty() && lhs.filesize == rhs.filesize && lhs.hash == rhs.hash; }),
+                       tasklist.end());
+
+        const size_t removedEntries = foundEntries - tasklist.size();
         if (removedEntries > 0)
         {
             std::cerr << "Warning: removed " << removedEntries << " duplicate input files from processing queue.\n";
         }
         for (auto entry : tasklist)
         {
-            if (entry.filesize > 0)
-            {
-                outputTasks.push_back(entry.path);
-            }
+            outputTasks.push_back(entry.path);
         }
         // make polarity switching to two files
         return (outputTasks);
     }
 
+    ResultCache::ResultCache(const std::filesystem::path &pathOutput, const UserInputSettings *args)
+        : pathOutput(pathOutput), pathCache(pathOutput / "qAlgorithms_cache.tsv")
+    {
+        // every setting that changes the content or the names of the output files
+        std::stringstream key;
+        key << "v" << PIPELINE_VERSION << "-" << args->printCentroids << args->printBins << args->printExtended
+            << args->printFeatures << args->printFeatCens << args->printComponentRegs << args->printComponentBins
+            << args->printBinary << args->printCompressed << args->incrementalBinning << args->onlineBinning
+            << "-" << args->newPPM;
+        settings = key.str();
+
+        // one line per input file: hash, settings, input name, then name, size and write time of every output
+        std::ifstream file_in(pathCache);
+        std::string line;
+        while (std::getline(file_in, line))
+        {
+            if (line.empty() || line[0] == '#')
+            {
+                continue;
+            }
+            std::vector<std::string> fields;
+            std::stringstream lineStream(line);
+            std::string field;
+            while (std::getline(lineStream, field, '\t'))
+            {
+                fields.push_back(field);
+            }
+            if (fields.size() % 3 == 2)
+            {
+                continue; // written before the input name was stored, the file is processed again
+            }
+            if (fields.size() < 3 || fields.size() % 3 != 0)
+            {
+                std::cerr << "Warning: ignoring a damaged entry in " << pathCache << "\n";
+                continue;
+            }
+            Entry entry{fields[1], fields[2], {}};
+            try
+            {
+                for (size_t i = 3; i < fields.size(); i += 3)
+                {
+                    entry.outputs.push_back(OutputFile{fields[i], std::stoull(fields[i + 1]), std::stoll(fields[i + 2])});
+                }
+            }
+            catch (const std::exception &)
+            {
+                std::cerr << "Warning: ignoring a damaged entry in " << pathCache << "\n";
+                continue;
+            }
+            entries[fields[0]] = entry;
+        }
+    }
+
+    bool ResultCache::isCurrent(const std::string &hash, const std::string &stem) const
+    {
+        auto match = entries.find(hash);
+        if (match == entries.end() || match->second.settings != settings || match->second.stem != stem)
+        {
+            return false;
+        }
+        for (const OutputFile &output : match->second.outputs)
+        {
+            std::error_code error;
+            const std::filesystem::path path = pathOutput / output.name;
+            if (std::filesystem::file_size(path, error) != output.size || error ||
+                std::filesystem::last_write_time(path, error).time_since_epoch().count() != output.writeTime || error)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool ResultCache::record(const std::string &hash, const std::string &stem, const std::vector<std::filesystem::path> *outputs)
+    {
+        Entry entry{settings, stem, {}};
+        for (const std::filesystem::path &path : *outputs)
+        {
+            std::error_code sizeError, timeError;
+            const uintmax_t size = std::filesystem::file_size(path, sizeError);
+            const int64_t writeTime = std::filesystem::last_write_time(path, timeError).time_since_epoch().count();
+            if (sizeError || timeError)
+            {
+                // an output could not be written, the results of the file are incomplete
+                entries.erase(hash);
+                return false;
+            }
+            entry.outputs.push_back(OutputFile{path.filename().string(), size, writeTime});
+        }
+        entries[hash] = entry;
+        return true;
+    }
+
+    bool ResultCache::save() const
+    {
+        std::filesystem::path pathTemporary = pathCache;
+        pathTemporary += ".tmp";
+        std::ofstream file_out(pathTemporary, std::ios::out);
+        if (!file_out.is_open())
+        {
+            return false;
+        }
+        file_out << "# qAlgorithms result cache, delete this file to process all inputs again\n";
+        for (const auto &[hash, entry] : entries)
+        {
+            file_out << hash << "\t" << entry.settings << "\t" << entry.stem;
+            for (const OutputFile &output : entry.outputs)
+            {
+                file_out << "\t" << output.name << "\t" << output.size << "\t" << output.writeTime;
+            }
+            file_out << "\n";
+        }
+        file_out.close();
+
+        std::error_code error;
+        if (!file_out.fail())
+        {
+            std::filesystem::rename(pathTemporary, pathCache, error);
+        }
+        return !file_out.fail() && !error;
+    }
+
 #pragma endregion "file reading"
 
 #pragma region "print functions"
     // @todo use macros to move the boilderplate out of the function body
 
+    AsyncWriter::AsyncWriter(size_t maxPending, int threads)
+        : maxPending(std::max(maxPending, size_t(1))), threads(threads), worker(&AsyncWriter::run, this)
+    {
+    }
+
+    AsyncWriter::~AsyncWriter()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stop = true;
+        }
+        changed.notify_all();
+        worker.join(); // the worker only returns once the queue is empty
+    }
+
+    void AsyncWriter::submit(std::function<void()> job)
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        changed.wait(guard, [this]
+                     { return queue.size() < maxPending; });
+        queue.push_back(std::move(job));
+        guard.unlock();
+        changed.notify_all();
+    }
+
+    void AsyncWriter::finish()
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        changed.wait(guard, [this]
+                     { return queue.empty() && !busy; });
+    }
+
+    void AsyncWriter::run()
+    {
+#ifdef _OPENMP
+        // the number of threads is set per thread, this does not change the teams of the main thread
+        if (threads < 1)
+        {
+            threads = std::max(omp_get_max_threads() / 4, 1);
+        }
+        omp_set_num_threads(threads);
+#endif
+        std::unique_lock<std::mutex> guard(lock);
+        while (true)
+        {
+            changed.wait(guard, [this]
+                         { return !queue.empty() || stop; });
+            if (queue.empty())
+            {
+                return; // stop was requested and all jobs are complete
+            }
+            std::function<void()> job = std::move(queue.front());
+            queue.pop_front();
+            busy = true;
+            guard.unlock();
+            changed.notify_all(); // submit() might wait for free space
+
+            job();
+            job = nullptr; // release the tables before the next job starts
+
+            guard.lock();
+            busy = false;
+            changed.notify_all();
+        }
+    }
+
+    // the print functions can run on the output thread, so every message is written with a single call
+    static void announce(const char *what, const std::filesystem::path &pathOutput)
+    {
+        std::stringstream message;
+        message << "writing " << what << " to: " << pathOutput << "\n";
+        std::cout << message.str();
+    }
+
+    BufferedWriter::BufferedWriter(std::ofstream *file, bool compress, size_t capacity)
+        : file(file), compress(compress), buffer(std::max(capacity, size_t(1024)))
+    {
+        if (compress)
+        {
+            // every flush should provide one chunk for every thread
+#ifdef _OPENMP
+            threads = omp_get_max_threads();
+#endif
+            buffer.resize(std::max(buffer.size(), GZIP_CHUNK * threads));
+        }
+    }
+
+    BufferedWriter::~BufferedWriter()
+    {
+        flush();
+    }
+
+    void BufferedWriter::flush()
+    {
+        writeOut(buffer.data(), used);
+        used = 0;
+    }
+
+    // compress the data into a complete gzip member (header, deflate stream and trailer)
+    static std::vector<char> gzipMember(const char *data, size_t length)
+    {
+        z_stream stream{};
+        // windowBits + 16 writes a gzip header and trailer instead of the zlib format
+        int status = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY);
+        assert(status == Z_OK);
+        std::vector<char> member(deflateBound(&stream, length));
+        stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+        stream.avail_in = length;
+        stream.next_out = reinterpret_cast<Bytef *>(member.data());
+        stream.avail_out = member.size();
+        status = deflate(&stream, Z_FINISH);
+        assert(status == Z_STREAM_END);
+        member.resize(stream.total_out);
+        deflateEnd(&stream);
+        return member;
+    }
+
+    void BufferedWriter::writeOut(const char *data, size_t length)
+    {
+        if (!compress)
+        {
+            file->write(data, length);
+            return;
+        }
+        if (length == 0)
+        {
+            return;
+        }
+        // the chunks are compressed independently of each other, so the members can be created in parallel
+        const size_t chunkCount = (length + GZIP_CHUNK - 1) / GZIP_CHUNK;
+        std::vector<std::vector<char>> members(chunkCount);
+#pragma omp parallel for schedule(static, 1) num_threads(threads)
+        for (size_t i = 0; i < chunkCount; i++)
+        {
+            const size_t start = i * GZIP_CHUNK;
+            members[i] = gzipMember(data + start, std::min(GZIP_CHUNK, length - start));
+        }
+        for (const auto &member : members)
+        {
+            file->write(member.data(), member.size());
+        }
+    }
+
+    void BufferedWriter::field(Fixed value)
+    {
+        // the longest possible result is a double close to the maximum with all decimals
+        constexpr size_t maxLength = 3 + std::numeric_limits<double>::max_exponent10 + 1 + 17;
+        reserve(maxLength + value.precision);
+        auto result = std::to_chars(buffer.data() + used, buffer.data() + buffer.size(),
+                                    value.value, std::chars_format::fixed, value.precision);
+        assert(result.ec == std::errc());
+        used = result.ptr - buffer.data();
+    }
+
+    void BufferedWriter::field(std::string_view text)
+    {
+        if (text.size() > buffer.size() - used)
+        {
+            flush();
+            if (text.size() > buffer.size())
+            {
+                writeOut(text.data(), text.size());
+                return;
+            }
+        }
+        std::copy(text.begin(), text.end(), buffer.begin() + used);
+        used += text.size();
+    }
+
+    bool writeColumnar(const std::filesystem::path &pathOutput, const std::vector<BinaryColumn> *columns, size_t rowCount,
+                       bool compress)
+    {
+        static_assert(std::endian::native == std::endian::little, "the columnar format is little-endian");
+
+        ColumnarHeader header;
+        memcpy(header.magic, COLUMNAR_MAGIC, sizeof(header.magic));
+        header.version = COLUMNAR_VERSION;
+        header.columnCount = columns->size();
+        header.rowCount = rowCount;
+
+        // the position of every block is known before anything is written
+        auto aligned = [](size_t offset)
+        { return (offset + COLUMN_ALIGNMENT - 1) / COLUMN_ALIGNMENT * COLUMN_ALIGNMENT; };
+        std::vector<ColumnEntry> directory(columns->size());
+        size_t offset = aligned(sizeof(ColumnarHeader) + columns->size() * sizeof(ColumnEntry));
+        for (size_t i = 0; i < columns->size(); i++)
+        {
+            const BinaryColumn *column = &columns->at(i);
+            assert(strlen(column->name) < COLUMN_NAME_LENGTH);
+            memset(directory[i].name, 0, COLUMN_NAME_LENGTH);
+            strncpy(directory[i].name, column->name, COLUMN_NAME_LENGTH - 1);
+            directory[i].type = column->type;
+            directory[i].offset = offset;
+            directory[i].count = column->count;
+            offset = aligned(offset + column->count * columnTypeSize(column->type));
+        }
+
+        std::ofstream file_out(pathOutput, std::ios::out | std::ios::binary);
+        if (!file_out.is_open())
+        {
+            return false;
+        }
+        // large column blocks are passed through the writer without copying
+        BufferedWriter output(&file_out, compress);
+        const char padding[COLUMN_ALIGNMENT] = {0};
+        output.field(std::string_view(reinterpret_cast<const char *>(&header), sizeof(header)));
+        output.field(std::string_view(reinterpret_cast<const char *>(directory.data()), directory.size() * sizeof(ColumnEntry)));
+        size_t position = sizeof(header) + directory.size() * sizeof(ColumnEntry);
+        for (size_t i = 0; i < columns->size(); i++)
+        {
+            output.field(std::string_view(padding, directory[i].offset - position));
+            const size_t length = directory[i].count * columnTypeSize(directory[i].type);
+            output.field(std::string_view(static_cast<const char *>(columns->at(i).data), length));
+            position = directory[i].offset + length;
+        }
+        output.field(std::string_view(padding, aligned(position) - position));
+        output.flush();
+        file_out.close();
+        return !file_out.fail();
+    }
+
+    std::filesystem::path outputFilePath(std::filesystem::path pathOutput, std::string filename, const char *table,
+                                         bool binary, bool compress)
+    {
+        filename += table;
+        filename += binary ? ".qcol" : ".csv";
+        if (compress)
+        {
+            filename += ".gz";
+        }
+        return pathOutput / filename;
+    }
+
     void printCentroids(const std::vector<CentroidPeak> *peaktable,
-                        std::vector<float> *convertRT,
+                        const std::vector<float> *convertRT,
                         std::filesystem::path pathOutput,
                         std::string filename,
-                        bool silent, bool skipError, bool noOverwrite)
+                        bool silent, bool skipError, bool noOverwrite, bool binary, bool compress)
     {
-        filename += "_centroids.csv";
-        pathOutput /= filename;
+        pathOutput = outputFilePath(pathOutput, filename, "_centroids", binary, compress);
 
         if (std::filesystem::exists(pathOutput))
         {
@@ -631,46 +1188,83 @@ namespace qAlgorithms
         }
         if (!silent)
         {
-            std::cout << "writing centroids to: " << pathOutput << "\n";
+            announce("centroids", pathOutput);
+        }
+
+        if (binary)
+        {
+            const size_t length = peaktable->size();
+            std::vector<unsigned int> cenID(length), scanNumber(length), scale(length), df(length), interpolations(length), competitors(length);
+            std::vector<double> mz(length);
+            std::vector<float> mzUncertainty(length), retentionTime(length), area(length), areaUncertainty(length),
+                height(length), heightUncertainty(length), DQSC(length);
+            for (size_t j = 0; j < length; ++j)
+            {
+                const CentroidPeak *peak = &peaktable->at(j);
+                cenID[j] = j;
+                mz[j] = peak->mz;
+                mzUncertainty[j] = peak->mzUncertainty;
+                scanNumber[j] = peak->scanNumber;
+                retentionTime[j] = convertRT->at(peak->scanNumber);
+                area[j] = peak->area;
+                areaUncertainty[j] = peak->areaUncertainty;
+                height[j] = peak->height;
+                heightUncertainty[j] = peak->heightUncertainty;
+                scale[j] = peak->scale;
+                df[j] = peak->df;
+                DQSC[j] = peak->DQSC;
+                interpolations[j] = peak->interpolations;
+                competitors[j] = peak->numCompetitors;
+            }
+            const std::vector<BinaryColumn> columns = {
+                binaryColumn("cenID", &cenID), binaryColumn("mz", &mz), binaryColumn("mzUncertainty", &mzUncertainty),
+                binaryColumn("scanNumber", &scanNumber), binaryColumn("retentionTime", &retentionTime),
+                binaryColumn("area", &area), binaryColumn("areaUncertainty", &areaUncertainty),
+                binaryColumn("height", &height), binaryColumn("heightUncertainty", &heightUncertainty),
+                binaryColumn("scale", &scale), binaryColumn("degreesOfFreedom", &df), binaryColumn("DQSC", &DQSC),
+                binaryColumn("interpolations", &interpolations), binaryColumn("competitors", &competitors)};
+            if (!writeColumnar(pathOutput, &columns, length, compress))
+            {
+                std::cerr << "Error: could not write centroids to " << pathOutput << "\n";
+            }
+            return;
         }
 
         std::ofstream file_out;
-        std::stringstream output;
-        file_out.open(pathOutput, std::ios::out);
+        file_out.open(pathOutput, compress ? std::ios::out | std::ios::binary : std::ios::out);
         if (!file_out.is_open())
         {
             std::cerr << "Error: could not open output path during peaklist printing. No files have been written.\n"
                       << "Filename: " << pathOutput << "\n";
             return;
         }
-        output << "cenID,mz,mzUncertainty,scanNumber,retentionTime,area,areaUncertainty,"
-               << "height,heightUncertainty,scale,degreesOfFreedom,DQSC,interpolations,competitors\n";
+        BufferedWriter output(&file_out, compress);
+        output.field("cenID,mz,mzUncertainty,scanNumber,retentionTime,area,areaUncertainty,"
+                     "height,heightUncertainty,scale,degreesOfFreedom,DQSC,interpolations,competitors\n");
+        // unsigned values that were printed as signed integers before are cast to int so the output does not change
         unsigned int counter = 0;
         for (size_t j = 0; j < peaktable->size(); ++j)
         {
-            const CentroidPeak peak = peaktable->at(j);
-            char buffer[256];
-            snprintf(buffer, 256, "%d,%0.6f,%0.6f,%d,%0.4f,%0.4f,%0.4f,%0.4f,%0.4f,%d,%u,%0.5f,%d,%d\n",
-                     counter, peak.mz, peak.mzUncertainty, peak.scanNumber, convertRT->at(peak.scanNumber),
-                     peak.area, peak.areaUncertainty, peak.height, peak.heightUncertainty, peak.scale, peak.df, peak.DQSC,
-                     peak.interpolations, peak.numCompetitors);
-            output << buffer;
+            const CentroidPeak *peak = &peaktable->at(j);
+            output.row(int(counter), Fixed{peak->mz, 6}, Fixed{peak->mzUncertainty, 6}, int(peak->scanNumber),
+                       Fixed{convertRT->at(peak->scanNumber), 4}, Fixed{peak->area, 4}, Fixed{peak->areaUncertainty, 4},
+                       Fixed{peak->height, 4}, Fixed{peak->heightUncertainty, 4}, int(peak->scale), peak->df,
+                       Fixed{peak->DQSC, 5}, int(peak->interpolations), int(peak->numCompetitors));
             ++counter;
         }
 
-        file_out << output.str();
+        output.flush();
         file_out.close();
         return;
     }
 
     void printBins(const std::vector<qCentroid> *centroids,
-                   const std::vector<EIC> *bins,
+                   const EICStore *bins,
                    std::filesystem::path pathOutput,
                    std::string filename,
-                   bool silent, bool skipError, bool noOverwrite)
+                   bool silent, bool skipError, bool noOverwrite, bool binary, bool compress)
     {
-        filename += "_bins.csv";
-        pathOutput /= filename;
+        pathOutput = outputFilePath(pathOutput, filename, "_bins", binary, compress);
 
         if (std::filesystem::exists(pathOutput))
         {
@@ -684,35 +1278,79 @@ namespace qAlgorithms
 
         if (!silent)
         {
-            std::cout << "writing bins to: " << pathOutput << "\n";
+            announce("bins", pathOutput);
+        }
+
+        if (binary)
+        {
+            size_t length = 0;
+            for (size_t binID = 0; binID < bins->size(); binID++)
+            {
+                length += bins->at(binID).mz.size();
+            }
+            std::vector<unsigned int> binIDs, cenID, scanNumber, df;
+            std::vector<float> mz, mzUncertainty, retentionTime, area, height, DQSC, DQSB;
+            for (auto column : {&binIDs, &cenID, &scanNumber, &df})
+            {
+                column->reserve(length);
+            }
+            for (auto column : {&mz, &mzUncertainty, &retentionTime, &area, &height, &DQSC, &DQSB})
+            {
+                column->reserve(length);
+            }
+            for (size_t binID = 0; binID < bins->size(); binID++)
+            {
+                const BinView bin = bins->at(binID);
+                binIDs.insert(binIDs.end(), bin.mz.size(), binID);
+                for (size_t i = 0; i < bin.mz.size(); i++)
+                {
+                    cenID.push_back(centroids->at(bin.cenID[i]).cenID);
+                }
+                scanNumber.insert(scanNumber.end(), bin.scanNumbers.begin(), bin.scanNumbers.end());
+                df.insert(df.end(), bin.df.begin(), bin.df.end());
+                mz.insert(mz.end(), bin.mz.begin(), bin.mz.end());
+                mzUncertainty.insert(mzUncertainty.end(), bin.predInterval.begin(), bin.predInterval.end());
+                retentionTime.insert(retentionTime.end(), bin.rententionTimes.begin(), bin.rententionTimes.end());
+                area.insert(area.end(), bin.ints_area.begin(), bin.ints_area.end());
+                height.insert(height.end(), bin.ints_height.begin(), bin.ints_height.end());
+                DQSC.insert(DQSC.end(), bin.DQSC.begin(), bin.DQSC.end());
+                DQSB.insert(DQSB.end(), bin.DQSB.begin(), bin.DQSB.end());
+            }
+            const std::vector<BinaryColumn> columns = {
+                binaryColumn("binID", &binIDs), binaryColumn("cenID", &cenID), binaryColumn("mz", &mz),
+                binaryColumn("mzUncertainty", &mzUncertainty), binaryColumn("retentionTime", &retentionTime),
+                binaryColumn("scanNumber", &scanNumber), binaryColumn("area", &area), binaryColumn("height", &height),
+                binaryColumn("degreesOfFreedom", &df), binaryColumn("DQSC", &DQSC), binaryColumn("DQSB", &DQSB)};
+            if (!writeColumnar(pathOutput, &columns, length, compress))
+            {
+                std::cerr << "Error: could not write bins to " << pathOutput << "\n";
+            }
+            return;
         }
 
         std::ofstream file_out;
-        std::stringstream output;
-        file_out.open(pathOutput, std::ios::out);
+        file_out.open(pathOutput, compress ? std::ios::out | std::ios::binary : std::ios::out);
         if (!file_out.is_open())
         {
             std::cerr << "Error: could not open output path during bin printing. No files have been written.\n"
                       << "Filename: " << pathOutput << "\n";
             return;
         }
+        BufferedWriter output(&file_out, compress);
         // @todo consider if the mz error is relevant when checking individual bins
-        output << "binID,cenID,mz,mzUncertainty,retentionTime,scanNumber,area,height,degreesOfFreedom,DQSC,DQSB\n";
+        output.field("binID,cenID,mz,mzUncertainty,retentionTime,scanNumber,area,height,degreesOfFreedom,DQSC,DQSB\n");
         for (size_t binID = 0; binID < bins->size(); binID++)
         {
-            const EIC bin = bins->at(binID);
+            const BinView bin = bins->at(binID);
             for (size_t i = 0; i < bin.mz.size(); i++)
             {
-                const qCentroid cen = centroids->at(bin.cenID[i]);
-                char buffer[128];
-                snprintf(buffer, 128, "%zu,%u,%0.8f,%0.8f,%0.4f,%d,%0.6f,%0.6f,%u,%0.4f,%0.4f\n",
-                         binID, cen.cenID, bin.mz[i], bin.predInterval[i],
-                         bin.rententionTimes[i], bin.scanNumbers[i], bin.ints_area[i],
-                         bin.ints_height[i], bin.df[i], bin.DQSC[i], bin.DQSB[i]);
-                output << buffer;
+                const qCentroid *cen = &centroids->at(bin.cenID[i]);
+                output.row(binID, cen->cenID, Fixed{bin.mz[i], 8}, Fixed{bin.predInterval[i], 8},
+                           Fixed{bin.rententionTimes[i], 4}, int(bin.scanNumbers[i]), Fixed{bin.ints_area[i], 6},
+                           Fixed{bin.ints_height[i], 6}, bin.df[i], Fixed{bin.DQSC[i], 4}, Fixed{bin.DQSB[i], 4});
             }
         }
-        file_out << output.str();
+        output.flush();
         file_out.close();
         return;
     }
@@ -720,11 +1358,10 @@ namespace qAlgorithms
     void printFeatureList(const std::vector<FeaturePeak> *peaktable,
                           std::filesystem::path pathOutput,
                           std::string filename,
-                          const std::vector<EIC> *originalBins,
-                          bool verbose, bool silent, bool skipError, bool noOverwrite)
+                          const EICStore *originalBins,
+                          bool verbose, bool silent, bool skipError, bool noOverwrite, bool binary, bool compress)
     {
-        filename += "_features.csv";
-        pathOutput /= filename;
+        pathOutput = outputFilePath(pathOutput, filename, "_features", binary, compress);
 
         if (std::filesystem::exists(pathOutput))
         {
@@ -737,44 +1374,105 @@ namespace qAlgorithms
         }
         if (!silent)
         {
-            std::cout << "writing features to: " << pathOutput << "\n";
+            announce("features", pathOutput);
+        }
+
+        if (binary)
+        {
+            const size_t length = peaktable->size();
+            std::vector<unsigned int> compID(length), ID(length), binID(length), binIdxStart(length), binIdxEnd(length),
+                scale(length), interpolations(length), competitors(length);
+            std::vector<float> mz(length), mzUncertainty(length), retentionTime(length), retentionTimeUncertainty(length),
+                lowestRetentionTime(length), highestRetentionTime(length), area(length), areaUncertainty(length),
+                height(length), heightUncertainty(length), DQSC(length), DQSB(length), DQSF(length), mse(length),
+                b0(length), b1(length), b2(length), b3(length);
+            std::vector<unsigned char> apexLeft(length);
+            for (size_t i = 0; i < length; i++)
+            {
+                const FeaturePeak *peak = &peaktable->at(i);
+                const std::span<const float> RTs = originalBins->at(peak->idxBin).rententionTimes;
+                compID[i] = peak->componentID;
+                ID[i] = i + 1;
+                binID[i] = peak->idxBin;
+                binIdxStart[i] = peak->idxBinStart;
+                binIdxEnd[i] = peak->idxBinEnd;
+                mz[i] = peak->mz;
+                mzUncertainty[i] = peak->mzUncertainty;
+                retentionTime[i] = peak->retentionTime;
+                retentionTimeUncertainty[i] = peak->retentionTimeUncertainty;
+                lowestRetentionTime[i] = RTs[peak->idxBinStart];
+                highestRetentionTime[i] = RTs[peak->idxBinEnd];
+                area[i] = peak->area;
+                areaUncertainty[i] = peak->areaUncertainty;
+                height[i] = peak->height;
+                heightUncertainty[i] = peak->heightUncertainty;
+                scale[i] = peak->scale;
+                interpolations[i] = peak->interpolationCount;
+                competitors[i] = peak->competitorCount;
+                DQSC[i] = peak->DQSC;
+                DQSB[i] = peak->DQSB;
+                DQSF[i] = peak->DQSF;
+                apexLeft[i] = peak->apexLeft;
+                mse[i] = peak->mse_base;
+                b0[i] = peak->coefficients.b0;
+                b1[i] = peak->coefficients.b1;
+                b2[i] = peak->coefficients.b2;
+                b3[i] = peak->coefficients.b3;
+            }
+            const std::vector<BinaryColumn> columns = {
+                binaryColumn("CompID", &compID), binaryColumn("ID", &ID), binaryColumn("binID", &binID),
+                binaryColumn("binIdxStart", &binIdxStart), binaryColumn("binIdxEnd", &binIdxEnd),
+                binaryColumn("mz", &mz), binaryColumn("mzUncertainty", &mzUncertainty),
+                binaryColumn("retentionTime", &retentionTime), binaryColumn("retentionTimeUncertainty", &retentionTimeUncertainty),
+                binaryColumn("lowestRetentionTime", &lowestRetentionTime), binaryColumn("highestRetentionTime", &highestRetentionTime),
+                binaryColumn("area", &area), binaryColumn("areaUncertainty", &areaUncertainty),
+                binaryColumn("height", &height), binaryColumn("heightUncertainty", &heightUncertainty),
+                binaryColumn("scale", &scale), binaryColumn("interpolations", &interpolations),
+                binaryColumn("competitors", &competitors), binaryColumn("DQSC", &DQSC), binaryColumn("DQSB", &DQSB),
+                binaryColumn("DQSF", &DQSF), binaryColumn("apexLeft", &apexLeft), binaryColumn("mse", &mse),
+                binaryColumn("b0", &b0), binaryColumn("b1", &b1), binaryColumn("b2", &b2), binaryColumn("b3", &b3)};
+            if (!writeColumnar(pathOutput, &columns, length, compress))
+            {
+                std::cerr << "Error: could not write features to " << pathOutput << "\n";
+            }
+            return;
         }
 
         std::ofstream file_out;
-        std::stringstream output;
-        file_out.open(pathOutput, std::ios::out);
+        file_out.open(pathOutput, compress ? std::ios::out | std::ios::binary : std::ios::out);
         if (!file_out.is_open())
         {
             std::cerr << "Error: could not open output path during peaklist printing. No files have been written.\n"
                       << "Filename: " << pathOutput << "\n";
             return;
         }
+        BufferedWriter output(&file_out, compress);
 
         constexpr std::string_view header = "CompID,ID,binID,binIdxStart,binIdxEnd,mz,mzUncertainty,retentionTime,retentionTimeUncertainty,"
                                             "lowestRetentionTime,highestRetentionTime,area,areaUncertainty,height,heightUncertainty,"
                                             "scale,interpolations,competitors,DQSC,DQSB,DQSF,apexLeft,mse,b0,b1,b2,b3\n";
-        output << header;
+        output.field(header);
 
         unsigned int counter = 1;
         for (size_t i = 0; i < peaktable->size(); i++)
         {
-            const FeaturePeak peak = peaktable->at(i);
-            int binID = peak.idxBin;
-            const std::vector<float> RTs = originalBins->at(binID).rententionTimes;
+            const FeaturePeak *peak = &peaktable->at(i);
+            int binID = peak->idxBin;
+            const std::span<const float> RTs = originalBins->at(binID).rententionTimes;
 
-            char buffer[256];
-            snprintf(buffer, 256, "%d,%d,%d,%d,%d,%0.6f,%0.6f,%0.4f,%0.4f,%0.4f,%0.4f,%0.3f,%0.3f,%0.3f,%0.3f,%d,%d,%d,%0.5f,%0.5f,%0.5f,%s,%0.6f,%0.8f,%0.8f,%0.8f,%0.8f\n",
-                     peak.componentID, counter, binID, peak.idxBinStart, peak.idxBinEnd, peak.mz, peak.mzUncertainty,
-                     peak.retentionTime, peak.retentionTimeUncertainty, RTs[peak.idxBinStart], RTs[peak.idxBinEnd],
-                     peak.area, peak.areaUncertainty, peak.height, peak.heightUncertainty, peak.scale,
-                     peak.interpolationCount, peak.competitorCount, peak.DQSC, peak.DQSB, peak.DQSF,
-                     // properties relevant for componentisation, remove this later
-                     peak.apexLeft ? "T" : "F", peak.mse_base, peak.coefficients.b0, peak.coefficients.b1, peak.coefficients.b2, peak.coefficients.b3);
-            output << buffer;
+            output.row(int(peak->componentID), int(counter), binID, int(peak->idxBinStart), int(peak->idxBinEnd),
+                       Fixed{peak->mz, 6}, Fixed{peak->mzUncertainty, 6}, Fixed{peak->retentionTime, 4},
+                       Fixed{peak->retentionTimeUncertainty, 4}, Fixed{RTs[peak->idxBinStart], 4}, Fixed{RTs[peak->idxBinEnd], 4},
+                       Fixed{peak->area, 3}, Fixed{peak->areaUncertainty, 3}, Fixed{peak->height, 3}, Fixed{peak->heightUncertainty, 3},
+                       int(peak->scale), int(peak->interpolationCount), int(peak->competitorCount),
+                       Fixed{peak->DQSC, 5}, Fixed{peak->DQSB, 5}, Fixed{peak->DQSF, 5},
+                       // properties relevant for componentisation, remove this later
+                       peak->apexLeft ? "T" : "F", Fixed{peak->mse_base, 6}, Fixed{peak->coefficients.b0, 8},
+                       Fixed{peak->coefficients.b1, 8}, Fixed{peak->coefficients.b2, 8}, Fixed{peak->coefficients.b3, 8});
             ++counter;
         }
 
-        file_out << output.str();
+        output.flush();
         file_out.close();
         return;
     }
@@ -782,11 +1480,10 @@ namespace qAlgorithms
     void printFeatureCentroids(const std::vector<FeaturePeak> *peaktable,
                                std::filesystem::path pathOutput,
                                std::string filename,
-                               const std::vector<EIC> *originalBins,
-                               bool verbose, bool silent, bool skipError, bool noOverwrite)
+                               const EICStore *originalBins,
+                               bool verbose, bool silent, bool skipError, bool noOverwrite, bool binary, bool compress)
     {
-        filename += "_featCen.csv";
-        pathOutput /= filename;
+        pathOutput = outputFilePath(pathOutput, filename, "_featCen", binary, compress);
 
         if (std::filesystem::exists(pathOutput))
         {
@@ -799,41 +1496,86 @@ namespace qAlgorithms
         }
         if (!silent)
         {
-            std::cout << "writing feature centroids to: " << pathOutput << "\n";
+            announce("feature centroids", pathOutput);
+        }
+
+        if (binary)
+        {
+            // feature properties are repeated for every centroid, same as in the csv
+            std::vector<unsigned int> featureID, binIDs, cenID, scan, df;
+            std::vector<float> mz, mzUncertainty, retentionTime, area, height, DQSC, DQSB, DQSF, b0, b1, b2, b3;
+            std::vector<unsigned char> apexLeft;
+            for (size_t i = 0; i < peaktable->size(); i++)
+            {
+                const FeaturePeak *peak = &peaktable->at(i);
+                const BinView bin = originalBins->at(peak->idxBin);
+                const size_t first = peak->idxBinStart;
+                const size_t last = peak->idxBinEnd + 1;
+                const size_t count = last - first;
+                featureID.insert(featureID.end(), count, i + 1);
+                binIDs.insert(binIDs.end(), count, peak->idxBin);
+                cenID.insert(cenID.end(), bin.cenID.begin() + first, bin.cenID.begin() + last);
+                mz.insert(mz.end(), bin.mz.begin() + first, bin.mz.begin() + last);
+                mzUncertainty.insert(mzUncertainty.end(), bin.predInterval.begin() + first, bin.predInterval.begin() + last);
+                retentionTime.insert(retentionTime.end(), bin.rententionTimes.begin() + first, bin.rententionTimes.begin() + last);
+                scan.insert(scan.end(), bin.scanNumbers.begin() + first, bin.scanNumbers.begin() + last);
+                area.insert(area.end(), bin.ints_area.begin() + first, bin.ints_area.begin() + last);
+                height.insert(height.end(), bin.ints_height.begin() + first, bin.ints_height.begin() + last);
+                df.insert(df.end(), bin.df.begin() + first, bin.df.begin() + last);
+                DQSC.insert(DQSC.end(), bin.DQSC.begin() + first, bin.DQSC.begin() + last);
+                DQSB.insert(DQSB.end(), bin.DQSB.begin() + first, bin.DQSB.begin() + last);
+                DQSF.insert(DQSF.end(), count, peak->DQSF);
+                apexLeft.insert(apexLeft.end(), count, peak->apexLeft);
+                b0.insert(b0.end(), count, peak->coefficients.b0);
+                b1.insert(b1.end(), count, peak->coefficients.b1);
+                b2.insert(b2.end(), count, peak->coefficients.b2);
+                b3.insert(b3.end(), count, peak->coefficients.b3);
+            }
+            const std::vector<BinaryColumn> columns = {
+                binaryColumn("featureID", &featureID), binaryColumn("binID", &binIDs), binaryColumn("cenID", &cenID),
+                binaryColumn("mz", &mz), binaryColumn("mzUncertainty", &mzUncertainty),
+                binaryColumn("retentionTime", &retentionTime), binaryColumn("scan", &scan), binaryColumn("area", &area),
+                binaryColumn("height", &height), binaryColumn("degreesOfFreedom", &df), binaryColumn("DQSC", &DQSC),
+                binaryColumn("DQSB", &DQSB), binaryColumn("DQSF", &DQSF), binaryColumn("apexLeft", &apexLeft),
+                binaryColumn("b0", &b0), binaryColumn("b1", &b1), binaryColumn("b2", &b2), binaryColumn("b3", &b3)};
+            if (!writeColumnar(pathOutput, &columns, featureID.size(), compress))
+            {
+                std::cerr << "Error: could not write feature centroids to " << pathOutput << "\n";
+            }
+            return;
         }
 
         std::ofstream file_out;
-        std::stringstream output;
-        file_out.open(pathOutput, std::ios::out);
+        file_out.open(pathOutput, compress ? std::ios::out | std::ios::binary : std::ios::out);
         if (!file_out.is_open())
         {
             std::cerr << "Error: could not open output path during featCen printing. No files have been written.\n"
                       << "Filename: " << pathOutput << "\n";
             return;
         }
+        BufferedWriter output(&file_out, compress);
 
-        output << "featureID,binID,cenID,mz,mzUncertainty,retentionTime,scan"
-               << "area,height,degreesOfFreedom,DQSC,DQSB,DQSF,apexLeft,b0,b1,b2,b3\n";
+        output.field("featureID,binID,cenID,mz,mzUncertainty,retentionTime,scan"
+                     "area,height,degreesOfFreedom,DQSC,DQSB,DQSF,apexLeft,b0,b1,b2,b3\n");
 
         unsigned int counter = 1;
         for (size_t i = 0; i < peaktable->size(); i++)
         {
-            const FeaturePeak peak = peaktable->at(i);
-            int binID = peak.idxBin;
-            const EIC bin = originalBins->at(binID);
-            char buffer[256];
-            for (size_t cen = peak.idxBinStart; cen < peak.idxBinEnd + 1; cen++)
+            const FeaturePeak *peak = &peaktable->at(i);
+            int binID = peak->idxBin;
+            const BinView bin = originalBins->at(binID);
+            for (size_t cen = peak->idxBinStart; cen < peak->idxBinEnd + 1; cen++)
             {
-                snprintf(buffer, 256, "%d,%d,%d,%0.6f,%0.6f,%0.4f,%d,%0.3f,%0.3f,%d,%0.5f,%0.5f,%0.5f,%s,%0.8f,%0.8f,%0.8f,%0.8f\n",
-                         counter, binID, bin.cenID[cen], bin.mz[cen], bin.predInterval[cen], bin.rententionTimes[cen], bin.scanNumbers[cen],
-                         bin.ints_area[cen], bin.ints_height[cen], bin.df[cen], bin.DQSC[cen], bin.DQSB[cen], peak.DQSF,
-                         peak.apexLeft ? "T" : "F", peak.coefficients.b0, peak.coefficients.b1, peak.coefficients.b2, peak.coefficients.b3);
-                output << buffer;
+                output.row(int(counter), binID, int(bin.cenID[cen]), Fixed{bin.mz[cen], 6}, Fixed{bin.predInterval[cen], 6},
+                           Fixed{bin.rententionTimes[cen], 4}, int(bin.scanNumbers[cen]), Fixed{bin.ints_area[cen], 3},
+                           Fixed{bin.ints_height[cen], 3}, int(bin.df[cen]), Fixed{bin.DQSC[cen], 5}, Fixed{bin.DQSB[cen], 5},
+                           Fixed{peak->DQSF, 5}, peak->apexLeft ? "T" : "F", Fixed{peak->coefficients.b0, 8},
+                           Fixed{peak->coefficients.b1, 8}, Fixed{peak->coefficients.b2, 8}, Fixed{peak->coefficients.b3, 8});
             }
             ++counter;
         }
 
-        file_out << output.str();
+        output.flush();
         file_out.close();
         return;
     }
@@ -841,10 +1583,9 @@ namespace qAlgorithms
     void printComponentRegressions(const std::vector<MultiRegression> *compRegs,
                                    std::filesystem::path pathOutput,
                                    std::string filename,
-                                   bool verbose, bool silent, bool skipError, bool noOverwrite)
+                                   bool verbose, bool silent, bool skipError, bool noOverwrite, bool binary, bool compress)
     {
-        filename += "_components.csv";
-        pathOutput /= filename;
+        pathOutput = outputFilePath(pathOutput, filename, "_components", binary, compress);
 
         if (std::filesystem::exists(pathOutput))
         {
@@ -857,54 +1598,92 @@ namespace qAlgorithms
         }
         if (!silent)
         {
-            std::cout << "writing component regression parameters to: " << pathOutput << "\n";
+            announce("component regression parameters", pathOutput);
+        }
+
+        if (binary)
+        {
+            // components have no upper size limit, so the b0 of all components are stored in one column.
+            // The values of component i are b0[b0_offset[i]] to b0[b0_offset[i + 1] - 1]
+            const size_t length = compRegs->size();
+            std::vector<unsigned int> compID(length), numPeaks(length), scanStart(length), idx0(length);
+            std::vector<float> DQS(length), b1(length), b2(length), b3(length), b0;
+            std::vector<uint64_t> b0_offset(length + 1, 0);
+            for (size_t regIdx = 0; regIdx < length; regIdx++)
+            {
+                const MultiRegression *reg = &compRegs->at(regIdx);
+                compID[regIdx] = regIdx + 1;
+                numPeaks[regIdx] = reg->numPeaks;
+                scanStart[regIdx] = reg->scanStart;
+                idx0[regIdx] = reg->idx_x0;
+                DQS[regIdx] = reg->DQS;
+                b1[regIdx] = reg->b1;
+                b2[regIdx] = reg->b2;
+                b3[regIdx] = reg->b3;
+                for (size_t peak = 0; peak < reg->numPeaks; peak++)
+                {
+                    b0.push_back(reg->b0_vec[peak]);
+                }
+                b0_offset[regIdx + 1] = b0.size();
+            }
+            const std::vector<BinaryColumn> columns = {
+                binaryColumn("compID", &compID), binaryColumn("numPeaks", &numPeaks), binaryColumn("scanStart", &scanStart),
+                binaryColumn("idx0", &idx0), binaryColumn("dqsp", &DQS), binaryColumn("b1", &b1), binaryColumn("b2", &b2),
+                binaryColumn("b3", &b3), binaryColumn("b0_offset", &b0_offset), binaryColumn("b0", &b0)};
+            if (!writeColumnar(pathOutput, &columns, length, compress))
+            {
+                std::cerr << "Error: could not write component regressions to " << pathOutput << "\n";
+            }
+            return;
         }
 
         std::ofstream file_out;
-        std::stringstream output;
-        file_out.open(pathOutput, std::ios::out);
+        file_out.open(pathOutput, compress ? std::ios::out | std::ios::binary : std::ios::out);
         if (!file_out.is_open())
         {
             std::cerr << "Error: could not open output path during component printing. No files have been written.\n"
                       << "Filename: " << pathOutput << "\n";
             return;
         }
+        BufferedWriter output(&file_out, compress);
 
-        output << "compID,numPeaks,scanStart,idx0,dqsp,b1,b2,b3,vals_b0\n"; // @todo make sure the features in a component are in order
+        output.field("compID,numPeaks,scanStart,idx0,dqsp,b1,b2,b3,vals_b0\n"); // @todo make sure the features in a component are in order
 
         for (unsigned int regIdx = 0; regIdx < compRegs->size(); regIdx++)
         {
-            // @todo this will fail if an unrealistically large number of components exist - should be fine
-            const MultiRegression reg = compRegs->at(regIdx);
-            const unsigned int bufsize = 2048;
-            char buffer[bufsize];
-            char *b0_buf = buffer; // print b0 to the end
-            unsigned int writtenChars = snprintf(&buffer[0], bufsize, "%u,%u,%u,%u,%0.6f,%0.8f,%0.8f,%0.8f,b0",
-                                                 regIdx + 1, reg.numPeaks, reg.scanStart, reg.idx_x0, reg.DQS, reg.b1, reg.b2, reg.b3);
-            assert(writtenChars < bufsize);
-            for (size_t b0 = 0; b0 < reg.numPeaks; b0++)
+            const MultiRegression *reg = &(compRegs->at(regIdx));
+            for (auto value : {regIdx + 1, reg->numPeaks, reg->scanStart, reg->idx_x0})
+            {
+                output.field(value);
+                output.put(',');
+            }
+            for (Fixed value : {Fixed{reg->DQS, 6}, Fixed{reg->b1, 8}, Fixed{reg->b2, 8}, Fixed{reg->b3, 8}})
+            {
+                output.field(value);
+                output.put(',');
+            }
+            output.field("b0");
+            // components have no upper size limit, so every b0 is printed separately
+            for (size_t b0 = 0; b0 < reg->numPeaks; b0++)
             {
-                assert(writtenChars < bufsize);
-                writtenChars += snprintf(&buffer[writtenChars], bufsize - writtenChars, "%0.8f;", reg.b0_vec[b0]);
+                output.field(Fixed{reg->b0_vec[b0], 8});
+                output.put(';');
             }
-            assert(writtenChars < bufsize);
-            snprintf(&buffer[writtenChars], bufsize - writtenChars, "\n");
-            output << b0_buf;
+            output.put('\n');
         }
 
-        file_out << output.str();
+        output.flush();
         file_out.close();
         return;
     }
 
     void printComponentCentroids(const std::vector<MultiRegression> *compRegs,
-                                 const std::vector<EIC> *bins,
+                                 const EICStore *bins,
                                  std::filesystem::path pathOutput,
                                  std::string filename,
-                                 bool verbose, bool silent, bool skipError, bool noOverwrite)
+                                 bool verbose, bool silent, bool skipError, bool noOverwrite, bool binary, bool compress)
     {
-        filename += "_compCens.csv";
-        pathOutput /= filename;
+        pathOutput = outputFilePath(pathOutput, filename, "_compCens", binary, compress);
 
         if (std::filesystem::exists(pathOutput))
         {
@@ -917,61 +1696,473 @@ namespace qAlgorithms
         }
         if (!silent)
         {
-            std::cout << "writing centroids in non-feature components to: " << pathOutput << "\n";
+            announce("centroids in non-feature components", pathOutput);
         }
 
-        std::ofstream file_out;
-        std::stringstream output;
-        file_out.open(pathOutput, std::ios::out);
+        // only the part of a bin that lies within the scan region of its component is written
+        auto componentRange = [&](const BinView &bin, unsigned int compID)
+        {
+            size_t scanStart = std::max(compRegs->at(compID - 1).scanStart, bin.scanNumbers[0]);
+            size_t scanEnd = std::min(compRegs->at(compID - 1).scanEnd, bin.scanNumbers.back());
+            size_t idxStart = 0;
+            size_t idxEnd_1 = bin.scanNumbers.size(); // index one past the end
+            // find limits
+            for (size_t i = 0; i < bin.scanNumbers.size(); i++)
+            {
+                if (bin.scanNumbers[i] <= scanStart)
+                {
+                    idxStart = i;
+                }
+                else if (bin.scanNumbers[i] > scanEnd)
+                {
+                    idxEnd_1 = i;
+                    break;
+                }
+            }
+            return std::pair<size_t, size_t>(idxStart, idxEnd_1);
+        };
+
+        if (binary)
+        {
+            std::vector<unsigned int> compIDs, binIDs, cenID, scanNumber;
+            std::vector<float> mz, mzUncertainty, retentionTime, area, height, DQSC;
+            for (unsigned int binID = 0; binID < bins->size(); binID++)
+            {
+                const BinView bin = bins->at(binID);
+                unsigned int compID = bin.componentID;
+                if (compID == 0)
+                {
+                    continue;
+                }
+                const auto [idxStart, idxEnd_1] = componentRange(bin, compID);
+                const size_t count = idxEnd_1 - idxStart;
+                compIDs.insert(compIDs.end(), count, compID);
+                binIDs.insert(binIDs.end(), count, binID);
+                cenID.insert(cenID.end(), bin.cenID.begin() + idxStart, bin.cenID.begin() + idxEnd_1);
+                mz.insert(mz.end(), bin.mz.begin() + idxStart, bin.mz.begin() + idxEnd_1);
+                mzUncertainty.insert(mzUncertainty.end(), bin.predInterval.begin() + idxStart, bin.predInterval.begin() + idxEnd_1);
+                retentionTime.insert(retentionTime.end(), bin.rententionTimes.begin() + idxStart, bin.rententionTimes.begin() + idxEnd_1);
+                scanNumber.insert(scanNumber.end(), bin.scanNumbers.begin() + idxStart, bin.scanNumbers.begin() + idxEnd_1);
+                area.insert(area.end(), bin.ints_area.begin() + idxStart, bin.ints_area.begin() + idxEnd_1);
+                height.insert(height.end(), bin.ints_height.begin() + idxStart, bin.ints_height.begin() + idxEnd_1);
+                DQSC.insert(DQSC.end(), bin.DQSC.begin() + idxStart, bin.DQSC.begin() + idxEnd_1);
+            }
+            const std::vector<BinaryColumn> columns = {
+                binaryColumn("compID", &compIDs), binaryColumn("binID", &binIDs), binaryColumn("cenID", &cenID),
+                binaryColumn("mz", &mz), binaryColumn("mzUncertainty", &mzUncertainty),
+                binaryColumn("retentionTime", &retentionTime), binaryColumn("scanNumber", &scanNumber),
+                binaryColumn("area", &area), binaryColumn("height", &height), binaryColumn("DQSC", &DQSC)};
+            if (!writeColumnar(pathOutput, &columns, compIDs.size(), compress))
+            {
+                std::cerr << "Error: could not write component centroids to " << pathOutput << "\n";
+            }
+            return;
+        }
+
+        std::ofstream file_out(pathOutput, compress ? std::ios::out | std::ios::binary : std::ios::out);
         if (!file_out.is_open())
         {
             std::cerr << "Error: could not open output path during component printing. No files have been written.\n"
                       << "Filename: " << pathOutput << "\n";
             return;
         }
-
-        output << "compID,binID,cenID,mz,mzUncertainty,retentionTime,scanNumber,area,height,DQSC\n";
+        BufferedWriter output(&file_out, compress);
+        output.field("compID,binID,cenID,mz,mzUncertainty,retentionTime,scanNumber,area,height,DQSC\n");
 
         for (unsigned int binID = 0; binID < bins->size(); binID++)
         {
-            const EIC bin = bins->at(binID);
+            const BinView bin = bins->at(binID);
             unsigned int compID = bin.componentID;
             if (compID == 0)
             {
                 continue;
             }
-            size_t scanStart = std::max(compRegs->at(compID - 1).scanStart, bin.scanNumbers[0]);
-            size_t scanEnd = std::min(compRegs->at(compID - 1).scanEnd, bin.scanNumbers.back());
-            size_t idxStart = 0;
-            size_t idxEnd_1 = bin.scanNumbers.size(); // index one past the end
-            // find limits
-            for (size_t i = 0; i < bin.scanNumbers.size(); i++)
+            const auto [idxStart, idxEnd_1] = componentRange(bin, compID);
+            for (size_t i = idxStart; i < idxEnd_1; i++)
             {
-                if (bin.scanNumbers[i] <= scanStart)
+                output.row(compID, binID, bin.cenID[i], Fixed{bin.mz[i], 8}, Fixed{bin.predInterval[i], 8},
+                           Fixed{bin.rententionTimes[i], 4}, int(bin.scanNumbers[i]), Fixed{bin.ints_area[i], 6},
+                           Fixed{bin.ints_height[i], 6}, Fixed{bin.DQSC[i], 6});
+            }
+        }
+
+        output.flush();
+        file_out.close();
+        return;
+    }
+
+    void printComponentStats(const std::vector<std::pair<std::string, ComponentStats>> *stats,
+                             std::filesystem::path pathLogfile)
+    {
+        std::filesystem::path pathOutput = pathLogfile.replace_extension();
+        pathOutput += "_components.json";
+
+        // filenames are the only strings in the output, so only quotes, backslashes and control characters are escaped
+        auto jsonString = [](const std::string &str)
+        {
+            std::string escaped = "\"";
+            for (char c : str)
+            {
+                if (c == '"' || c == '\\')
                 {
-                    idxStart = i;
+                    escaped += '\\';
+                    escaped += c;
                 }
-                else if (bin.scanNumbers[i] > scanEnd)
+                else if (static_cast<unsigned char>(c) < 0x20)
                 {
-                    idxEnd_1 = i;
-                    break;
+                    char buffer[8];
+                    snprintf(buffer, 8, "\\u%04x", c);
+                    escaped += buffer;
+                }
+                else
+                {
+                    escaped += c;
                 }
             }
+            return escaped + "\"";
+        };
 
-            for (size_t i = idxStart; i < idxEnd_1; i++)
+        std::stringstream output;
+        output << "[\n";
+        for (size_t i = 0; i < stats->size(); i++)
+        {
+            const ComponentStats *file = &stats->at(i).second;
+            output << "  {\n    \"filename\": " << jsonString(stats->at(i).first) << ",\n";
+
+            // only sizes that occur are printed, as "size": count
+            output << "    \"preGroupSizes\": {";
+            bool first = true;
+            for (size_t size = 0; size < file->preGroupSizes.size(); size++)
             {
-                char buffer[128];
-                snprintf(buffer, 128, "%u,%u,%u,%0.8f,%0.8f,%0.4f,%d,%0.6f,%0.6f,%0.6f\n",
-                         compID, binID, bin.cenID[i], bin.mz[i], bin.predInterval[i],
-                         bin.rententionTimes[i], bin.scanNumbers[i], bin.ints_area[i],
-                         bin.ints_height[i], bin.DQSC[i]);
-                output << buffer;
+                if (file->preGroupSizes[size] == 0)
+                {
+                    continue;
+                }
+                output << (first ? "" : ", ") << "\"" << size << "\": " << file->preGroupSizes[size];
+                first = false;
             }
+            output << "},\n";
+
+            output << "    \"valleys_single\": " << file->valleys_single << ",\n"
+                   << "    \"valleys_other\": " << file->valleys_other << ",\n"
+                   << "    \"invalidFeatures\": " << file->invalidFeatures << ",\n"
+                   << "    \"pairsEnumerated\": " << file->pairsEnumerated << ",\n"
+                   << "    \"pairsRejectedRT\": " << file->pairsRejectedRT << ",\n"
+                   << "    \"pairRegressionsFailed\": " << file->pairRegressionsFailed << ",\n"
+                   << "    \"pairsValid\": " << file->pairsValid << ",\n"
+                   << "    \"regressionsFitted\": " << file->regressionsFitted << ",\n"
+                   << "    \"growAccepted\": " << file->growAccepted << ",\n"
+                   << "    \"growRejected\": " << file->growRejected << ",\n"
+                   << "    \"mergesAccepted\": " << file->mergesAccepted << ",\n"
+                   << "    \"mergesRejected\": " << file->mergesRejected << ",\n"
+                   << "    \"identicalComponents\": " << file->identicalComponents << ",\n"
+                   << "    \"components\": " << file->components << ",\n"
+                   << "    \"featuresInComponents\": " << file->featuresInComponents << ",\n";
+
+            char buffer[256];
+            snprintf(buffer, 256,
+                     "    \"seconds\": {\"preGroup\": %0.6f, \"harmonise\": %0.6f, \"pairs\": %0.6f, "
+                     "\"assign\": %0.6f, \"collect\": %0.6f, \"wall\": %0.6f}\n",
+                     file->time_preGroup, file->time_harmonise, file->time_pairs,
+                     file->time_assign, file->time_collect, file->time_wall);
+            output << buffer << (i + 1 < stats->size() ? "  },\n" : "  }\n");
         }
+        output << "]\n";
 
+        std::ofstream file_out;
+        file_out.open(pathOutput, std::ios::out);
+        if (!file_out.is_open())
+        {
+            std::cerr << "Error: could not open output path during component statistics printing.\n"
+                      << "Filename: " << pathOutput << "\n";
+            return;
+        }
         file_out << output.str();
         file_out.close();
         return;
     }
 #pragma endregion "print functions"
-}
\ No newline at end of file
+
+#pragma region "checkpoints"
+
+    constexpr char CHECKPOINT_MAGIC[8] = {'Q', 'A', 'L', 'G', 'C', 'H', 'K', '\0'};
+    constexpr uint32_t CHECKPOINT_VERSION = 2;
+
+    struct CheckpointHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t stage;       // CheckpointStage
+        uint64_t elementSize; // size of the stored struct, a different size means the checkpoint is from another build
+        uint64_t reserved = 0;
+    };
+
+    std::filesystem::path checkpointPath(std::filesystem::path pathOutput, std::string filename, CheckpointStage stage)
+    {
+        switch (stage)
+        {
+        case CheckpointStage::centroids:
+            filename += "_centroids.qchk";
+            break;
+        case CheckpointStage::bins:
+            filename += "_bins.qchk";
+            break;
+        case CheckpointStage::features:
+            filename += "_features.qchk";
+            break;
+        case CheckpointStage::none:
+            assert(false);
+            break;
+        }
+        return pathOutput / filename;
+    }
+
+    template <typename T>
+    static void writeValue(std::ofstream *file, T value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        file->write(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    // the number of values followed by the values
+    template <typename T>
+    static void writeValues(std::ofstream *file, const std::vector<T> *values)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        writeValue(file, uint64_t(values->size()));
+        file->write(reinterpret_cast<const char *>(values->data()), values->size() * sizeof(T));
+    }
+
+    static bool writeCheckpointFile(const std::filesystem::path &pathOutput, CheckpointStage stage, size_t elementSize,
+                                    const std::function<void(std::ofstream *)> &writeContent)
+    {
+        std::filesystem::path pathTemporary = pathOutput;
+        pathTemporary += ".tmp";
+        std::ofstream file_out(pathTemporary, std::ios::out | std::ios::binary);
+        if (!file_out.is_open())
+        {
+            return false;
+        }
+        CheckpointHeader header;
+        memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+        header.version = CHECKPOINT_VERSION;
+        header.stage = uint32_t(stage);
+        header.elementSize = elementSize;
+        writeValue(&file_out, header);
+        writeContent(&file_out);
+        file_out.close();
+
+        std::error_code error;
+        if (!file_out.fail())
+        {
+            std::filesystem::rename(pathTemporary, pathOutput, error);
+        }
+        if (file_out.fail() || error)
+        {
+            std::filesystem::remove(pathTemporary, error);
+            return false;
+        }
+        return true;
+    }
+
+    // reads values from a checkpoint in memory, every read fails once the end of the data is reached
+    class CheckpointReader
+    {
+    public:
+        explicit CheckpointReader(const std::vector<char> *data) : data(data) {}
+
+        template <typename T>
+        bool value(T *target)
+        {
+            if (data->size() - position < sizeof(T))
+            {
+                return false;
+            }
+            memcpy(target, data->data() + position, sizeof(T));
+            position += sizeof(T);
+            return true;
+        }
+
+        template <typename T>
+        bool values(std::vector<T> *target)
+        {
+            uint64_t count = 0;
+            if (!value(&count) || count > (data->size() - position) / sizeof(T))
+            {
+                return false;
+            }
+            target->resize(count);
+            memcpy(target->data(), data->data() + position, count * sizeof(T));
+            position += count * sizeof(T);
+            return true;
+        }
+
+        bool bytes(std::span<std::byte> target)
+        {
+            if (data->size() - position < target.size())
+            {
+                return false;
+            }
+            memcpy(target.data(), data->data() + position, target.size());
+            position += target.size();
+            return true;
+        }
+
+        bool complete() const { return position == data->size(); }
+
+    private:
+        const std::vector<char> *data;
+        size_t position = 0;
+    };
+
+    // read the whole file and check the header, the returned data starts after the header
+    static bool loadCheckpointFile(const std::filesystem::path &pathInput, CheckpointStage stage, size_t elementSize,
+                                   std::vector<char> *data)
+    {
+        std::ifstream file_in(pathInput, std::ios::in | std::ios::binary | std::ios::ate);
+        if (!file_in.is_open())
+        {
+            std::cerr << "Error: could not open the checkpoint " << pathInput << "\n";
+            return false;
+        }
+        const size_t size = file_in.tellg();
+        CheckpointHeader header;
+        file_in.seekg(0);
+        if (size < sizeof(header) || !file_in.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+            memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != CHECKPOINT_VERSION || header.stage != uint32_t(stage))
+        {
+            std::cerr << "Error: " << pathInput << " is not a valid checkpoint\n";
+            return false;
+        }
+        if (header.elementSize != elementSize)
+        {
+            std::cerr << "Error: the checkpoint " << pathInput << " was written by a different build of qAlgorithms\n";
+            return false;
+        }
+        data->resize(size - sizeof(header));
+        if (!file_in.read(data->data(), data->size()))
+        {
+            std::cerr << "Error: could not read the checkpoint " << pathInput << "\n";
+            return false;
+        }
+        return true;
+    }
+
+    bool writeCheckpoint(const std::filesystem::path &pathOutput, const CentroidState *state)
+    {
+        return writeCheckpointFile(pathOutput, CheckpointStage::centroids, sizeof(qCentroid), [state](std::ofstream *file)
+                                   {
+            writeValue(file, uint64_t(state->spectrumCount));
+            writeValue(file, uint64_t(state->centroidCount));
+            writeValue(file, state->diff_rt);
+            writeValue(file, state->minCenArea);
+            writeValues(file, &state->convertRT);
+            writeValues(file, &state->centroids); });
+    }
+
+    bool writeCheckpoint(const std::filesystem::path &pathOutput, const EICStore *bins)
+    {
+        // the arena is written as one block, it is read back without converting the bins
+        return writeCheckpointFile(pathOutput, CheckpointStage::bins, sizeof(EICLayout), [bins](std::ofstream *file)
+                                   {
+            writeValues(file, bins->blockLayouts());
+            writeValues(file, bins->binComponentIDs());
+            writeValues(file, bins->binInterpolations());
+            const std::span<const std::byte> arena = bins->arena();
+            writeValue(file, uint64_t(arena.size()));
+            file->write(reinterpret_cast<const char *>(arena.data()), arena.size()); });
+    }
+
+    bool writeCheckpoint(const std::filesystem::path &pathOutput, const std::vector<FeaturePeak> *features)
+    {
+        return writeCheckpointFile(pathOutput, CheckpointStage::features, sizeof(FeaturePeak), [features](std::ofstream *file)
+                                   { writeValues(file, features); });
+    }
+
+    bool readCheckpoint(const std::filesystem::path &pathInput, CentroidState *state)
+    {
+        std::vector<char> data;
+        if (!loadCheckpointFile(pathInput, CheckpointStage::centroids, sizeof(qCentroid), &data))
+        {
+            return false;
+        }
+        CheckpointReader reader(&data);
+        uint64_t spectrumCount = 0;
+        uint64_t centroidCount = 0;
+        bool correct = reader.value(&spectrumCount) && reader.value(&centroidCount) &&
+                       reader.value(&state->diff_rt) && reader.value(&state->minCenArea) &&
+                       reader.values(&state->convertRT) && reader.values(&state->centroids) && reader.complete();
+        if (!correct)
+        {
+            std::cerr << "Error: the checkpoint " << pathInput << " is incomplete\n";
+            return false;
+        }
+        state->spectrumCount = spectrumCount;
+        state->centroidCount = centroidCount;
+        return true;
+    }
+
+    bool readCheckpoint(const std::filesystem::path &pathInput, const std::filesystem::path &spillDirectory, EICStore *bins)
+    {
+        std::vector<char> data;
+        if (!loadCheckpointFile(pathInput, CheckpointStage::bins, sizeof(EICLayout), &data))
+        {
+            return false;
+        }
+        CheckpointReader reader(&data);
+        std::vector<EICLayout> layouts;
+        std::vector<size_t> componentIDs;
+        std::vector<unsigned char> interpolations;
+        uint64_t arenaSize = 0;
+        bool correct = reader.values(&layouts) && reader.values(&componentIDs) && reader.values(&interpolations) &&
+                       reader.value(&arenaSize) && componentIDs.size() == layouts.size() &&
+                       interpolations.size() == layouts.size() && arenaSize <= data.size();
+        // the arena is only allocated if its size matches the layouts
+        size_t expectedSize = 0;
+        for (size_t i = 0; correct && i < layouts.size(); i++)
+        {
+            correct = layouts[i].length <= data.size() && layouts[i].interpolatedLength <= data.size();
+            expectedSize += layouts[i].bytes();
+        }
+        if (correct && expectedSize == arenaSize)
+        {
+            *bins = EICStore(std::move(layouts), spillDirectory);
+            correct = reader.bytes(bins->arena()) && reader.complete();
+        }
+        else
+        {
+            correct = false;
+        }
+        if (!correct)
+        {
+            std::cerr << "Error: the checkpoint " << pathInput << " is incomplete\n";
+            *bins = EICStore{};
+            return false;
+        }
+        for (size_t binID = 0; binID < bins->size(); binID++)
+        {
+            bins->setBinInfo(binID, componentIDs[binID], interpolations[binID] != 0);
+        }
+        return true;
+    }
+
+    bool readCheckpoint(const std::filesystem::path &pathInput, std::vector<FeaturePeak> *features)
+    {
+        std::vector<char> data;
+        if (!loadCheckpointFile(pathInput, CheckpointStage::features, sizeof(FeaturePeak), &data))
+        {
+            return false;
+        }
+        CheckpointReader reader(&data);
+        if (!reader.values(features) || !reader.complete())
+        {
+            std::cerr << "Error: the checkpoint " << pathInput << " is incomplete\n";
+            features->clear();
+            return false;
+        }
+        return true;
+    }
+
+#pragma endregion "checkpoints"
+}
@@ -17,13 +17,10 @@
 #include <sstream>   // write peaks to file
 #include <algorithm> // remove duplicates from task list
 #include <numeric>   // infinity macro, sqrt
+#include <memory>
 
 namespace qAlgorithms
 {
-    /// ### set global variables ###
-    float PPM_PRECENTROIDED = -INFINITY;         // -Infinity sets it to the default value if no user input changes it
-    float MZ_ABSOLUTE_PRECENTROIDED = -INFINITY; // see above
-
     struct logger
     {
         std::string name;
@@ -43,7 +40,7 @@ namespace qAlgorithms
         float meanDQSG;
     };
 
-    bool massTraceStable(std::vector<float> massesBin, int idxStart, int idxEnd) // @todo do this in regression
+    bool massTraceStable(std::span<const float> massesBin, int idxStart, int idxEnd) // @todo do this in regression
     {
         assert(idxEnd > idxStart);
         size_t peaksize = idxEnd - idxStart + 1;
@@ -80,6 +77,79 @@ namespace qAlgorithms
         }
         return true;
     }
+
+    // all tables of one file that are printed once processing of the file is complete
+    struct FileResults
+    {
+        std::string filename;
+        std::vector<qCentroid> centroids; // only needed to print the bins
+        EICStore bins;
+        std::vector<FeaturePeak> features;
+        std::vector<MultiRegression> components;
+        bool complete = true; // false if no features were found, only the bins are printed in that case
+    };
+
+    void printFileResults(const FileResults *results, const UserInputSettings *args)
+    {
+        const std::string &filename = results->filename;
+        if (args->printBins)
+        {
+            printBins(&results->centroids, &results->bins, args->outputPath, filename,
+                      args->silent, args->skipError, args->noOverwrite, args->printBinary,
+                      args->printCompressed);
+        }
+        if (!results->complete)
+        {
+            return;
+        }
+        if (args->printFeatCens)
+        {
+            printFeatureCentroids(&results->features, args->outputPath, filename, &results->bins,
+                                  args->printExtended, args->silent, args->skipError, args->noOverwrite, args->printBinary,
+                                  args->printCompressed);
+        }
+        if (args->printFeatures)
+        {
+            printFeatureList(&results->features, args->outputPath, filename, &results->bins,
+                             args->printExtended, args->silent, args->skipError, args->noOverwrite, args->printBinary,
+                             args->printCompressed);
+        }
+        if (args->printComponentRegs)
+        {
+            printComponentRegressions(&results->components, args->outputPath, filename,
+                                      args->printExtended, args->silent, args->skipError, args->noOverwrite, args->printBinary,
+                                      args->printCompressed);
+        }
+        if (args->printComponentBins)
+        {
+            printComponentCentroids(&results->components, &results->bins, args->outputPath, filename,
+                                    args->printExtended, args->silent, args->skipError, args->noOverwrite, args->printBinary,
+                                    args->printCompressed);
+        }
+    }
+
+    // the files that printFileResults writes for these results
+    void addResultPaths(const FileResults *results, const UserInputSettings *args,
+                        std::vector<std::filesystem::path> *paths)
+    {
+        auto add = [&](bool selected, const char *table)
+        {
+            if (selected)
+            {
+                paths->push_back(outputFilePath(args->outputPath, results->filename, table,
+                                                args->printBinary, args->printCompressed));
+            }
+        };
+        add(args->printBins, "_bins");
+        if (!results->complete)
+        {
+            return;
+        }
+        add(args->printFeatCens, "_featCen");
+        add(args->printFeatures, "_features");
+        add(args->printComponentRegs, "_components");
+        add(args->printComponentBins, "_compCens");
+    }
 }
 
 int main(int argc, char *argv[])
@@ -106,6 +176,41 @@ int main(int argc, char *argv[])
         tasklist.erase(tasklist.begin(), tasklist.begin() + userArgs.skipAhead);
     }
 
+    // files with unchanged results are removed from the task list, the hashes of all other files are kept
+    // so their cache entries can be updated once processing is complete
+    std::unique_ptr<ResultCache> cache;
+    std::vector<std::string> contentHashes;
+    if (userArgs.useCache)
+    {
+        cache = std::make_unique<ResultCache>(userArgs.outputPath, &userArgs);
+        std::vector<std::string> hashes(tasklist.size());
+#pragma omp parallel for schedule(dynamic)
+        for (size_t i = 0; i < tasklist.size(); i++)
+        {
+            hashes[i] = contentHash(tasklist[i]);
+        }
+        std::vector<std::filesystem::path> remainingTasks;
+        for (size_t i = 0; i < tasklist.size(); i++)
+        {
+            if (cache->isCurrent(hashes[i], tasklist[i].stem().string()))
+            {
+                if (userArgs.verboseProgress)
+                {
+                    std::cout << "results are up to date: " << tasklist[i] << "\n";
+                }
+                continue;
+            }
+            remainingTasks.push_back(tasklist[i]);
+            contentHashes.push_back(hashes[i]);
+        }
+        if (!userArgs.silent && remainingTasks.size() < tasklist.size())
+        {
+            std::cout << "skipping " << tasklist.size() - remainingTasks.size()
+                      << " files whose results are up to date, see -cache\n";
+        }
+        tasklist = remainingTasks;
+    }
+
     auto absoluteStart = std::chrono::high_resolution_clock::now();
 
     // Temporary diagnostics file creation, rework this into the log function?
@@ -128,13 +233,22 @@ int main(int argc, char *argv[])
         logWriter << "filename, numSpectra, numCentroids, meanDQSC, numBins, binsTooLarge, meanDQSB, numFeatures, badFeatures, meanInterpolations, meanDQSF, numComponentRegs, numComponentFeatures\n";
         logWriter.close();
     }
+    // componentisation statistics of every file, written as JSON next to the log
+    std::vector<std::pair<std::string, ComponentStats>> componentLog;
+
+    // all results are written on a separate thread. Tables are moved into the writer once no
+    // later stage needs them, which for most tables is at the end of processing a file
+    AsyncWriter writer;
 
 #pragma region file processing
     std::string filename;
     size_t counter = 1;
     size_t errorCount = 0;
-    for (std::filesystem::path pathSource : tasklist)
+    for (size_t taskIdx = 0; taskIdx < tasklist.size(); taskIdx++)
     {
+        const std::filesystem::path pathSource = tasklist[taskIdx];
+        const size_t previousErrors = errorCount;
+        std::vector<std::filesystem::path> fileOutputs; // all results written for this file, recorded in the cache
         auto timeStart = std::chrono::high_resolution_clock::now();
         if (!userArgs.silent)
         {
@@ -142,98 +256,223 @@ int main(int argc, char *argv[])
                       << pathSource << "\n... ";
         }
 
-        StreamCraft::MZML data(std::filesystem::canonical(pathSource));
-
-        if (!data.loading_result)
+        // when resuming, all data is read from the checkpoints and the input file is not parsed
+        const bool resuming = userArgs.resumeFrom != CheckpointStage::none;
+        std::unique_ptr<StreamCraft::MZML> data;
+        std::unique_ptr<SpectrumCache> spectra; // if set, the mzML is not parsed, see -spectrum-cache
+        std::string sourceHash;
+        if (!resuming && userArgs.useSpectrumCache)
         {
-            std::cerr << "Error: the file is defective.\n";
-            if (userArgs.skipError)
+            sourceHash = userArgs.useCache ? contentHashes[taskIdx] : contentHash(pathSource);
+            spectra = std::make_unique<SpectrumCache>(spectrumCachePath(pathSource), sourceHash);
+            if (!spectra->valid())
             {
-                ++counter;
-                ++errorCount;
-                continue;
+                spectra.reset();
             }
-            else
+            else if (userArgs.verboseProgress)
+            {
+                std::cout << "reading the spectra from " << spectrumCachePath(pathSource) << "\n";
+            }
+        }
+        if (!resuming && !spectra)
+        {
+            data = std::make_unique<StreamCraft::MZML>(std::filesystem::canonical(pathSource));
+
+            if (!data->loading_result)
+            {
+                std::cerr << "Error: the file is defective.\n";
+                if (userArgs.skipError)
+                {
+                    ++counter;
+                    ++errorCount;
+                    continue;
+                }
+                else
+                {
+                    writer.finish();
+                    exit(101);
+                }
+            }
+            if (userArgs.useSpectrumCache)
             {
-                exit(101);
+                // the spectra are decoded once while writing the cache and then read from it
+                if (writeSpectrumCache(data.get(), spectrumCachePath(pathSource), sourceHash))
+                {
+                    spectra = std::make_unique<SpectrumCache>(spectrumCachePath(pathSource), sourceHash);
+                }
+                if (spectra && spectra->valid())
+                {
+                    data.reset();
+                }
+                else
+                {
+                    std::cerr << "Warning: could not write the spectrum cache " << spectrumCachePath(pathSource) << "\n";
+                    spectra.reset();
+                }
             }
         }
 
         if (!userArgs.silent)
         {
-            std::cout << " file ok\n";
+            std::cout << (resuming ? " reading checkpoints\n" : " file ok\n");
         }
         // @todo find a more elegant solution for polarity switching, this one trips up clang-tidy
         bool oneProcessed = true;
+        bool checkpointFound = false;
         static bool polarities[2] = {true, false};
         for (bool polarity : polarities)
         {
             filename = pathSource.stem().string();
 #pragma region "centroiding"
-            std::vector<float> convertRT;
-            float diff_rt = 0;
-            // @todo add check if set polarity is correct
-            std::vector<CentroidPeak> *centroids = new std::vector<CentroidPeak>;
-            *centroids = findCentroids_MZML(data, convertRT, diff_rt, polarity);
-
-            if (centroids->empty())
+            // all results of centroiding that are needed later, these are stored in the first checkpoint
+            CentroidState cenState;
+            std::vector<float> &convertRT = cenState.convertRT;
+            float &diff_rt = cenState.diff_rt;
+            std::vector<qCentroid> &binThis = cenState.centroids;
+            float &minCenArea = cenState.minCenArea;
+            // only used with -online-binning, the binner is fed during centroiding if no checkpoint is used
+            std::unique_ptr<OnlineBinner> onlineBinner;
+            // only set here if processing resumes from a later checkpoint
+            EICStore binnedData;
+            std::vector<FeaturePeak> features;
+
+            if (resuming)
             {
-                if (userArgs.verboseProgress)
+                filename = filename + (polarity ? "_positive" : "_negative");
+                // no checkpoint is written if the file contains no centroids of this polarity
+                if (!std::filesystem::exists(checkpointPath(userArgs.outputPath, filename, CheckpointStage::centroids)))
                 {
-                    std::cout << "skipping mode: " << polarity << "\n";
+                    if (userArgs.verboseProgress)
+                    {
+                        std::cout << "skipping mode: " << polarity << "\n";
+                    }
+                    continue;
+                }
+                checkpointFound = true;
+                bool loaded = readCheckpoint(checkpointPath(userArgs.outputPath, filename, CheckpointStage::centroids), &cenState);
+                if (loaded && userArgs.resumeFrom >= CheckpointStage::bins)
+                {
+                    loaded = readCheckpoint(checkpointPath(userArgs.outputPath, filename, CheckpointStage::bins),
+                                            userArgs.spillDirectory, &binnedData);
+                }
+                if (loaded && userArgs.resumeFrom >= CheckpointStage::features)
+                {
+                    loaded = readCheckpoint(checkpointPath(userArgs.outputPath, filename, CheckpointStage::features), &features);
+                }
+                if (!loaded)
+                {
+                    if (!userArgs.skipError)
+                    {
+                        writer.finish();
+                        exit(1);
+                    }
+                    ++errorCount;
+                    continue;
+                }
+
+                if (!userArgs.silent)
+                {
+                    std::cout << "Processing " << (polarity ? "positive" : "negative") << " peaks\n";
                 }
-                continue;
             }
             else
             {
-                oneProcessed = true;
-            }
-            // oneProcessed is true if this is the first loop iteration or if centroids were found in the previous iteration
-            if (!oneProcessed)
-            { // @todo this is really hard to follow, change it
-                if (userArgs.skipError)
+                // @todo add check if set polarity is correct
+                ScanCallback binScan = nullptr;
+                unsigned int nextCenID = 1; // same as in passToBinning, the first centroid is a dummy value
+                std::vector<qCentroid> scanCentroids;
+                if (userArgs.onlineBinning)
                 {
-                    ++counter;
-                    ++errorCount;
+                    // every scan is binned as soon as it was centroided
+                    onlineBinner = std::make_unique<OnlineBinner>(&convertRT, userArgs.incrementalBinning);
+                    binScan = [&](std::span<const CentroidPeak> peaks)
+                    {
+                        scanCentroids.clear();
+                        for (const CentroidPeak &peak : peaks)
+                        {
+                            scanCentroids.push_back(binningCentroid(&peak, nextCenID));
+                            ++nextCenID;
+                        }
+                        onlineBinner->addScan(scanCentroids);
+                    };
+                }
+                std::vector<CentroidPeak> *centroids = new std::vector<CentroidPeak>;
+                *centroids = spectra ? findCentroids_cache(spectra.get(), convertRT, diff_rt, polarity, true, binScan)
+                                     : findCentroids_MZML(*data, convertRT, diff_rt, polarity, true, binScan);
+
+                if (centroids->empty())
+                {
+                    if (userArgs.verboseProgress)
+                    {
+                        std::cout << "skipping mode: " << polarity << "\n";
+                    }
                     continue;
                 }
                 else
                 {
-                    std::cerr << "error: no centroids were found in the file" << std::endl;
-                    exit(101);
+                    oneProcessed = true;
                 }
-            }
-            oneProcessed = false;
+                // oneProcessed is true if this is the first loop iteration or if centroids were found in the previous iteration
+                if (!oneProcessed)
+                { // @todo this is really hard to follow, change it
+                    if (userArgs.skipError)
+                    {
+                        ++counter;
+                        ++errorCount;
+                        continue;
+                    }
+                    else
+                    {
+                        std::cerr << "error: no centroids were found in the file" << std::endl;
+                        writer.finish();
+                        exit(101);
+                    }
+                }
+                oneProcessed = false;
 
-            for (size_t i = 1; i < convertRT.size() - 1; i++)
-            {
-                assert(convertRT[i] < convertRT[i + 1]);
-            }
+                for (size_t i = 1; i < convertRT.size() - 1; i++)
+                {
+                    assert(convertRT[i] < convertRT[i + 1]);
+                }
 
-            if (!userArgs.silent)
-            {
-                std::cout << "Processing " << (polarity ? "positive" : "negative") << " peaks\n";
-            }
+                if (!userArgs.silent)
+                {
+                    std::cout << "Processing " << (polarity ? "positive" : "negative") << " peaks\n";
+                }
 
-            filename = filename + (polarity ? "_positive" : "_negative");
+                filename = filename + (polarity ? "_positive" : "_negative");
 
-            if (userArgs.printCentroids)
-            {
-                printCentroids(centroids, &convertRT, userArgs.outputPath, filename, userArgs.silent, userArgs.skipError, userArgs.noOverwrite);
-            }
-            size_t centroidCount = centroids->size();
-            // @todo remove diagnostics later
-            auto binThis = passToBinning(centroids);
+                cenState.spectrumCount = spectra ? spectra->spectra().size() : data->number_spectra;
+                cenState.centroidCount = centroids->size();
+                // @todo remove diagnostics later
+                binThis = passToBinning(centroids);
 
-            // find lowest intensity among all centroids to use as baseline during componentisation
-            float minCenArea = INFINITY;
-            for (size_t cenID = 0; cenID < centroidCount; cenID++)
-            {
-                float currentInt = centroids->at(cenID).area;
-                minCenArea = minCenArea < currentInt ? minCenArea : currentInt;
-            }
+                // find lowest intensity among all centroids to use as baseline during componentisation
+                minCenArea = INFINITY;
+                for (size_t cenID = 0; cenID < cenState.centroidCount; cenID++)
+                {
+                    float currentInt = centroids->at(cenID).area;
+                    minCenArea = minCenArea < currentInt ? minCenArea : currentInt;
+                }
 
-            delete centroids;
+                if (userArgs.printCentroids)
+                {
+                    fileOutputs.push_back(outputFilePath(userArgs.outputPath, filename, "_centroids",
+                                                         userArgs.printBinary, userArgs.printCompressed));
+                    // the centroids are not needed after this point
+                    writer.submit([table = std::move(*centroids), convertRT, userArgs, filename]()
+                                  { printCentroids(&table, &convertRT, userArgs.outputPath, filename, userArgs.silent,
+                                                   userArgs.skipError, userArgs.noOverwrite, userArgs.printBinary, userArgs.printCompressed); });
+                }
+                delete centroids;
+
+                if (userArgs.writeCheckpoints &&
+                    !writeCheckpoint(checkpointPath(userArgs.outputPath, filename, CheckpointStage::centroids), &cenState))
+                {
+                    std::cerr << "Warning: could not write the centroid checkpoint for " << filename << "\n";
+                }
+            }
+            const size_t centroidCount = cenState.centroidCount;
 
             double meanDQSC = 0;
             double meanCenErrorRel = 0;
@@ -255,14 +494,63 @@ int main(int argc, char *argv[])
 
             if (!userArgs.silent)
             {
-                std::cout << "    produced " << binThis.size() - 1 << " centroids from " << data.number_spectra
-                          << " spectra in " << timePassed.count() << " s\n";
+                std::cout << (resuming ? "    loaded " : "    produced ") << binThis.size() - 1 << " centroids from "
+                          << cenState.spectrumCount << " spectra in " << timePassed.count() << " s\n";
             }
 
 #pragma region "binning"
             timeStart = std::chrono::high_resolution_clock::now();
 
-            std::vector<EIC> binnedData = performQbinning(&binThis, &convertRT, userArgs.verboseProgress);
+            if (userArgs.resumeFrom < CheckpointStage::bins)
+            {
+                BinningStats binStats;
+                std::vector<EIC> bins;
+                if (userArgs.onlineBinning)
+                {
+                    if (!onlineBinner)
+                    {
+                        // processing resumed from the centroid checkpoint, the centroids are added scan by scan.
+                        // They are sorted by scans, the dummy centroid at index 0 is not binned
+                        onlineBinner = std::make_unique<OnlineBinner>(&convertRT, userArgs.incrementalBinning);
+                        size_t scanStart = 1;
+                        for (size_t i = 2; i < binThis.size() + 1; i++)
+                        {
+                            if (i == binThis.size() || binThis[i].scanNo != binThis[scanStart].scanNo)
+                            {
+                                onlineBinner->addScan(std::span<const qCentroid>(binThis).subspan(scanStart, i - scanStart));
+                                scanStart = i;
+                            }
+                        }
+                    }
+                    bins = onlineBinner->finish(&binStats);
+                    if (userArgs.verboseProgress)
+                    {
+                        std::cout << "    closed " << onlineBinner->closedTraceCount << " mass traces\n";
+                    }
+                    onlineBinner.reset();
+                }
+                else
+                {
+                    bins = performQbinning(&binThis, &convertRT, userArgs.incrementalBinning,
+                                           &binStats, userArgs.verboseProgress);
+                }
+                if (userArgs.verboseProgress)
+                {
+                    std::cout << "    binning finished after " << binStats.iterations << " iterations, processed centroids:";
+                    for (size_t points : binStats.pointsPerIteration)
+                    {
+                        std::cout << " " << points;
+                    }
+                    std::cout << "\n";
+                }
+                // all later stages use the packed bins, the individual bins are released while they are copied
+                binnedData = EICStore(&bins, userArgs.spillDirectory);
+                if (userArgs.writeCheckpoints &&
+                    !writeCheckpoint(checkpointPath(userArgs.outputPath, filename, CheckpointStage::bins), &binnedData))
+                {
+                    std::cerr << "Warning: could not write the bin checkpoint for " << filename << "\n";
+                }
+            }
 
             timeEnd = std::chrono::high_resolution_clock::now();
 
@@ -271,6 +559,7 @@ int main(int argc, char *argv[])
                 std::cerr << "Error: no bins could be constructed from the data.\n";
                 if (!userArgs.skipError)
                 {
+                    writer.finish();
                     exit(1);
                 }
                 else
@@ -284,21 +573,18 @@ int main(int argc, char *argv[])
             if (!userArgs.silent)
             {
                 timePassed = std::chrono::duration_cast<std::chrono::milliseconds>(timeEnd - timeStart);
-                std::cout << "    assembled " << binnedData.size() << " bins in " << timePassed.count() << " s\n";
-            }
-            if (userArgs.printBins)
-            {
-                printBins(&binThis, &binnedData, userArgs.outputPath, filename, userArgs.silent, userArgs.skipError, userArgs.noOverwrite);
+                std::cout << (userArgs.resumeFrom < CheckpointStage::bins ? "    assembled " : "    loaded ")
+                          << binnedData.size() << " bins in " << timePassed.count() << " s\n";
             }
-
             // @todo remove diagnostics
             int count = 0;
             int badBinCount = 0;
             double meanDQSB = 0;
-            for (auto EIC : binnedData)
+            for (size_t binID = 0; binID < binnedData.size(); binID++)
             {
-                assert(EIC.scanNumbers.back() < convertRT.size() - 2);
-                for (double dqsb : EIC.DQSB)
+                const BinView bin = binnedData.at(binID);
+                assert(bin.scanNumbers.back() < convertRT.size() - 2);
+                for (double dqsb : bin.DQSB)
                 {
                     if (dqsb == -1)
                     {
@@ -312,12 +598,28 @@ int main(int argc, char *argv[])
             meanDQSB /= count;
 #pragma region "feature construction"
             timeStart = std::chrono::high_resolution_clock::now();
-            // every subvector of peaks corresponds to the bin ID
-            auto features = findPeaks_QBIN(binnedData, diff_rt, convertRT.size());
+            if (userArgs.resumeFrom < CheckpointStage::features)
+            {
+                // every subvector of peaks corresponds to the bin ID
+                features = findPeaks_QBIN(&binnedData, diff_rt, convertRT.size());
+                if (userArgs.writeCheckpoints &&
+                    !writeCheckpoint(checkpointPath(userArgs.outputPath, filename, CheckpointStage::features), &features))
+                {
+                    std::cerr << "Warning: could not write the feature checkpoint for " << filename << "\n";
+                }
+            }
 
             if (features.size() == 0)
             {
                 std::cout << "Warning: no features were constructed, continuing...\n";
+                if (userArgs.printBins)
+                {
+                    FileResults results{filename, std::move(binThis), std::move(binnedData), {}, {}, false};
+                    addResultPaths(&results, &userArgs, &fileOutputs);
+                    // the jobs of the writer must be copyable, but the bins can only be moved
+                    writer.submit([results = std::make_shared<FileResults>(std::move(results)), userArgs]()
+                                  { printFileResults(results.get(), &userArgs); });
+                }
                 continue;
             }
 
@@ -331,7 +633,6 @@ int main(int argc, char *argv[])
                 assert(features[i].scanPeakEnd < convertRT.size());
                 int binIdx = features[i].idxBin;
                 auto massesBin = binnedData[binIdx].mz;
-                auto scansBin = binnedData[binIdx].scanNumbers;
                 unsigned int binStart = features[i].idxBinStart;
                 unsigned int binEnd = features[i].idxBinEnd;
                 assert(binStart < massesBin.size() - 4);
@@ -363,21 +664,17 @@ int main(int argc, char *argv[])
             if (!userArgs.silent)
             {
                 timePassed = std::chrono::duration_cast<std::chrono::milliseconds>(timeEnd - timeStart);
-                std::cout << "    constructed " << features.size() << " features in " << timePassed.count() << " s\n";
+                std::cout << (userArgs.resumeFrom < CheckpointStage::features ? "    constructed " : "    loaded ")
+                          << features.size() << " features in " << timePassed.count() << " s\n";
             }
             // no fail condition here, since this case can occur with real data
 
-            if (userArgs.printFeatCens)
-            {
-                printFeatureCentroids(&features, userArgs.outputPath, filename, &binnedData,
-                                      userArgs.printExtended, userArgs.silent, userArgs.skipError, userArgs.noOverwrite);
-            }
-
 #pragma region "Componentisation"
             timeStart = std::chrono::high_resolution_clock::now();
 
-            size_t featuresInComponents = 0; // only used as a count statistic
-            const auto components = findComponents(&features, &binnedData, &convertRT, minCenArea, &featuresInComponents);
+            ComponentStats compStats;
+            auto components = findComponents(&features, &binnedData, &convertRT, minCenArea, &compStats);
+            const size_t featuresInComponents = compStats.featuresInComponents;
 
             timeEnd = std::chrono::high_resolution_clock::now();
             if (!userArgs.silent)
@@ -385,37 +682,66 @@ int main(int argc, char *argv[])
                 timePassed = std::chrono::duration_cast<std::chrono::milliseconds>(timeEnd - timeStart);
                 std::cout << "    grouped " << featuresInComponents << " features into " << components.size() << " components in " << timePassed.count() << " s\n";
             }
-
-            if (userArgs.printFeatures) // this is here so we can incorporate the component ID into the output
-            {
-                printFeatureList(&features, userArgs.outputPath, filename, &binnedData,
-                                 userArgs.printExtended, userArgs.silent, userArgs.skipError, userArgs.noOverwrite);
-            }
-
-            if (userArgs.printComponentRegs)
+            if (userArgs.verboseProgress)
             {
-                printComponentRegressions(&components, userArgs.outputPath, filename,
-                                          userArgs.printExtended, userArgs.silent, userArgs.skipError, userArgs.noOverwrite);
+                std::cout << "    compared " << compStats.pairsEnumerated - compStats.pairsRejectedRT << " of "
+                          << compStats.pairsEnumerated << " feature pairs, fitted " << compStats.regressionsFitted
+                          << " multi-regressions\n";
             }
 
-            if (userArgs.printComponentBins)
-            {
-                printComponentCentroids(&components, &binnedData, userArgs.outputPath, filename,
-                                        userArgs.printExtended, userArgs.silent, userArgs.skipError, userArgs.noOverwrite);
-            }
 
             if (userArgs.doLogging)
             {
                 logWriter.open(pathLogging, std::ios::app);
-                logWriter << filename << ", " << data.number_spectra << ", " << centroidCount << ", "
+                logWriter << filename << ", " << cenState.spectrumCount << ", " << centroidCount << ", "
                           << meanDQSC / binThis.size() << ", " << binnedData.size() << ", " << badBinCount << ", " << meanDQSB
                           << ", " << features.size() << ", " << peaksWithMassGaps << ", " << meanInterpolations << ", " << meanDQSF
                           << components.size() << ", " << featuresInComponents << "\n";
                 logWriter.close();
+                componentLog.push_back({filename, compStats});
+                printComponentStats(&componentLog, pathLogging);
+            }
+
+            // the feature list is printed after componentisation so it includes the component ID
+            if (userArgs.printBins || userArgs.printFeatCens || userArgs.printFeatures ||
+                userArgs.printComponentRegs || userArgs.printComponentBins)
+            {
+                FileResults results{filename, std::move(binThis), std::move(binnedData),
+                                    std::move(features), std::move(components), true};
+                addResultPaths(&results, &userArgs, &fileOutputs);
+                writer.submit([results = std::make_shared<FileResults>(std::move(results)), userArgs]()
+                              { printFileResults(results.get(), &userArgs); });
+            }
+        }
+        if (resuming && !checkpointFound)
+        {
+            std::cerr << "Error: no checkpoints were found for " << pathSource << " in " << userArgs.outputPath << "\n";
+            if (!userArgs.skipError)
+            {
+                writer.finish();
+                exit(1);
             }
+            ++errorCount;
+        }
+        if (cache && errorCount == previousErrors)
+        {
+            // the job runs after all print jobs of this file, so the recorded outputs are complete
+            writer.submit([&cache, hash = contentHashes[taskIdx], outputs = std::move(fileOutputs), pathSource]()
+                          {
+                if (!cache->record(hash, pathSource.stem().string(), &outputs))
+                {
+                    std::stringstream message;
+                    message << "Warning: not all results of " << pathSource << " were written, it is processed again by the next run\n";
+                    std::cerr << message.str();
+                }
+                if (!cache->save())
+                {
+                    std::cerr << "Warning: the result cache could not be updated\n";
+                } });
         }
         counter++;
     }
+    writer.finish(); // the processing time includes writing all results
 
 #pragma region "Logging and similar" // @todo add an option for custom logfile names
     auto absoluteEnd = std::chrono::high_resolution_clock::now();
@@ -74,22 +74,22 @@ namespace qAlgorithms
     }
 
     treatedData pretreatEIC(
-        EIC &eic,
+        const BinView *eic,
         float expectedDifference,
         size_t maxScan)
     {
         // @todo this function just copies data from the eic output, the respective parts of the binning
         // and feature detection module should be reworked such that it doesn't need to exist
         std::vector<dataPoint> dataPoints_internal;
-        dataPoints_internal.reserve(eic.interpolatedIDs.size());
+        dataPoints_internal.reserve(eic->interpolatedIDs.size());
 
-        assert(is_sorted(eic.rententionTimes.begin(), eic.rententionTimes.end()));
+        assert(is_sorted(eic->rententionTimes.begin(), eic->rententionTimes.end()));
 
-        for (size_t i = 0; i < eic.scanNumbers.size(); ++i)
+        for (size_t i = 0; i < eic->scanNumbers.size(); ++i)
         {
             dataPoint dp(
-                eic.rententionTimes[i],
-                eic.ints_area[i],
+                eic->rententionTimes[i],
+                eic->ints_area[i],
                 true); // the point is not interpolated
             dataPoints_internal.push_back(dp);
         }
@@ -150,7 +150,7 @@ namespace qAlgorithms
         treatedData.intensity.push_back(dataPoints_internal.back().y);
 
         // END OF BLOCK, EXTRAPOLATION STARTS @todo move this into its own function
-        assert(blockSize == eic.cenID.size());
+        assert(blockSize == eic->cenID.size());
         // add 4 datapoints (two extrapolated [end of current block] and two zeros
         // [start of next block]) extrapolate the first two datapoints of this block
 
@@ -216,11 +216,11 @@ namespace qAlgorithms
 
         assert(treatedData.dataPoints.size() == treatedData.intensity.size());
         assert(treatedData.dataPoints.back().y == treatedData.intensity.back()); // works
-        // assert(treatedData.dataPoints.size() == eic.interpolatedDQSB.size()); // @todo redo this in good
+        // assert(treatedData.dataPoints.size() == eic->interpolatedDQSB.size()); // @todo redo this in good
 
-        treatedData.cenIDs = eic.interpolatedIDs;
-        treatedData.lowestScan = eic.scanNumbers.front() - 2;
-        treatedData.largestScan = eic.scanNumbers.back() + 2;
+        treatedData.cenIDs.assign(eic->interpolatedIDs.begin(), eic->interpolatedIDs.end());
+        treatedData.lowestScan = eic->scanNumbers.front() - 2;
+        treatedData.largestScan = eic->scanNumbers.back() + 2;
         // assert(binIdx.size() == treatedData.largestScan - treatedData.lowestScan + 1 + 4); // extrapolations
         treatedData.cumulativeDF.reserve(treatedData.dataPoints.size());
         treatedData.cumulativeDF.push_back(0);
@@ -235,15 +235,15 @@ namespace qAlgorithms
         return treatedData;
     }
 
-    std::vector<FeaturePeak> findPeaks_QBIN(std::vector<EIC> &EICs, float rt_diff, size_t maxScan)
+    std::vector<FeaturePeak> findPeaks_QBIN(const EICStore *EICs, float rt_diff, size_t maxScan)
     {
         std::vector<FeaturePeak> peaks;    // return vector for feature list
-        peaks.reserve(EICs.size() / 4);    // should be enough to fit all features without reallocation
+        peaks.reserve(EICs->size() / 4);   // should be enough to fit all features without reallocation
         std::vector<FeaturePeak> tmpPeaks; // add features to this before pasting into FL
 
-        for (size_t i = 0; i < EICs.size(); ++i)
+        for (size_t i = 0; i < EICs->size(); ++i)
         {
-            auto currentEIC = EICs[i];
+            const BinView currentEIC = EICs->at(i);
             if (currentEIC.scanNumbers.size() < 5)
             {
                 continue; // skip due to lack of data, i.e., degrees of freedom will be zero
@@ -253,7 +253,7 @@ namespace qAlgorithms
             //     continue;
             // }
 
-            treatedData treatedData = pretreatEIC(currentEIC, rt_diff, maxScan); // inter/extrapolate data, and identify data blocks
+            treatedData treatedData = pretreatEIC(&currentEIC, rt_diff, maxScan); // inter/extrapolate data, and identify data blocks
             findFeatures(tmpPeaks, treatedData);
             if (tmpPeaks.empty())
             {
@@ -310,14 +310,14 @@ namespace qAlgorithms
                 currentPeak.idxBinStart = limit_L;
                 currentPeak.idxBinEnd = limit_R;
 
-                auto tmp = weightedMeanAndVariance_EIC(&currentEIC.ints_area, &currentEIC.mz,
+                auto tmp = weightedMeanAndVariance_EIC(currentEIC.ints_area, currentEIC.mz,
                                                        limit_L, limit_R);
                 currentPeak.mz = tmp.mean;
                 currentPeak.mzUncertainty = tmp.var;
-                currentPeak.DQSC = weightedMeanAndVariance_EIC(&currentEIC.ints_area, &currentEIC.DQSC,
+                currentPeak.DQSC = weightedMeanAndVariance_EIC(currentEIC.ints_area, currentEIC.DQSC,
                                                                limit_L, limit_R)
                                        .mean;
-                currentPeak.DQSB = weightedMeanAndVariance_EIC(&currentEIC.ints_area, &currentEIC.DQSB,
+                currentPeak.DQSB = weightedMeanAndVariance_EIC(currentEIC.ints_area, currentEIC.DQSB,
                                                                limit_L, limit_R)
                                        .mean;
                 peaks.push_back(std::move(currentPeak)); // remove 2D structure of FL
@@ -377,10 +377,10 @@ namespace qAlgorithms
         return centroids;
     }
 
-    double calcExpectedDiff(const std::vector<std::vector<double>> *spectrum)
+    double calcExpectedDiff(const SpectrumArrays spectrum)
     {
-        const std::vector<double> mz = spectrum->at(0); // @todo make this a named struct
-        const std::vector<double> intensity = spectrum->at(1);
+        const std::span<const double> mz = spectrum.mz;
+        const std::span<const double> intensity = spectrum.intensity;
         const size_t numPoints = mz.size();         // number of data points
         const size_t upperLimit = numPoints * 0.05; // check lowest 5% for expected difference
         double expectedDifference = 0.0;
@@ -414,33 +414,26 @@ namespace qAlgorithms
         return sum / (retention_times->size() - 1);
     }
 
-    std::vector<CentroidPeak> findCentroids_MZML( // this function needs to be split @todo
-        StreamCraft::MZML &data,
+    // source-independent part of findCentroids_MZML and findCentroids_cache. The metadata contains one entry
+    // per spectrum, retention times and arrays are requested by the position of the spectrum in the metadata.
+    // getSpectrum may use the buffer to store the arrays, they are only accessed until the next call.
+    // scanFinished is called with the centroids of every spectrum once it is processed, if it is set.
+    template <typename GetRT, typename GetSpectrum>
+    static std::vector<CentroidPeak> centroidSpectra(
+        const std::vector<bool> *spectrum_mode,
+        const std::vector<int> *ms_levels,
+        const std::vector<bool> *spectrum_polarity,
+        GetRT getRT,             // std::vector<double>(const std::vector<unsigned int> *positions)
+        GetSpectrum getSpectrum, // SpectrumArrays(unsigned int position, std::vector<std::vector<double>> *buffer)
         std::vector<float> &convertRT,
         float &rt_diff,
         const bool polarity,
-        const bool ms1only)
+        const bool ms1only,
+        const ScanCallback &scanFinished)
     {
-        // this is only relevant when reading in pre-centroided data
-        // bool displayPPMwarning = false;
-        // if (PPM_PRECENTROIDED == -INFINITY)
-        // {
-        //     PPM_PRECENTROIDED = 0.25; // global variable, this is a bad solution @todo
-        // }
-        // else
-        // {
-        //     displayPPMwarning = true;
-        // }
-
-        // accessor contains the indices of all spectra that should be fetched
-        std::vector<unsigned int> accessor(data.number_spectra, 0);
-        std::iota(accessor.begin(), accessor.end(), 0);
-
-        std::vector<bool> spectrum_mode = data.get_spectra_mode(&accessor); // get spectrum mode (centroid or profile)
-
         // CHECK IF CENTROIDED SPECTRA
-        size_t num_centroided_spectra = std::count(spectrum_mode.begin(), spectrum_mode.end(), false);
-        if (num_centroided_spectra > spectrum_mode.size() / 2) // in profile mode sometimes centroided spectra appear as well @todo is 2 a good idea?
+        size_t num_centroided_spectra = std::count(spectrum_mode->begin(), spectrum_mode->end(), false);
+        if (num_centroided_spectra > spectrum_mode->size() / 2) // in profile mode sometimes centroided spectra appear as well @todo is 2 a good idea?
         {
             std::cerr << "Centroided data is not supported in this version of qAlgorithms!\n";
             //   << "Warning: qAlgorithms is intended for profile spectra. A base uncertainty of "
@@ -469,32 +462,29 @@ namespace qAlgorithms
             std::cerr << "Warning: removed " << num_centroided_spectra << " centroided spectra from measurement.\n";
         }
 
-        std::vector<size_t> indices = data.get_spectra_index(&accessor); // get all indices
-        std::vector<int> ms_levels = data.get_spectra_level(&accessor);  // get all MS levels
-        assert(!indices.empty());
+        assert(!ms_levels->empty());
 
-        std::vector<unsigned int> selectedIndices;
-        selectedIndices.reserve(indices.size());
+        std::vector<unsigned int> selectedIndices; // positions of the selected spectra
+        selectedIndices.reserve(ms_levels->size());
 
-        std::vector<bool> spectrum_polarity = data.get_spectra_polarity(&accessor); // get spectrum polarity (positive or negative)
-        for (size_t i = 0; i < indices.size(); i++)
+        for (size_t i = 0; i < ms_levels->size(); i++)
         {
-            if (ms1only && ms_levels[i] != 1)
+            if (ms1only && (*ms_levels)[i] != 1)
             {
                 continue;
             }
-            if (spectrum_polarity[i] != polarity)
+            if ((*spectrum_polarity)[i] != polarity)
             {
                 continue;
             }
-            selectedIndices.push_back(indices[i]);
+            selectedIndices.push_back(i);
         }
         if (selectedIndices.empty())
         {
             return std::vector<CentroidPeak>{};
         }
 
-        std::vector<double> retention_times = data.get_spectra_RT(&selectedIndices);
+        std::vector<double> retention_times = getRT(&selectedIndices);
         rt_diff = calcRTDiff(&retention_times);
 
         selectedIndices.shrink_to_fit();
@@ -504,7 +494,8 @@ namespace qAlgorithms
         centroids.reserve(countSelected * 1000);
 
         // take spectrum at half length to avoid potential interference from quality control scans in the instrument
-        const std::vector<std::vector<double>> data_vec = data.get_spectrum(selectedIndices[countSelected / 2]);
+        std::vector<std::vector<double>> buffer;
+        const double expectedDifference_mz = calcExpectedDiff(getSpectrum(selectedIndices[countSelected / 2], &buffer));
 
         // determine where the peak finding will interpolate points and pass this information
         // to the binning step. addEmpty contains the number of empty scans to be added into
@@ -570,13 +561,11 @@ namespace qAlgorithms
         convertRT.push_back(retention_times.back() + rt_diff + rt_diff);
         assert(convertRT.size() == abstractScanNumber); // ensure that every index has an assigned RT
 
-        // expected difference between two consecutive x-axis values
-        double expectedDifference_mz = calcExpectedDiff(&data_vec);
         for (size_t i = 0; i < countSelected; ++i)
         {
-            const std::vector<std::vector<double>> spectrum = data.get_spectrum(selectedIndices[i]);
+            const SpectrumArrays spectrum = getSpectrum(selectedIndices[i], &buffer);
             // inter/extrapolate data, and identify data blocks @todo these should be two different functions
-            const auto treatedData = pretreatDataCentroids(&spectrum, expectedDifference_mz);
+            const auto treatedData = pretreatDataCentroids(spectrum, expectedDifference_mz);
             // if (treatedData.empty())
             // {
             //     std::cout << "Warning: no centroids found in spectrum " << i << ".\n";
@@ -584,6 +573,10 @@ namespace qAlgorithms
             assert(relativeIndex[i] != 0);
             auto tmpCens = findCentroids(&treatedData, relativeIndex[i]); // find peaks in data blocks of treated data
             centroids.insert(centroids.end(), tmpCens.begin(), tmpCens.end());
+            if (scanFinished)
+            {
+                scanFinished(tmpCens);
+            }
         }
         // if (!displayPPMwarning)
         // {
@@ -592,6 +585,79 @@ namespace qAlgorithms
         return centroids;
     }
 
+    std::vector<CentroidPeak> findCentroids_MZML( // this function needs to be split @todo
+        StreamCraft::MZML &data,
+        std::vector<float> &convertRT,
+        float &rt_diff,
+        const bool polarity,
+        const bool ms1only,
+        const ScanCallback &scanFinished)
+    {
+        // accessor contains the indices of all spectra that should be fetched
+        std::vector<unsigned int> accessor(data.number_spectra, 0);
+        std::iota(accessor.begin(), accessor.end(), 0);
+
+        std::vector<bool> spectrum_mode = data.get_spectra_mode(&accessor);         // get spectrum mode (centroid or profile)
+        std::vector<size_t> indices = data.get_spectra_index(&accessor);            // get all indices
+        std::vector<int> ms_levels = data.get_spectra_level(&accessor);             // get all MS levels
+        std::vector<bool> spectrum_polarity = data.get_spectra_polarity(&accessor); // get spectrum polarity (positive or negative)
+
+        // the spectra are accessed by their index, which is not necessarily their position in the file
+        auto getRT = [&data, &indices](const std::vector<unsigned int> *positions)
+        {
+            std::vector<unsigned int> selectedIndices;
+            selectedIndices.reserve(positions->size());
+            for (unsigned int position : *positions)
+            {
+                selectedIndices.push_back(indices[position]);
+            }
+            return data.get_spectra_RT(&selectedIndices);
+        };
+        auto getSpectrum = [&data, &indices](unsigned int position, std::vector<std::vector<double>> *buffer)
+        {
+            *buffer = data.get_spectrum(indices[position]);
+            return SpectrumArrays{buffer->at(0), buffer->at(1)};
+        };
+        return centroidSpectra(&spectrum_mode, &ms_levels, &spectrum_polarity, getRT, getSpectrum,
+                               convertRT, rt_diff, polarity, ms1only, scanFinished);
+    }
+
+    std::vector<CentroidPeak> findCentroids_cache(
+        const SpectrumCache *cache,
+        std::vector<float> &convertRT,
+        float &rt_diff,
+        const bool polarity,
+        const bool ms1only,
+        const ScanCallback &scanFinished)
+    {
+        const std::span<const SpectrumEntry> spectra = cache->spectra();
+        std::vector<bool> spectrum_mode(spectra.size());
+        std::vector<int> ms_levels(spectra.size());
+        std::vector<bool> spectrum_polarity(spectra.size());
+        for (size_t i = 0; i < spectra.size(); i++)
+        {
+            spectrum_mode[i] = spectra[i].profile != 0;
+            ms_levels[i] = spectra[i].level;
+            spectrum_polarity[i] = spectra[i].positive != 0;
+        }
+
+        auto getRT = [&spectra](const std::vector<unsigned int> *positions)
+        {
+            std::vector<double> retentionTimes;
+            retentionTimes.reserve(positions->size());
+            for (unsigned int position : *positions)
+            {
+                retentionTimes.push_back(spectra[position].retentionTime);
+            }
+            return retentionTimes;
+        };
+        // the arrays are read directly from the cache
+        auto getSpectrum = [cache](unsigned int position, std::vector<std::vector<double>> *)
+        { return cache->spectrum(position); };
+        return centroidSpectra(&spectrum_mode, &ms_levels, &spectrum_polarity, getRT, getSpectrum,
+                               convertRT, rt_diff, polarity, ms1only, scanFinished);
+    }
+
     constexpr ProfileBlock blockStart()
     {
         ProfileBlock p;
@@ -601,7 +667,7 @@ namespace qAlgorithms
         return p;
     }
 
-    std::vector<ProfileBlock> pretreatDataCentroids(const std::vector<std::vector<double>> *spectrum, float expectedDifference)
+    std::vector<ProfileBlock> pretreatDataCentroids(const SpectrumArrays spectrum, float expectedDifference)
     {
         // note on double precision values: when using floats, results are different enough
         // to cause different behaviour for interpolation and block termination. Doubles are
@@ -609,18 +675,18 @@ namespace qAlgorithms
         // account otherwise. Around 1000 centroids less than otherwise are produced for test cases.
         std::vector<double> intensities_profile;
         std::vector<double> mz_profile;
-        const auto mz = spectrum->at(0);
+        const std::span<const double> mz = spectrum.mz;
         intensities_profile.reserve(mz.size() / 2);
         mz_profile.reserve(mz.size() / 2);
         // Depending on the vendor, a profile contains a lot of points with intensity 0.
         // These were added by the vendor software and must be removed prior to processing.
         for (size_t i = 0; i < mz.size(); ++i)
         {
-            if (spectrum->at(1)[i] == 0.0)
+            if (spectrum.intensity[i] == 0.0)
             {
                 continue; // skip values with no intensity @todo minimum intensity?
             }
-            intensities_profile.push_back(spectrum->at(1)[i]);
+            intensities_profile.push_back(spectrum.intensity[i]);
             mz_profile.push_back(mz[i]);
         }
         assert(!intensities_profile.empty());
@@ -1,6 +1,7 @@
 #include "qalgorithms_qbin.h"
 #include "qalgorithms_global_vars.h"
 
+#include <array>
 #include <cassert>
 #include <iostream> // error printing
 #include <vector>
@@ -14,11 +15,11 @@ namespace qAlgorithms
     const size_t maxdist = 3; // this is the maximum distance in scans which can later be interpolated during feature detection
 
     std::vector<EIC> performQbinning(const std::vector<qCentroid> *centroidedData,
-                                     const std::vector<float> *convertRT, bool verbose)
+                                     const std::vector<float> *convertRT,
+                                     bool incremental, BinningStats *stats, bool verbose)
     {
         // std::cout << sizeof(Bin) << std::endl;
         assert(centroidedData->front().mz == 0); // first value is dummy
-        std::string logger = "";
 
         BinContainer activeBins;
         Bin firstBin;
@@ -28,13 +29,54 @@ namespace qAlgorithms
         }
         activeBins.processBinsF.push_back(firstBin);
 
+        std::string logger = repeatBinning(activeBins, incremental, centroidedData->size(), stats);
+
+        std::vector<EIC> finalBins = finaliseBins(activeBins, convertRT);
+        size_t countPointsInBins = 0;
+        for (const EIC &eic : finalBins)
+        {
+            countPointsInBins += eic.layout.length;
+        }
+        assert(countPointsInBins + activeBins.notInBins.size() == centroidedData->size());
+        return finalBins;
+    }
+
+    std::string repeatBinning(BinContainer &activeBins, bool incremental, size_t idCount, BinningStats *stats)
+    {
+        std::string logger = "";
         // rebinning is not separated into a function
         // binning is repeated until the input length is constant
         size_t prevFinal = 0;
+        stats->iterations = 0;
+        stats->pointsPerIteration.clear();
+        // incremental binning: mz regions in which bins were formed or points were removed from bins
+        std::vector<std::pair<double, double>> dirtyRegions;
+        // iteration in which a point was last moved from notInBins into a bin for subsetting. If it
+        // returns to notInBins during the same iteration, the region it is in did not change.
+        std::vector<size_t> lastSubset(incremental ? idCount : 0, 0);
         while (true) // @todo prove that this loop always terminates
         {
+            stats->iterations++;
+            size_t processedPoints = 0;
+            for (const Bin &bin : activeBins.processBinsF)
+            {
+                processedPoints += bin.pointsInBin.size();
+            }
+            stats->pointsPerIteration.push_back(processedPoints);
+            const size_t knownUnbinned = activeBins.notInBins.size();
+
             logger += subsetBins(activeBins);
             size_t producedBins = activeBins.viableBins.size();
+            if (incremental)
+            {
+                for (const Bin &bin : activeBins.viableBins)
+                {
+                    auto limits = std::minmax_element(bin.pointsInBin.begin(), bin.pointsInBin.end(),
+                                                      [](const qCentroid *lhs, const qCentroid *rhs)
+                                                      { return lhs->mz < rhs->mz; });
+                    dirtyRegions.push_back({(*limits.first)->mz, (*limits.second)->mz});
+                }
+            }
             // if the same amount of bins as in the previous operation was found,
             // the process is considered complete
             // in the current configuration, rebinning takes three times as long
@@ -64,6 +106,35 @@ namespace qAlgorithms
                 break;
             }
             prevFinal = activeBins.finalBins.size();
+            if (incremental)
+            {
+                // points which did not return from their own region of notInBins are new there
+                for (size_t i = knownUnbinned; i < activeBins.notInBins.size(); i++)
+                {
+                    const qCentroid *point = activeBins.notInBins[i];
+                    if (lastSubset[point->cenID] != stats->iterations)
+                    {
+                        dirtyRegions.push_back({point->mz, point->mz});
+                    }
+                }
+                const size_t dedupCount = activeBins.processBinsF.size();
+                size_t movedPoints = collectDirtyRegions(activeBins, dirtyRegions);
+                for (size_t i = dedupCount; i < activeBins.processBinsF.size(); i++)
+                {
+                    for (const qCentroid *point : activeBins.processBinsF[i].pointsInBin)
+                    {
+                        lastSubset[point->cenID] = stats->iterations + 1;
+                    }
+                }
+                logger += "| " + std::to_string(movedPoints) + " of " +
+                          std::to_string(movedPoints + activeBins.notInBins.size()) + "\n";
+                dirtyRegions.clear();
+                if (activeBins.processBinsF.empty())
+                {
+                    break;
+                }
+                continue;
+            }
             // only perform rebinning if at least one new bin could be formed
             if (activeBins.notInBins.size() > 4)
             {
@@ -80,6 +151,10 @@ namespace qAlgorithms
                 // int rebinCount = selectRebin(&activeBins, centroidedData, maxdist);
                 // @todo logging
             }
+            if (activeBins.processBinsF.empty())
+            {
+                break; // no deduplicated bins and too few unbinned points remain
+            }
         }
         // no change in bin result, so all remaining bins cannot be coerced into a valid state
         if (!activeBins.processBinsF.empty())
@@ -106,36 +181,73 @@ namespace qAlgorithms
             activeBins.processBinsT.clear();
         }
 
+        return logger;
+    }
+
+    std::vector<EIC> finaliseBins(BinContainer &activeBins, const std::vector<float> *convertRT)
+    {
         // calculate the DQSB as the silhouette score, considering only non-separated points
         std::sort(activeBins.notInBins.begin(), activeBins.notInBins.end(), [](const qCentroid *lhs, const qCentroid *rhs)
                   { return lhs->mz < rhs->mz; });
 
-        // setting start position to 0 at this point means that it can be reused, since it is incremented in makeDQSB
-        size_t shared_idxStart = 0;
-        for (size_t i = 0; i < activeBins.finalBins.size(); i++)
+        // every bin only reads from the mz-sorted notInBins and finds its lower index through
+        // binary search, so all bins can be scored independently of each other
+        const size_t binCount = activeBins.finalBins.size();
+#pragma omp parallel for schedule(dynamic)
+        for (size_t i = 0; i < binCount; i++)
         {
-            shared_idxStart = activeBins.finalBins[i].makeDQSB(&activeBins.notInBins, shared_idxStart);
+            activeBins.finalBins[i].makeDQSB(&activeBins.notInBins, 0);
         }
 
         // @todo add bin merger for halved bins here ; this ight be a bad idea, find way to prove it
 
-        std::vector<EIC> finalBins;
-        size_t binCount = activeBins.finalBins.size();
-        finalBins.reserve(binCount);
-        size_t countPointsInBins = 0;
+        std::vector<EIC> finalBins(binCount);
+#pragma omp parallel for schedule(dynamic)
         for (size_t i = 0; i < binCount; i++)
         {
-            finalBins.push_back(activeBins.finalBins[i].createEIC(convertRT));
-            countPointsInBins += finalBins[i].scanNumbers.size();
+            finalBins[i] = activeBins.finalBins[i].createEIC(convertRT);
         }
-        assert(countPointsInBins + activeBins.notInBins.size() == centroidedData->size());
         return finalBins;
     }
 
+    void writeDQSB(EIC *eic, const std::vector<float> *DQSB)
+    {
+        std::span<const unsigned int> scanNumbers = eic->scanNumbers();
+        std::span<float> interpolatedDQSB = eic->interpolatedDQSB();
+        assert(DQSB->size() == scanNumbers.size());
+        std::copy(DQSB->begin(), DQSB->end(), eic->DQSB().begin());
+        std::fill(interpolatedDQSB.begin(), interpolatedDQSB.end(), 0); // score = 0 suffices as sign of interpolation
+        for (size_t i = 0; i < scanNumbers.size(); i++)
+        {
+            interpolatedDQSB[scanNumbers[i] - scanNumbers[0] + 2] = (*DQSB)[i]; // first two elements are empty for extrapolation
+        }
+    }
+
 #pragma region "misc"
 
+    // the critical value only depends on n apart from the uncertainty, so the n-dependent
+    // factor is precalculated for all bin sizes that occur during subsetting of realistic data
+    constexpr size_t CRITVAL_TABLE_SIZE = 2048;
+
+    constexpr std::array<double, CRITVAL_TABLE_SIZE> initCritValFactors()
+    {
+        std::array<double, CRITVAL_TABLE_SIZE> factors;
+        factors[0] = INFINITY; // log(1) = 0, a bin of size 0 can never be split
+        for (size_t n = 1; n < CRITVAL_TABLE_SIZE; n++)
+        {
+            factors[n] = OS_CRIT_A + (OS_CRIT_B / std::sqrt(std::log(n + 1)));
+        }
+        return factors;
+    }
+
+    constexpr auto CRITVAL_FACTORS = initCritValFactors();
+
     const double binningCritVal(size_t n, double stdDev)
     {
+        if (n < CRITVAL_TABLE_SIZE) [[likely]]
+        {
+            return CRITVAL_FACTORS[n] * stdDev;
+        }
         return (OS_CRIT_A + (OS_CRIT_B / std::sqrt(std::log(n + 1)))) * stdDev;
     }
 
@@ -221,6 +333,57 @@ namespace qAlgorithms
         return logOutput;
     }
 
+    size_t collectDirtyRegions(BinContainer &bincontainer, std::vector<std::pair<double, double>> &dirtyRegions)
+    {
+        std::vector<const qCentroid *> &notInBins = bincontainer.notInBins;
+        if (notInBins.size() < 5 || dirtyRegions.empty())
+        {
+            return 0;
+        }
+        std::sort(notInBins.begin(), notInBins.end(), [](const qCentroid *lhs, const qCentroid *rhs)
+                  { return lhs->mz < rhs->mz; });
+        std::sort(dirtyRegions.begin(), dirtyRegions.end());
+
+        std::vector<const qCentroid *> cleanPoints;
+        cleanPoints.reserve(notInBins.size());
+        size_t movedPoints = 0;
+        size_t regionStart = 0;
+        size_t dirtyIdx = 0;
+        for (size_t i = 1; i < notInBins.size() + 1; i++)
+        {
+            if (i != notInBins.size())
+            {
+                // the critical value for five points is the largest possible gap within any bin
+                double gap = notInBins[i]->mz - notInBins[i - 1]->mz;
+                double maxError = std::max(notInBins[i]->mzError, notInBins[i - 1]->mzError);
+                if (gap < binningCritVal(5, maxError))
+                {
+                    continue;
+                }
+            }
+            // notInBins[regionStart] to notInBins[i - 1] form a region that can be subset on its own
+            const double mzLow = notInBins[regionStart]->mz;
+            const double mzHigh = notInBins[i - 1]->mz;
+            while (dirtyIdx < dirtyRegions.size() && dirtyRegions[dirtyIdx].second < mzLow)
+            {
+                dirtyIdx++;
+            }
+            bool dirty = dirtyIdx < dirtyRegions.size() && dirtyRegions[dirtyIdx].first <= mzHigh;
+            if (dirty && i - regionStart > 4)
+            {
+                bincontainer.processBinsF.push_back(Bin(notInBins.begin() + regionStart, notInBins.begin() + i));
+                movedPoints += i - regionStart;
+            }
+            else
+            {
+                cleanPoints.insert(cleanPoints.end(), notInBins.begin() + regionStart, notInBins.begin() + i);
+            }
+            regionStart = i;
+        }
+        notInBins = std::move(cleanPoints);
+        return movedPoints;
+    }
+
     void deduplicateBin(std::vector<Bin> *target, std::vector<const qCentroid *> *notInBins, Bin bin)
     {
         assert(bin.duplicateScan);
@@ -473,7 +636,7 @@ namespace qAlgorithms
     {
         // assume that bins are separated well enough that any gap of this size is close to perfect
         // separation already, so score = 1
-        assert(idx_lowerLimit < notInBins->size());
+        assert(notInBins->empty() || idx_lowerLimit < notInBins->size());
         float mz_hardLimit = std::max(0.1, this->mzMax * 10e-5);
         if (this->mzMax - this->mzMin > mz_hardLimit)
         {
@@ -489,7 +652,8 @@ namespace qAlgorithms
         size_t expandedDist = maxdist + 2; // always consider points one past the gap to account for potentially bad separation
         this->DQSB_base.clear();
 
-        if (notInBins->back()->mz < this->mzMin - mz_hardLimit ||
+        if (notInBins->empty() || // possible during online binning, which does not add the dummy centroid
+            notInBins->back()->mz < this->mzMin - mz_hardLimit ||
             notInBins->front()->mz > this->mzMax + mz_hardLimit)
         {
             // no points are within range, perfect score
@@ -499,22 +663,16 @@ namespace qAlgorithms
             return idx_lowerLimit;
         }
 
-        // @todo we can use SIMD here with relatively little effort
-        for (; idx_lowerLimit < notInBins->size(); idx_lowerLimit++)
-        {
-            if ((*notInBins)[idx_lowerLimit]->mz > this->mzMin - mz_hardLimit)
-            {
-                break;
-            }
-        }
-        size_t idx_upperLimit = idx_lowerLimit;
-        for (; idx_upperLimit < notInBins->size(); idx_upperLimit++)
-        {
-            if ((*notInBins)[idx_upperLimit]->mz > this->mzMax + mz_hardLimit)
-            {
-                break;
-            }
-        }
+        // notInBins is sorted by mz, so the relevant region can be found through binary search
+        auto lowerLimit = std::lower_bound(notInBins->begin() + idx_lowerLimit, notInBins->end(), this->mzMin - mz_hardLimit,
+                                           [](const qCentroid *cen, const double mz)
+                                           { return cen->mz <= mz; });
+        auto upperLimit = std::lower_bound(lowerLimit, notInBins->end(), this->mzMax + mz_hardLimit,
+                                           [](const qCentroid *cen, const double mz)
+                                           { return cen->mz <= mz; });
+        idx_lowerLimit = std::distance(notInBins->begin(), lowerLimit);
+        size_t idx_upperLimit = std::distance(notInBins->begin(), upperLimit);
+
         // all points with a sensible mass distance are between the two indices
         // continue by moving all points within a relevant scan region into a separate vector
         std::vector<const qCentroid *> scoreRegion;
@@ -522,7 +680,7 @@ namespace qAlgorithms
         size_t lowestPossibleScan = this->scanMin > expandedDist ? this->scanMin - expandedDist : 0;
         for (size_t i = idx_lowerLimit; i < idx_upperLimit; i++)
         {
-            if ((*notInBins)[i]->scanNo > lowestPossibleScan && // cast to int due to negative being possible
+            if ((*notInBins)[i]->scanNo > lowestPossibleScan &&
                 (*notInBins)[i]->scanNo < this->scanMax + expandedDist)
             {
                 // centroid is within maxdist and relevant mz region. However,
@@ -530,37 +688,64 @@ namespace qAlgorithms
                 scoreRegion.push_back((*notInBins)[i]);
             }
         }
+        // sort by scan and mz, so that every scan forms a block of ascending mz values
         std::sort(scoreRegion.begin(), scoreRegion.end(), [](const qCentroid *lhs, const qCentroid *rhs)
-                  { return lhs->scanNo < rhs->scanNo; });
+                  { return lhs->scanNo < rhs->scanNo || (lhs->scanNo == rhs->scanNo && lhs->mz < rhs->mz); });
+        // start index of every scan block, the last entry is the end of scoreRegion
+        std::vector<size_t> scanBlocks;
+        for (size_t i = 0; i < scoreRegion.size(); i++)
+        {
+            if (i == 0 || scoreRegion[i]->scanNo != scoreRegion[i - 1]->scanNo)
+            {
+                scanBlocks.push_back(i);
+            }
+        }
+        const size_t blockCount = scanBlocks.size();
+        scanBlocks.push_back(scoreRegion.size());
+
+        // process the bin in order of scans so that the window of relevant scan blocks
+        // only ever moves forward. The bin is usually sorted by scans already.
+        std::vector<size_t> binOrder(this->pointsInBin.size());
+        std::iota(binOrder.begin(), binOrder.end(), 0);
+        std::stable_sort(binOrder.begin(), binOrder.end(), [this](const size_t lhs, const size_t rhs)
+                         { return this->pointsInBin[lhs]->scanNo < this->pointsInBin[rhs]->scanNo; });
 
         // calculate minimum outer distance
         std::vector<float> minOuterDistances(this->pointsInBin.size());
-        // calc distance for every possible scan number to simplify algorithm
-        for (size_t i = 0; i < this->pointsInBin.size(); i++)
+        size_t windowStart = 0; // first scan block within the window
+        size_t windowEnd = 0;   // first scan block after the window
+        for (const size_t i : binOrder)
         {
-            int activeScan = this->pointsInBin[i]->scanNo;
-            float activeMZ = this->pointsInBin[i]->mz;
-            float currentMin = INFINITY;
-            size_t readVal = 0;
-            // advance until first point within maxdist + 1 of scan
-            // @todo replace with binary search
-            for (; readVal < scoreRegion.size(); readVal++)
+            const size_t activeScan = this->pointsInBin[i]->scanNo;
+            const float activeMZ = this->pointsInBin[i]->mz;
+            // window contains all scans in (activeScan - expandedDist, activeScan + expandedDist]
+            while (windowStart < blockCount &&
+                   scoreRegion[scanBlocks[windowStart]]->scanNo + expandedDist <= activeScan)
             {
-                if (scoreRegion[readVal]->scanNo > activeScan - expandedDist)
-                {
-                    break;
-                }
+                windowStart++;
             }
-            for (; readVal < scoreRegion.size(); readVal++)
+            windowEnd = std::max(windowStart, windowEnd);
+            while (windowEnd < blockCount &&
+                   scoreRegion[scanBlocks[windowEnd]]->scanNo <= activeScan + expandedDist)
             {
-                if (scoreRegion[readVal]->scanNo > activeScan + expandedDist)
+                windowEnd++;
+            }
+            double currentMin = INFINITY;
+            for (size_t block = windowStart; block < windowEnd; block++)
+            {
+                // only the two points closest to activeMZ can be the minimum within one scan
+                auto blockStart = scoreRegion.begin() + scanBlocks[block];
+                auto blockEnd = scoreRegion.begin() + scanBlocks[block + 1];
+                auto closest = std::lower_bound(blockStart, blockEnd, activeMZ,
+                                                [](const qCentroid *cen, const double mz)
+                                                { return cen->mz < mz; });
+                if (closest != blockEnd)
                 {
-                    break;
+                    currentMin = std::min(currentMin, (*closest)->mz - activeMZ);
                 }
-                float distanceMZ = abs(scoreRegion[readVal]->mz - activeMZ);
-                if (distanceMZ < currentMin)
+                if (closest != blockStart)
                 {
-                    currentMin = distanceMZ;
+                    currentMin = std::min(currentMin, activeMZ - (*(closest - 1))->mz);
                 }
             }
             if (currentMin == 0)
@@ -592,72 +777,49 @@ namespace qAlgorithms
 
     EIC Bin::createEIC(const std::vector<float> *convertRT)
     {
-        size_t eicsize = pointsInBin.size();
-
-        std::vector<unsigned int> tmp_scanNumbers;
-        tmp_scanNumbers.reserve(eicsize);
-        std::vector<float> tmp_rt;
-        tmp_rt.reserve(eicsize);
-        std::vector<float> tmp_mz;
-        tmp_mz.reserve(eicsize);
-        std::vector<float> tmp_predInterval;
-        tmp_predInterval.reserve(eicsize);
-        std::vector<float> tmp_ints_area;
-        tmp_ints_area.reserve(eicsize);
-        std::vector<float> tmp_ints_height;
-        tmp_ints_height.reserve(eicsize);
-        std::vector<unsigned int> tmp_df;
-        tmp_df.reserve(eicsize);
-        std::vector<float> tmp_DQSC;
-        tmp_DQSC.reserve(eicsize);
-        std::vector<unsigned int> tmp_cenID;
-        tmp_cenID.reserve(eicsize);
-
         std::sort(pointsInBin.begin(), pointsInBin.end(), [](const qCentroid *lhs, const qCentroid *rhs)
                   { return lhs->scanNo < rhs->scanNo; });
 
         // number of points needed during feature detection, two on each side for extrapolation and one per scan between both ends
         size_t firstScan = pointsInBin.front()->scanNo;
         size_t binSpan = pointsInBin.back()->scanNo - firstScan + 5;
-        std::vector<size_t> interpolatedCens(binSpan, 0); // all points left at 0 are later interpolated since cenID = 0 doesn't exist
-        std::vector<float> interpolatedDQSB(binSpan, 0);
-        bool interpolations = !(pointsInBin.size() + 4 == binSpan);
+
+        // all columns are written directly into the buffer of the EIC
+        EIC eic(EICLayout{pointsInBin.size(), binSpan});
+        std::span<unsigned int> scanNumbers = eic.scanNumbers();
+        std::span<float> rt = eic.rententionTimes();
+        std::span<float> mz = eic.mz();
+        std::span<float> predInterval = eic.predInterval();
+        std::span<float> ints_area = eic.ints_area();
+        std::span<float> ints_height = eic.ints_height();
+        std::span<unsigned int> df = eic.df();
+        std::span<float> DQSC = eic.DQSC();
+        std::span<unsigned int> cenID = eic.cenID();
+        std::span<size_t> interpolatedCens = eic.interpolatedIDs();
+        std::fill(interpolatedCens.begin(), interpolatedCens.end(), 0); // all points left at 0 are later interpolated since cenID = 0 doesn't exist
+        eic.interpolations = !(pointsInBin.size() + 4 == binSpan);
+
         for (size_t i = 0; i < pointsInBin.size(); i++)
         {
             const qCentroid *point = pointsInBin[i];
             size_t resultIdx = point->scanNo - firstScan + 2; // first two elements are empty for extrapolation
 
-            tmp_scanNumbers.push_back(point->scanNo);
-            tmp_rt.push_back(convertRT->at(point->scanNo - 1)); // -1 since the abstract scan numbers start at 2
-            tmp_mz.push_back(point->mz);
-            tmp_predInterval.push_back(point->mzError);
-            tmp_ints_area.push_back(point->int_area);
-            tmp_ints_height.push_back(point->int_height);
-            tmp_df.push_back(point->df);
-            tmp_DQSC.push_back(point->DQSCentroid);
-            tmp_cenID.push_back(point->cenID);
+            scanNumbers[i] = point->scanNo;
+            rt[i] = convertRT->at(point->scanNo - 1); // -1 since the abstract scan numbers start at 2
+            mz[i] = point->mz;
+            predInterval[i] = point->mzError;
+            ints_area[i] = point->int_area;
+            ints_height[i] = point->int_height;
+            df[i] = point->df;
+            DQSC[i] = point->DQSCentroid;
+            cenID[i] = point->cenID;
 
             interpolatedCens[resultIdx] = point->scanNo;
-            interpolatedDQSB[resultIdx] = DQSB_base[i]; // score = 0 suffices as sign of interpolation
         }
         assert(interpolatedCens[binSpan - 2] == 0 && interpolatedCens[binSpan - 1] == 0); // back is empty for extrapolation
+        writeDQSB(&eic, &DQSB_base);
 
-        EIC returnVal = {
-            tmp_scanNumbers,
-            tmp_rt,
-            tmp_mz,
-            tmp_predInterval,
-            tmp_ints_area,
-            tmp_ints_height,
-            tmp_df,
-            DQSB_base,
-            tmp_DQSC,
-            tmp_cenID,
-            interpolatedCens,
-            interpolatedDQSB,
-            interpolations};
-
-        return returnVal;
+        return eic;
     }
 
 #pragma endregion "Bin"
@@ -707,4 +869,181 @@ namespace qAlgorithms
         return (minOuterDist - meanInnerDist) / fmal(meanInnerDist, maxInVal, maxInVal);
     }
 #pragma endregion "Functions"
+
+#pragma region "online binning"
+
+    OnlineBinner::OnlineBinner(const std::vector<float> *convertRT, bool incremental)
+    {
+        this->convertRT = convertRT;
+        this->incremental = incremental;
+    }
+
+    void OnlineBinner::addScan(std::span<const qCentroid> centroids)
+    {
+        if (centroids.empty())
+        {
+            return;
+        }
+        const unsigned int scanNo = centroids.front().scanNo;
+        assert(scanNo > currentScan); // scans must be added in order
+        currentScan = scanNo;
+
+        // close all traces which can no longer be continued without a gap greater maxdist
+        for (auto it = openTraces.begin(); it != openTraces.end();)
+        {
+            if (it->second.lastScan + maxdist < scanNo)
+            {
+                closeTrace(it->second);
+                it = openTraces.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        for (const qCentroid &point : centroids)
+        {
+            assert(point.scanNo == scanNo);
+            idCount = std::max(idCount, size_t(point.cenID) + 1);
+
+            // the closest trace is either the first one with a greater mean or the one before it
+            const double tolerance = 10 * binningCritVal(5, point.mzError);
+            auto closest = openTraces.end();
+            double closestDist = tolerance;
+            auto upper = openTraces.lower_bound(point.mz);
+            if (upper != openTraces.end() && upper->first - point.mz < closestDist)
+            {
+                closest = upper;
+                closestDist = upper->first - point.mz;
+            }
+            if (upper != openTraces.begin() && point.mz - std::prev(upper)->first < closestDist)
+            {
+                closest = std::prev(upper);
+            }
+
+            if (closest == openTraces.end())
+            {
+                Trace newTrace;
+                newTrace.points.push_back(point);
+                newTrace.mzSum = point.mz;
+                newTrace.lastScan = scanNo;
+                openTraces.insert({point.mz, std::move(newTrace)});
+                continue;
+            }
+            // the key changes with every added point, so the trace is reinserted
+            auto node = openTraces.extract(closest);
+            Trace &trace = node.mapped();
+            trace.points.push_back(point);
+            trace.mzSum += point.mz;
+            trace.lastScan = scanNo;
+            node.key() = trace.mzSum / trace.points.size();
+            openTraces.insert(std::move(node));
+        }
+    }
+
+    void OnlineBinner::closeTrace(Trace &trace)
+    {
+        closedTraceCount++;
+        if (trace.points.size() < 5)
+        {
+            unbinned.insert(unbinned.end(), trace.points.begin(), trace.points.end());
+            trace.points = {};
+            return;
+        }
+        BinContainer traceBins;
+        traceBins.processBinsF.push_back(Bin{});
+        for (const qCentroid &point : trace.points)
+        {
+            traceBins.processBinsF.back().pointsInBin.push_back(&point);
+        }
+        BinningStats traceStats;
+        repeatBinning(traceBins, false, 0, &traceStats);
+
+        for (const qCentroid *point : traceBins.notInBins)
+        {
+            unbinned.push_back(*point);
+        }
+        // the bins are stored as EICs, so the centroids of the trace can be released. The DQSB
+        // depends on all unbinned points and is set once the last trace was closed.
+        for (Bin &bin : traceBins.finalBins)
+        {
+            bin.DQSB_base.assign(bin.pointsInBin.size(), 0);
+            ClosedBin closed{bin.createEIC(convertRT), {}, bin.mzMin, bin.mzMax};
+            closed.mz.reserve(bin.pointsInBin.size());
+            for (const qCentroid *point : bin.pointsInBin) // sorted by scans during createEIC
+            {
+                closed.mz.push_back(point->mz);
+            }
+            closedBins.push_back(std::move(closed));
+        }
+        trace.points = {};
+    }
+
+    std::vector<EIC> OnlineBinner::finish(BinningStats *stats)
+    {
+        for (auto &entry : openTraces)
+        {
+            closeTrace(entry.second);
+        }
+        openTraces.clear();
+
+        // points that were not binned within their trace can still form bins with points from neighbouring traces
+        BinContainer remainder;
+        stats->iterations = 0;
+        stats->pointsPerIteration.clear();
+        for (const qCentroid &point : unbinned)
+        {
+            remainder.notInBins.push_back(&point);
+        }
+        if (remainder.notInBins.size() > 4)
+        {
+            remainder.processBinsF.push_back(Bin{});
+            remainder.processBinsF.back().pointsInBin = std::move(remainder.notInBins);
+            remainder.notInBins.clear();
+            repeatBinning(remainder, incremental, idCount, stats);
+        }
+        // this also sorts the remaining unbinned points by mz
+        std::vector<EIC> remainderBins = finaliseBins(remainder, convertRT);
+
+        // the bins of closed traces are scored like the other bins, only the mz and scan of each point are needed
+        const size_t closedCount = closedBins.size();
+#pragma omp parallel for schedule(dynamic)
+        for (size_t i = 0; i < closedCount; i++)
+        {
+            ClosedBin *closed = &closedBins[i];
+            std::span<const unsigned int> scanNumbers = closed->eic.scanNumbers();
+            std::vector<qCentroid> points(scanNumbers.size());
+            Bin bin;
+            bin.pointsInBin.reserve(points.size());
+            for (size_t j = 0; j < points.size(); j++)
+            {
+                points[j].mz = closed->mz[j];
+                points[j].scanNo = scanNumbers[j];
+                bin.pointsInBin.push_back(&points[j]);
+            }
+            bin.mzMin = closed->mzMin;
+            bin.mzMax = closed->mzMax;
+            bin.scanMin = scanNumbers.front();
+            bin.scanMax = scanNumbers.back();
+            bin.makeDQSB(&remainder.notInBins, 0);
+            writeDQSB(&closed->eic, &bin.DQSB_base);
+        }
+
+        std::vector<EIC> finalBins;
+        finalBins.reserve(closedCount + remainderBins.size());
+        for (ClosedBin &closed : closedBins)
+        {
+            finalBins.push_back(std::move(closed.eic));
+        }
+        closedBins.clear();
+        for (EIC &eic : remainderBins)
+        {
+            finalBins.push_back(std::move(eic));
+        }
+        unbinned.clear();
+        return finalBins;
+    }
+
+#pragma endregion "online binning"
 }
@@ -11,448 +11,565 @@
 #include <vector>
 #include <iostream>
 #include <cassert>
+#include <algorithm> // sort
+#include <chrono>    // time per phase
 
 // group peaks identified from bins by their relation within a scan region
 
-size_t VALLEYS_1 = 0;
-size_t VALLEYS_other = 0;
-
 namespace qAlgorithms
 {
-    size_t realRegressions = 0;
-    size_t failRegressions = 0;
-    size_t ERRORCOUNTER = 0;
-
     // this module-local variable is used to prevent negative intensities from occurring
     float lowestAreaLog = 0;
 
     std::vector<MultiRegression> findComponents(
         std::vector<FeaturePeak> *peaks, // the peaks are updated as part of componentisation
-        std::vector<EIC> *bins,
+        EICStore *bins,
         const std::vector<float> *convertRT,
         float lowestArea,
-        size_t *featuresInComponents)
+        ComponentStats *stats)
     {
         assert(peaks->begin()->componentID == 0);
-        assert(*featuresInComponents == 0);
+        *stats = ComponentStats{};
+        const auto timeStart = std::chrono::steady_clock::now();
         lowestAreaLog = log(lowestArea);
 
-        unsigned int globalCompID = 1; // this is the component ID later used on a feature level. 0 means not part of a component
-
-#pragma region "Pre-Group"
         std::vector<GroupLims> limits = preGroup(peaks);
-        std::vector<MultiRegression> finalComponents;
+        for (const GroupLims &group : limits)
+        {
+            const size_t size = group.end - group.start + 1;
+            if (stats->preGroupSizes.size() < size + 1)
+            {
+                stats->preGroupSizes.resize(size + 1, 0);
+            }
+            stats->preGroupSizes[size]++;
+        }
+        const auto timeGrouped = std::chrono::steady_clock::now();
+        stats->time_preGroup = std::chrono::duration<double>(timeGrouped - timeStart).count();
+
+        // every pre-group is processed independently of all others. Since the pairwise comparison
+        // scales with the square of the group size, the largest groups are scheduled first so that
+        // no single thread is left processing a large group at the end
+        std::vector<size_t> groupOrder(limits.size());
+        std::iota(groupOrder.begin(), groupOrder.end(), 0);
+        std::stable_sort(groupOrder.begin(), groupOrder.end(), [&limits](const size_t lhs, const size_t rhs)
+                         { return limits[lhs].end - limits[lhs].start > limits[rhs].end - limits[rhs].start; });
+
+        std::vector<GroupComponents> groupResults(limits.size());
+#pragma omp parallel for schedule(dynamic, 1)
+        for (size_t i = 0; i < groupOrder.size(); i++)
+        {
+            const size_t groupIdx = groupOrder[i];
+            groupResults[groupIdx] = componentiseGroup(peaks, bins, convertRT, limits[groupIdx]);
+        }
+        const auto timeComponentised = std::chrono::steady_clock::now();
 
+        // component IDs are assigned in order of the pre-groups, which makes them independent
+        // of the order in which the groups were processed
+        unsigned int globalCompID = 1; // this is the component ID later used on a feature level. 0 means not part of a component
+        std::vector<MultiRegression> finalComponents;
         for (size_t groupIdx = 0; groupIdx < limits.size(); groupIdx++)
         {
-            // @todo factor the loop internals into at least one function
-            PreGrouping pregroup;
-            size_t groupsize = limits[groupIdx].end - limits[groupIdx].start + 1;
-            // std::cout << groupsize << ", ";
+            const GroupComponents *group = &groupResults[groupIdx];
+            addStats(stats, &group->stats);
 
-            if (groupsize == 1)
+            for (size_t comp = 0; comp < group->regressions.size(); comp++)
             {
-                if ((peaks->at(limits[groupIdx].end).coefficients.b2 > 0) ||
-                    (peaks->at(limits[groupIdx].end).coefficients.b3 > 0))
+                const PreGrouping *members = &group->members[comp];
+                for (size_t feat = 0; feat < members->features.size(); feat++)
                 {
-                    VALLEYS_1++;
+                    // update the feature that was passed by reference
+                    members->features[feat]->componentID = globalCompID;
+                    bins->setComponentID(members->features[feat]->idxBin, globalCompID);
+                    stats->featuresInComponents += 1;
                 }
-                continue;
-            }
-            for (size_t j = limits[groupIdx].start; j < limits[groupIdx].end + 1; j++)
-            {
-                if ((peaks->at(j).coefficients.b2 > 0) || (peaks->at(j).coefficients.b3 > 0))
+                finalComponents.push_back(group->regressions[comp]);
+
+                if (finalComponents.back().DQS == -1)
                 {
-                    VALLEYS_other++;
+                    // globalCompID--; // @todo decide if this should happen
+                    // finalComponents.pop_back();
+                    std::cerr << "Warning: in group " << groupIdx << ", the EICs associated with component "
+                              << globalCompID << " are identical\n";
                 }
+                globalCompID++;
             }
-            assert(VALLEYS_other < peaks->size());
-
-            // if (groupsize > 10) // this is only to speed up testing - @todo remove!
-            // {
-            //     continue;
-            // }
-
-            // every pre-group describes a varying-size region of data in the entire mass spectrum.
-            // this loop determines the range (in scans) that is relevant to this grouping
-            pregroup.features.reserve(groupsize);
-            pregroup.EICs.reserve(groupsize);
-            unsigned int maxScan = 0;
-            unsigned int minScan = 4294967295; // max value of unsigned int
-            for (size_t j = limits[groupIdx].start; j < limits[groupIdx].end + 1; j++)
+        }
+        // at least for one dataset, features with a valley point are much more likely
+        // to be groups of size 1 than to be included in larger groups (ca. twice as likely)
+        assert(stats->valleys_other < peaks->size());
+        stats->components = finalComponents.size();
+
+        const auto timeEnd = std::chrono::steady_clock::now();
+        stats->time_collect = std::chrono::duration<double>(timeEnd - timeComponentised).count();
+        stats->time_wall = std::chrono::duration<double>(timeEnd - timeStart).count();
+        return finalComponents;
+    }
+
+    void addStats(ComponentStats *target, const ComponentStats *source)
+    {
+        if (target->preGroupSizes.size() < source->preGroupSizes.size())
+        {
+            target->preGroupSizes.resize(source->preGroupSizes.size(), 0);
+        }
+        for (size_t i = 0; i < source->preGroupSizes.size(); i++)
+        {
+            target->preGroupSizes[i] += source->preGroupSizes[i];
+        }
+        target->valleys_single += source->valleys_single;
+        target->valleys_other += source->valleys_other;
+        target->invalidFeatures += source->invalidFeatures;
+        target->pairsEnumerated += source->pairsEnumerated;
+        target->pairsRejectedRT += source->pairsRejectedRT;
+        target->pairRegressionsFailed += source->pairRegressionsFailed;
+        target->pairsValid += source->pairsValid;
+        target->regressionsFitted += source->regressionsFitted;
+        target->growAccepted += source->growAccepted;
+        target->growRejected += source->growRejected;
+        target->mergesAccepted += source->mergesAccepted;
+        target->mergesRejected += source->mergesRejected;
+        target->identicalComponents += source->identicalComponents;
+        target->components += source->components;
+        target->featuresInComponents += source->featuresInComponents;
+        target->time_harmonise += source->time_harmonise;
+        target->time_pairs += source->time_pairs;
+        target->time_assign += source->time_assign;
+    }
+
+    GroupComponents componentiseGroup(std::vector<FeaturePeak> *peaks,
+                                      const EICStore *bins,
+                                      const std::vector<float> *convertRT,
+                                      const GroupLims limits)
+    {
+#pragma region "Pre-Group"
+        auto timePhase = std::chrono::steady_clock::now();
+        // adds the time since the last call to the given phase
+        auto endPhase = [&timePhase](double *phaseTime)
+        {
+            const auto now = std::chrono::steady_clock::now();
+            *phaseTime += std::chrono::duration<double>(now - timePhase).count();
+            timePhase = now;
+        };
+        GroupComponents result;
+        PreGrouping pregroup;
+        size_t groupsize = limits.end - limits.start + 1;
+        // std::cout << groupsize << ", ";
+
+        if (groupsize == 1)
+        {
+            if ((peaks->at(limits.end).coefficients.b2 > 0) ||
+                (peaks->at(limits.end).coefficients.b3 > 0))
             {
-                FeaturePeak *test = &(peaks->at(j));
-                assert(test->scanPeakEnd - test->scanPeakStart >= 4);
-                auto binRTs = (*bins)[test->idxBin].rententionTimes;
-                auto scans = (*bins)[test->idxBin].scanNumbers;
-                maxScan = std::max(maxScan, test->scanPeakEnd); // @todo scans should be their own type, same with indices
-                minScan = std::min(minScan, test->scanPeakStart);
-
-                assert(maxScan - minScan >= 4);
-                if (test->scanPeakStart + test->index_x0_offset >= test->scanPeakEnd - 1)
-                {
-                    ERRORCOUNTER++; // @todo this is something that should be prevented during feature construction, why isn't it?
-                    groupsize--;
-                    continue;
-                }
-                pregroup.features.push_back(test);
-                pregroup.EICs.push_back(&(bins->at(test->idxBin)));
+                result.stats.valleys_single++;
             }
-            assert(maxScan < convertRT->size());
-            if (groupsize < 2)
+            return result;
+        }
+        for (size_t j = limits.start; j < limits.end + 1; j++)
+        {
+            if ((peaks->at(j).coefficients.b2 > 0) || (peaks->at(j).coefficients.b3 > 0))
             {
-                continue;
+                result.stats.valleys_other++;
             }
+        }
 
-            // create a vector of unified RTs for interpolation in the harmonised EICs
-            // this uses the same scan -> time conversion as the feature construction
-            // assert(minScan != 0);
-            std::vector<float> unifiedRT(maxScan - minScan + 1, 0);
-            for (size_t i = 0; i < unifiedRT.size(); i++)
-            {
-                unifiedRT[i] = convertRT->at(minScan + i);
-            }
+        // if (groupsize > 10) // this is only to speed up testing - @todo remove!
+        // {
+        //     continue;
+        // }
 
-            std::vector<ReducedEIC> eics; // @todo the maximum size of a reduced EIC is the global maxscale + 1!
-            for (size_t j = 0; j < groupsize; j++)
+        // every pre-group describes a varying-size region of data in the entire mass spectrum.
+        // this loop determines the range (in scans) that is relevant to this grouping
+        pregroup.features.reserve(groupsize);
+        pregroup.EICs.reserve(groupsize);
+        unsigned int maxScan = 0;
+        unsigned int minScan = 4294967295; // max value of unsigned int
+        for (size_t j = limits.start; j < limits.end + 1; j++)
+        {
+            FeaturePeak *test = &(peaks->at(j));
+            assert(test->scanPeakEnd - test->scanPeakStart >= 4);
+            maxScan = std::max(maxScan, test->scanPeakEnd); // @todo scans should be their own type, same with indices
+            minScan = std::min(minScan, test->scanPeakStart);
+
+            assert(maxScan - minScan >= 4);
+            if (test->scanPeakStart + test->index_x0_offset >= test->scanPeakEnd - 1)
             {
-                const FeaturePeak *feature = pregroup.features[j];
-                const EIC *bin = &bins->at(feature->idxBin);
-                assert(bin == pregroup.EICs[j]); // @todo clean this up
-                eics.push_back(harmoniseEIC(feature, bin, &unifiedRT, minScan, maxScan));
-                eics.back().feature_ID = j;
-                assert(eics[j].intensity.size() == eics[0].intensity.size());
+                result.stats.invalidFeatures++; // @todo this is something that should be prevented during feature construction, why isn't it?
+                groupsize--;
+                continue;
             }
-            // At this stage, the EICs are in the correct shape for performing a multi-regression.
-            // To make comparisons faster, the RSS is calculated per feature at every point in the block.
-            // This means that the total RSS for a given sub-block is always calculated as the sum of RSS
-            // in that region. It is important to note that the sub-block changes with the considered members,
-            // as it only consists of the smallest region that contains all real points of the underlying features.
-            // The RSS for all individual features over the current range has been calculated as part of harmoniseEIC().
+            pregroup.features.push_back(test);
+            pregroup.EICs.push_back(bins->at(test->idxBin));
+        }
+        assert(maxScan < convertRT->size());
+        if (groupsize < 2)
+        {
+            return result;
+        }
+
+        // all harmonised EICs of the pre-group share one matrix, the eics are row views on it
+        EICMatrix eicMatrix;
+        std::vector<ReducedEIC> eics = harmoniseGroup(&pregroup, minScan, maxScan, &eicMatrix);
+        assert(eics.size() == groupsize);
+        // At this stage, the EICs are in the correct shape for performing a multi-regression.
+        // To make comparisons faster, the RSS is calculated per feature at every point in the block.
+        // This means that the total RSS for a given sub-block is always calculated as the sum of RSS
+        // in that region. It is important to note that the sub-block changes with the considered members,
+        // as it only consists of the smallest region that contains all real points of the underlying features.
+        // The RSS for all individual features over the current range has been calculated as part of harmoniseEIC().
+        endPhase(&result.stats.time_harmonise);
 #pragma endregion "Pre-Group"
 
 #pragma region "Compare Pairs"
-            // first, calculate the pairwise RSS in a sparse matrix. The RSS is set to INFINITY if it is worse
-            // than the sum of both individual RSS values.
-            // size: (x^2 -x) / 2 ; access: smaller Idx + (larger Idx * (larger Idx - 1)) / 2
-            std::vector<RSS_pair> pairs((groupsize * groupsize - groupsize) / 2);
+        // first, calculate the pairwise RSS for all candidate pairs. Before performing the computationally expensive
+        // check by regression, we can exclude features that don't overlap. Two features are only compared if their
+        // apexes differ by at most the mean of their RT uncertainties. The features are sorted by apex and swept
+        // from left to right, so that only overlapping pairs are visited. No feature can be further away from the
+        // current one than half the sum of its uncertainty and the largest uncertainty in the group.
+        // Only pairs that can form a component by themselves are stored, pairs with an RSS of INFINITY are discarded.
+        std::vector<RSS_pair> pairs;
+        {
+            std::vector<size_t> apexOrder(groupsize);
+            float maxUncert = 0;
+            for (size_t j = 0; j < groupsize; j++)
+            {
+                apexOrder[j] = j;
+                maxUncert = std::max(maxUncert, pregroup.features[j]->retentionTimeUncertainty);
+            }
+            std::sort(apexOrder.begin(), apexOrder.end(), [&pregroup](const size_t lhs, const size_t rhs)
+                      { return pregroup.features[lhs]->retentionTime < pregroup.features[rhs]->retentionTime; });
 
-            for (size_t idx_S = 0; idx_S < groupsize - 1; idx_S++)
+            size_t candidates = 0;
+            for (size_t sweepA = 0; sweepA < groupsize - 1; sweepA++)
             {
-                auto EIC_A = eics[idx_S];
-                for (size_t idx_L = idx_S + 1; idx_L < groupsize; idx_L++)
-                {
-                    size_t access = idx_S + (idx_L * (idx_L - 1)) / 2; // index of the half matrix where the pair sits
-                    pairs[access].idx_S = idx_S;
-                    pairs[access].idx_L = idx_L;
+                const FeaturePeak *feature_A = pregroup.features[apexOrder[sweepA]];
+                const float apex_A = feature_A->retentionTime;
+                const float uncert_A = feature_A->retentionTimeUncertainty;
+                const float sweepLimit = apex_A + (uncert_A + maxUncert) / 2;
 
-                    auto EIC_B = eics[idx_L];
+                for (size_t sweepB = sweepA + 1; sweepB < groupsize; sweepB++)
+                {
+                    const FeaturePeak *feature_B = pregroup.features[apexOrder[sweepB]];
+                    const float apex_B = feature_B->retentionTime;
+                    if (apex_B > sweepLimit)
                     {
-                        // before performing the computationally expensive check by regression, we can exclude features
-                        // that don't overlap. This will massively reduce the time spent on large pregroups
-                        const float uncert_A = peaks->at(EIC_A.feature_ID).retentionTimeUncertainty;
-                        const float apex_A = peaks->at(EIC_A.feature_ID).retentionTime;
-                        const float uncert_B = peaks->at(EIC_B.feature_ID).retentionTimeUncertainty;
-                        const float apex_B = peaks->at(EIC_B.feature_ID).retentionTime;
-
-                        if (std::abs(apex_A - apex_B) > (uncert_A + uncert_B) / 2)
-                        {
-                            pairs[access].RSS = INFINITY;
-                            failRegressions++;
-                            continue;
-                        }
+                        break; // all following features are further away
+                    }
+                    if (apex_B - apex_A > (uncert_A + feature_B->retentionTimeUncertainty) / 2)
+                    {
+                        continue;
                     }
+                    candidates++;
+
+                    // the EIC with the smaller index is always left
+                    const size_t idx_S = std::min(apexOrder[sweepA], apexOrder[sweepB]);
+                    const size_t idx_L = std::max(apexOrder[sweepA], apexOrder[sweepB]);
+                    const ReducedEIC &EIC_A = eics[idx_S];
+                    const ReducedEIC &EIC_B = eics[idx_L];
 
                     // merge the EICs that are relevant to both
-                    static const std::vector<size_t> select{0, 1}; // smallest RT is always left
                     size_t idxStart = std::min(EIC_A.featLim_L, EIC_B.featLim_L);
                     size_t idxEnd = std::max(EIC_A.featLim_R, EIC_B.featLim_R);
                     assert(idxEnd > idxStart);
-                    std::vector<ReducedEIC> eics_pair{EIC_A, EIC_B};
-                    auto mergedEIC = mergeEICs(&eics_pair, &select, idxStart, idxEnd);
-                    auto regression = runningRegression_multi(&mergedEIC, &eics_pair, &select, idxStart, idxEnd, 2);
+                    const ReducedEIC *eics_pair[2] = {&EIC_A, &EIC_B};
+                    const ProductSums *sums_pair[2] = {EIC_A.productSums, EIC_B.productSums};
+                    auto mergedEIC = mergeEICs(eics_pair, idxStart, idxEnd);
+                    auto regression = runningRegression_multi(&mergedEIC, eics_pair, sums_pair, idxStart, idxEnd, 2);
+                    result.stats.regressionsFitted++;
 
                     if (regression.b0_vec[0] == 0)
                     {
-                        pairs[access].RSS = INFINITY;
-                        failRegressions++;
+                        result.stats.pairRegressionsFailed++;
+                        continue;
                     }
-                    else
-                    {
-                        realRegressions++;
+                    assert(regression.scale <= MAXSCALE);
 
-                        assert(regression.scale <= MAXSCALE);
-
-                        pairs[access].regression = regression; // this introduces some redundancy
-                        pairs[access].idxStart = regression.idxStart;
-                        pairs[access].idxEnd = regression.idxEnd;
-
-                        pairs[access].cumRSS = regression.cum_RSS;
-                        // return infinity if the regression does not work
-                        pairs[access].RSS = simpleRSS(&regression.cum_RSS, &EIC_A.RSS_cum, &EIC_B.RSS_cum,
-                                                      idxStart, idxEnd, 2, 8);
+                    // return infinity if the regression does not work
+                    float RSS = simpleRSS(regression.cum_RSS, EIC_A.RSS_cum, EIC_B.RSS_cum,
+                                          idxStart, idxEnd, 2, 8);
+                    if (RSS == INFINITY) // the pair cannot form a component by itself
+                    {
+                        continue;
                     }
+                    RSS_pair pair;
+                    pair.idx_S = idx_S;
+                    pair.idx_L = idx_L;
+                    pair.idxStart = regression.idxStart;
+                    pair.idxEnd = regression.idxEnd;
+                    pair.RSS = RSS;
+                    pair.cumRSS = regression.cum_RSS;
+                    pair.regression = std::move(regression); // this introduces some redundancy
+                    pairs.push_back(std::move(pair));
                 }
             }
-            // pairRSS serves as an exclusion matrix and priorisation tool. The component assignment is handled through
-            // a group vector and stored assignment information
+            result.stats.pairsEnumerated = (groupsize * groupsize - groupsize) / 2;
+            result.stats.pairsRejectedRT = result.stats.pairsEnumerated - candidates;
+            result.stats.pairsValid = pairs.size();
+        }
+        endPhase(&result.stats.time_pairs);
+        // pairRSS serves as an exclusion matrix and priorisation tool. The component assignment is handled through
+        // a group vector and stored assignment information
 #pragma endregion "Compare Pairs"
 
 #pragma region "Iterative Assign"
-            int componentGroup = 0;
-            std::vector<int> assignment(groupsize, -1); // -1 == unassigned
-            std::vector<CompAssignment> components;     // index-based access of component RSS
+        int componentGroup = 0;
+        std::vector<int> assignment(groupsize, -1); // -1 == unassigned
+        std::vector<CompAssignment> components;     // index-based access of component RSS
+
+        // all pairs are iterated through in ascending order of RSS (best -> worst). Ties are resolved
+        // by the position of the pair in the half matrix, so the order does not depend on the sweep.
+        std::sort(pairs.begin(), pairs.end(), [](const RSS_pair &lhs, const RSS_pair &rhs)
+                  {
+                      if (lhs.RSS != rhs.RSS)
+                      {
+                          return lhs.RSS < rhs.RSS;
+                      }
+                      return lhs.idx_L != rhs.idx_L ? lhs.idx_L < rhs.idx_L : lhs.idx_S < rhs.idx_S; });
+
+        // pairs only contains pairs which can form a component by themselves, features
+        // that are not part of a pair may never be assigned to the same component
+        for (size_t i = 0; i < pairs.size(); i++)
+        {
+            const RSS_pair &p = pairs[i];
 
-            // all pairs are iterated through in ascending order of RSS (best -> worst)
-            std::sort(pairs.begin(), pairs.end(), [](const RSS_pair lhs, const RSS_pair rhs)
-                      { return lhs.RSS < rhs.RSS; });
+            int *ass_L = &assignment[p.idx_L];
+            int *ass_S = &assignment[p.idx_S];
 
-            for (size_t i = 0; i < pairs.size(); i++) // @todo length of pairs = the number of RSS - infinity
+            if (*ass_L == *ass_S)
             {
-                auto p = pairs[i];
-                if (p.RSS == INFINITY) // the pair cannot form a component by itself, so these features may never be assigned to the same component
+                // if the component ID is not -1, both are assigned to the same component -> do nothing
+                if (*ass_L == -1)
                 {
-                    continue;
+                    // form a new component from the two features
+                    *ass_L = componentGroup;
+                    *ass_S = componentGroup;
+                    CompAssignment insert{
+                        p.regression,
+                        p.cumRSS, // @todo this is a major design flaw (also see above)
+                        p.idxStart,
+                        p.idxEnd,
+                        2, // number of peaks in this component
+                        p.RSS,
+                        componentGroup};
+                    const ProductSums *parts[2] = {eics[p.idx_S].productSums, eics[p.idx_L].productSums};
+                    insert.productSums = combineSums(parts);
+                    components.push_back(insert);
+                    componentGroup++;
                 }
-
-                int *ass_L = &assignment[p.idx_L];
-                int *ass_S = &assignment[p.idx_S];
-
-                if (*ass_L == *ass_S)
+            }
+            else
+            { // @todo this can be condensed by merging the selection assignment and other stuff
+                if ((*ass_L == -1) || (*ass_S == -1))
                 {
-                    // if the component ID is not -1, both are assigned to the same component -> do nothing
-                    if (*ass_L == -1)
+                    // one feature is assigned, the other is not
+                    bool singleLarge = *ass_L == -1;
+                    int *unAss = singleLarge ? ass_L : ass_S;
+                    // check if the unassigned feature can be assigned to a component.
+                    // this will not lead to the creation of a new component!
+
+                    // 1) create a selection vector that holds the feature IDs for merge
+                    int existingComponent = singleLarge ? *ass_S : *ass_L;      // component ID of the assigned feature
+                    size_t unassignedFeature = singleLarge ? p.idx_L : p.idx_S; // index of the unassigned feature
+                    std::vector<size_t> selection(1, unassignedFeature);
+                    for (size_t idx = 0; idx < groupsize; idx++)
                     {
-                        // form a new component from the two features
-                        *ass_L = componentGroup;
-                        *ass_S = componentGroup;
-                        CompAssignment insert{
-                            p.regression,
-                            p.cumRSS, // @todo this is a major design flaw (also see above)
-                            p.idxStart,
-                            p.idxEnd,
-                            2, // number of peaks in this component
-                            p.RSS,
-                            componentGroup};
-                        components.push_back(insert);
-                        componentGroup++;
-                    }
-                }
-                else
-                { // @todo this can be condensed by merging the selection assignment and other stuff
-                    if ((*ass_L == -1) || (*ass_S == -1))
-                    {
-                        // one feature is assigned, the other is not
-                        bool singleLarge = *ass_L == -1;
-                        int *unAss = singleLarge ? ass_L : ass_S;
-                        // check if the unassigned feature can be assigned to a component.
-                        // this will not lead to the creation of a new component!
-
-                        // 1) create a selection vector that holds the feature IDs for merge
-                        int existingComponent = singleLarge ? *ass_S : *ass_L;      // component ID of the assigned feature
-                        size_t unassignedFeature = singleLarge ? p.idx_L : p.idx_S; // index of the unassigned feature
-                        std::vector<size_t> selection(1, unassignedFeature);
-                        for (size_t idx = 0; idx < groupsize; idx++)
-                        {
-                            if (assignment[idx] == existingComponent)
-                            {
-                                selection.push_back(idx); // @todo this is pretty inefficient
-                            }
-                        }
-                        // this is necessary because otherwise, the values of b0 cannot be assigned to members. This way,
-                        // they are always sorted by RT of the original feature
-                        std::sort(selection.begin(), selection.end());
-
-                        size_t idxStart = std::min(components[existingComponent].limit_L, eics[unassignedFeature].featLim_L);
-                        size_t idxEnd = std::max(components[existingComponent].limit_R, eics[unassignedFeature].featLim_R);
-                        assert(idxEnd > idxStart);
-                        // 2) perform the multi-regression over the combined EIC for the selection
-                        auto mergedEIC = mergeEICs(&eics, &selection, idxStart, idxEnd);
-                        const size_t n = components[existingComponent].numPeaks;
-                        if (n + 1 >= 32) [[unlikely]]
+                        if (assignment[idx] == existingComponent)
                         {
-                            // @todo this is a hard limit due to the max amount of b0 coeffs we can store. It is only ever triggered by the pump error dataset
-                            // note: the error only ever occurred with the data measured at the moment the pump broke
-                            std::cout << "Warning: the number of component members exceeds the maximum number of features (32).\n";
-                            ERRORCOUNTER++;
-                            continue;
+                            selection.push_back(idx); // @todo this is pretty inefficient
                         }
-                        auto regression = runningRegression_multi(&mergedEIC, &eics, &selection,
-                                                                  idxStart, idxEnd, n + 1);
-
-                        // 3) check if there is a better RSS when combining the regressions, then merge if yes
-                        // This is already handled in the simpleRSS function, so we just check for infinity (= no merge)
-                        float newRSS = simpleRSS(&regression.cum_RSS,
-                                                 &eics[unassignedFeature].RSS_cum,
-                                                 &components[existingComponent].cumRSS,
-                                                 idxStart, idxEnd, n + 1, n + 3 + 4);
+                    }
+                    // this is necessary because otherwise, the values of b0 cannot be assigned to members. This way,
+                    // they are always sorted by RT of the original feature
+                    std::sort(selection.begin(), selection.end());
 
-                        if (newRSS < INFINITY)
-                        {
-                            // do nothing if the single feature doesn't fit
-                            components[existingComponent].regression = regression;
-                            components[existingComponent].cumRSS = regression.cum_RSS;
-                            components[existingComponent].numPeaks++;
-                            components[existingComponent].limit_L = regression.idxStart;
-                            components[existingComponent].limit_R = regression.idxEnd;
-                            components[existingComponent].RSS = newRSS;
-                            *unAss = components[existingComponent].component;
-                        }
+                    size_t idxStart = std::min(components[existingComponent].limit_L, eics[unassignedFeature].featLim_L);
+                    size_t idxEnd = std::max(components[existingComponent].limit_R, eics[unassignedFeature].featLim_R);
+                    assert(idxEnd > idxStart);
+                    // 2) perform the multi-regression over the combined EIC for the selection
+                    const std::vector<const ReducedEIC *> selectedEICs = selectEICs(&eics, &selection);
+                    auto mergedEIC = mergeEICs(selectedEICs, idxStart, idxEnd);
+                    const size_t n = components[existingComponent].numPeaks;
+                    // the component grows by one member, so only its prefix sums are added to those of the component
+                    const ProductSums *parts[2] = {&components[existingComponent].productSums,
+                                                   eics[unassignedFeature].productSums};
+                    auto regression = runningRegression_multi(&mergedEIC, selectedEICs, parts,
+                                                              idxStart, idxEnd, n + 1);
+                    result.stats.regressionsFitted++;
+
+                    // 3) check if there is a better RSS when combining the regressions, then merge if yes
+                    // This is already handled in the simpleRSS function, so we just check for infinity (= no merge)
+                    float newRSS = simpleRSS(regression.cum_RSS,
+                                             eics[unassignedFeature].RSS_cum,
+                                             components[existingComponent].cumRSS,
+                                             idxStart, idxEnd, n + 1, n + 3 + 4);
+
+                    if (newRSS < INFINITY)
+                    {
+                        // do nothing if the single feature doesn't fit
+                        components[existingComponent].regression = regression;
+                        components[existingComponent].cumRSS = regression.cum_RSS;
+                        components[existingComponent].numPeaks++;
+                        components[existingComponent].limit_L = regression.idxStart;
+                        components[existingComponent].limit_R = regression.idxEnd;
+                        components[existingComponent].RSS = newRSS;
+                        components[existingComponent].productSums = combineSums(parts);
+                        *unAss = components[existingComponent].component;
+                        result.stats.growAccepted++;
                     }
                     else
                     {
-                        // both features are assigned to different components
-                        // the only relevant check here is for the combination of both into one new component
-                        assert((*ass_L != -1) && (*ass_S != -1));
-                        assert(*ass_L != *ass_S);
+                        result.stats.growRejected++;
+                    }
+                }
+                else
+                {
+                    // both features are assigned to different components
+                    // the only relevant check here is for the combination of both into one new component
+                    assert((*ass_L != -1) && (*ass_S != -1));
+                    assert(*ass_L != *ass_S);
 
-                        const size_t n = components[*ass_L].numPeaks + components[*ass_S].numPeaks;
-                        if (n >= 32) [[unlikely]]
-                        {
-                            // @todo this is a hard limit due to the max amount of b0 coeffs we can store. It is only ever triggered by the pump error dataset
-                            std::cout << "Warning: the number of component members exceeds the maximum number of features (32)\n";
-                            ERRORCOUNTER++;
-                            // note: occurs during pump error and frequently with SFC data
-                            continue;
-                        }
+                    const size_t n = components[*ass_L].numPeaks + components[*ass_S].numPeaks;
 
-                        size_t idxStart = std::min(components[*ass_L].limit_L, eics[*ass_S].featLim_L);
-                        size_t idxEnd = std::max(components[*ass_L].limit_R, eics[*ass_S].featLim_R);
-                        assert(idxEnd > idxStart);
+                    size_t idxStart = std::min(components[*ass_L].limit_L, eics[*ass_S].featLim_L);
+                    size_t idxEnd = std::max(components[*ass_L].limit_R, eics[*ass_S].featLim_R);
+                    assert(idxEnd > idxStart);
 
-                        // add all feature IDs from both components
-                        std::vector<size_t> selection;
-                        for (size_t idx = 0; idx < groupsize; idx++)
+                    // add all feature IDs from both components
+                    std::vector<size_t> selection;
+                    for (size_t idx = 0; idx < groupsize; idx++)
+                    {
+                        if ((assignment[idx] == *ass_L) || (assignment[idx] == *ass_S))
                         {
-                            if ((assignment[idx] == *ass_L) || (assignment[idx] == *ass_S))
-                            {
-                                selection.push_back(idx); // @todo this is pretty inefficient
-                            }
+                            selection.push_back(idx); // @todo this is pretty inefficient
                         }
-                        // 2) perform the multi-regression over the combined EIC for the selection
-                        // start and end indices need to be adjusted so that
-                        auto mergedEIC = mergeEICs(&eics, &selection, idxStart, idxEnd);
-                        auto regression = runningRegression_multi(&mergedEIC, &eics, &selection,
-                                                                  idxStart, idxEnd, n);
-
-                        // 3) check if there is a better RSS when combining the regressions, then merge if yes
-                        // This is already handled in the simpleRSS function, so we just check for infinity (= no merge)
-                        float newRSS = simpleRSS(&regression.cum_RSS,
-                                                 &components[*ass_L].cumRSS,
-                                                 &components[*ass_S].cumRSS,
-                                                 idxStart, idxEnd, n, n + 6);
-
-                        if (newRSS < INFINITY)
+                    }
+                    // 2) perform the multi-regression over the combined EIC for the selection
+                    // start and end indices need to be adjusted so that
+                    const std::vector<const ReducedEIC *> selectedEICs = selectEICs(&eics, &selection);
+                    auto mergedEIC = mergeEICs(selectedEICs, idxStart, idxEnd);
+                    const ProductSums *parts[2] = {&components[*ass_L].productSums,
+                                                   &components[*ass_S].productSums};
+                    auto regression = runningRegression_multi(&mergedEIC, selectedEICs, parts,
+                                                              idxStart, idxEnd, n);
+                    result.stats.regressionsFitted++;
+
+                    // 3) check if there is a better RSS when combining the regressions, then merge if yes
+                    // This is already handled in the simpleRSS function, so we just check for infinity (= no merge)
+                    float newRSS = simpleRSS(regression.cum_RSS,
+                                             components[*ass_L].cumRSS,
+                                             components[*ass_S].cumRSS,
+                                             idxStart, idxEnd, n, n + 6);
+
+                    if (newRSS < INFINITY)
+                    {
+                        // do nothing if the two components cannot be merged
+                        // always prefer the smaller indexed feature when assigning components.
+                        // this does not have an effect on any comparisons, so not a relevant implementation detail
+                        components[*ass_S].regression = regression;
+                        components[*ass_S].cumRSS = regression.cum_RSS;
+                        components[*ass_S].numPeaks = n;
+                        components[*ass_S].limit_L = regression.idxStart;
+                        components[*ass_S].limit_R = regression.idxEnd;
+                        components[*ass_S].RSS = newRSS;
+                        components[*ass_S].productSums = combineSums(parts);
+                        // invalidate the merged component
+                        int removedID = *ass_L;
+                        unsigned int counter = 0;
+                        for (size_t idx = 0; idx < groupsize; idx++)
                         {
-                            // do nothing if the two components cannot be merged
-                            // always prefer the smaller indexed feature when assigning components.
-                            // this does not have an effect on any comparisons, so not a relevant implementation detail
-                            components[*ass_S].regression = regression;
-                            components[*ass_S].cumRSS = regression.cum_RSS;
-                            components[*ass_S].numPeaks = n;
-                            components[*ass_S].limit_L = regression.idxStart;
-                            components[*ass_S].limit_R = regression.idxEnd;
-                            components[*ass_S].RSS = newRSS;
-                            // invalidate the merged component
-                            int removedID = *ass_L;
-                            unsigned int counter = 0;
-                            for (size_t idx = 0; idx < groupsize; idx++)
+                            if ((assignment[idx] == removedID))
                             {
-                                if ((assignment[idx] == removedID))
-                                {
-                                    counter++;
-                                    assignment[idx] = *ass_S;
-                                }
+                                counter++;
+                                assignment[idx] = *ass_S;
                             }
-                            assert(counter == components[removedID].numPeaks);
-                            components[removedID].numPeaks = 0;
-                            components[removedID].RSS = INFINITY;
-                            assert(*ass_L == *ass_S);
                         }
-                        // @todo the regression goes out of scope here, add function-level storage for coefficients
+                        assert(counter == components[removedID].numPeaks);
+                        components[removedID].numPeaks = 0;
+                        components[removedID].RSS = INFINITY;
+                        assert(*ass_L == *ass_S);
+                        result.stats.mergesAccepted++;
+                    }
+                    else
+                    {
+                        result.stats.mergesRejected++;
                     }
+                    // @todo the regression goes out of scope here, add function-level storage for coefficients
                 }
-            } // outer if statement
+            }
+        } // outer if statement
 
-            assert(componentGroup > -1);
-            assert((size_t(componentGroup)) <= groupsize);
+        assert(componentGroup > -1);
+        assert((size_t(componentGroup)) <= groupsize);
 #pragma endregion "Iterative Assign"
 
 #pragma region "cleanup"
-            // At this stage, some components could be invalid. Additionally, the component ID is local to the inner loop.
-            // To produce user-facing data, the component ID is moved to a global level and added to the features themselves
+        // At this stage, some components could be invalid. Additionally, the component ID is local to the pre-group.
+        // The global component ID is assigned by the caller once all pre-groups are processed
 
-            for (size_t comp = 0; comp < components.size(); comp++)
+        for (size_t comp = 0; comp < components.size(); comp++)
+        {
+            if (components[comp].numPeaks == 0)
+            {
+                continue;
+            }
+            int compID = components[comp].component;
+            std::vector<size_t> selection; // used for tanimoto later on
+            PreGrouping members;
+            for (size_t feat = 0; feat < groupsize; feat++)
             {
-                if (components[comp].numPeaks == 0)
+                if (assignment[feat] == compID)
                 {
-                    continue;
+                    members.features.push_back(pregroup.features[feat]);
+                    members.EICs.push_back(pregroup.EICs[feat]);
+                    selection.push_back(feat);
                 }
-                int compID = components[comp].component;
-                std::vector<size_t> selection; // used for tanimoto later on
-                for (size_t feat = 0; feat < groupsize; feat++)
-                {
-                    if (assignment[feat] == compID)
-                    {
-                        // update the feature that was passed by reference
-                        pregroup.features[feat]->componentID = globalCompID;
-                        pregroup.EICs[feat]->componentID = globalCompID;
-                        selection.push_back(feat);
-                        *featuresInComponents += 1;
-                    }
-                }
-                finalComponents.push_back(components[comp].regression);
-                // the tanimoto-score is calculated using the uniformly scaled intensity vectors of all data points in the region
+            }
+            result.members.push_back(members);
+            result.regressions.push_back(components[comp].regression);
+            MultiRegression *finalComponent = &result.regressions.back();
+            // the tanimoto-score is calculated using the uniformly scaled intensity vectors of all data points in the region
 
-                // this is just for debugging, remove later @todo
-                for (size_t i = 0; i < selection.size(); i++)
+            // this is just for debugging, remove later @todo
+            for (size_t i = 0; i < selection.size(); i++)
+            {
+                size_t dfCount = 0;
+                for (size_t idx = finalComponent->idxStart; idx < finalComponent->idxEnd + 1; idx++)
                 {
-                    size_t dfCount = 0;
-                    for (size_t idx = finalComponents.back().idxStart; idx < finalComponents.back().idxEnd + 1; idx++)
-                    {
-                        dfCount += eics[selection[i]].df[idx] ? 1 : 0;
-                    }
-                    assert(dfCount > 4);
+                    dfCount += eics[selection[i]].df[idx] ? 1 : 0;
                 }
+                assert(dfCount > 4);
+            }
 
-                finalComponents.back().DQS = tanimotoScore(&eics, &selection,
-                                                           finalComponents.back().idxStart,
-                                                           finalComponents.back().idxEnd);
-
-                if (finalComponents.back().DQS == -1)
-                {
-                    // globalCompID--; // @todo decide if this should happen
-                    // finalComponents.pop_back();
-                    std::cerr << "Warning: in group " << groupIdx << ", the EICs associated with component "
-                              << globalCompID << " are identical\n";
-                }
-                globalCompID++;
+            finalComponent->DQS = tanimotoScore(selectEICs(&eics, &selection),
+                                                finalComponent->idxStart,
+                                                finalComponent->idxEnd);
+            if (finalComponent->DQS == -1)
+            {
+                result.stats.identicalComponents++;
             }
+        }
+        endPhase(&result.stats.time_assign);
 
 #pragma endregion "cleanup"
-        }
-        std::cout << std::endl;
-        std::cout << "1: " << VALLEYS_1 << " ; other: " << VALLEYS_other << "\n"; // at least for one dataset, features with a valley point are much more likely
-        // to be groups of size 1 than to be included in larger groups (ca. twice as likely)
-        std::cout << "fails: " << failRegressions << ", real ones: " << realRegressions << ", Errors: " << ERRORCOUNTER << "\n";
-        failRegressions = 0;
-        realRegressions = 0;
-        VALLEYS_1 = 0;
-        VALLEYS_other = 0;
-        ERRORCOUNTER = 0;
+        return result;
+    }
 
-        return finalComponents;
+    std::vector<const ReducedEIC *> selectEICs(const std::vector<ReducedEIC> *eics,
+                                               const std::vector<size_t> *selection)
+    {
+        std::vector<const ReducedEIC *> selected(selection->size());
+        for (size_t i = 0; i < selection->size(); i++)
+        {
+            selected[i] = &(eics->at(selection->at(i)));
+        }
+        return selected;
     }
 
-    MergedEIC mergeEICs(const std::vector<ReducedEIC> *eics,
-                        const std::vector<size_t> *selection,
+    MergedEIC mergeEICs(const EICView eics,
                         size_t idxStart,
                         size_t idxEnd)
     {
-        // the values in selection must be unique! This isn't tested here @todo
-        assert(selection->size() <= eics->size());
+        // the EICs in the view must be unique! This isn't tested here @todo
         assert(idxEnd > idxStart);
-        size_t eicSize = eics->front().intensity.size();
+        size_t eicSize = eics.front()->intensity.size();
         assert(idxEnd < eicSize);
 
         // {
@@ -487,29 +604,29 @@ namespace qAlgorithms
 
         size_t span = idxEnd - idxStart + 1;
         MergedEIC result;
-        result.intensity.reserve(span);
-        result.intensity_log.reserve(span);
+        result.intensity.reserve(span * eics.size());
+        result.intensity_log.reserve(span * eics.size());
         result.RSS_cum.reserve(span); // remember to overwrite this! It is no longer accurate after the regression completes
-        result.df.reserve(span);
-        result.DF_cum = std::vector<int>(span, 0);
-        for (size_t i = 0; i < selection->size(); i++)
+        result.df.reserve(span * eics.size());
+        result.DF_cum = std::vector<int>(span, eics.size()); // every EIC contributes one point per scan
+        for (size_t i = 0; i < eics.size(); i++)
         {
-            const ReducedEIC *subEIC = &(eics->at(selection->at(i)));
+            // every EIC is a row of the pre-group matrix, so the relevant region can be appended as one slice
+            const ReducedEIC *subEIC = eics[i];
             assert(subEIC->intensity.size() == eicSize);
-            for (size_t idx = idxStart; idx <= idxEnd; idx++)
-            {
-                result.intensity.push_back(subEIC->intensity[idx]);
-                result.intensity_log.push_back(subEIC->intensity_log[idx]);
-                result.df.push_back(subEIC->df[idx]);
-                result.DF_cum[idx - idxStart]++;
-            }
+            auto intensity = subEIC->intensity.subspan(idxStart, span);
+            auto intensity_log = subEIC->intensity_log.subspan(idxStart, span);
+            auto df = subEIC->df.subspan(idxStart, span);
+            result.intensity.insert(result.intensity.end(), intensity.begin(), intensity.end());
+            result.intensity_log.insert(result.intensity_log.end(), intensity_log.begin(), intensity_log.end());
+            result.df.insert(result.df.end(), df.begin(), df.end());
         }
         assert(result.DF_cum.front() != 0);
         assert(result.DF_cum.back() != 0);
-        result.numPeaks = selection->size();
+        result.numPeaks = eics.size();
         result.peakFrame = span;
         result.groupIdxStart = idxStart;
-        result.minScan = eics->front().minScan + idxStart;
+        result.minScan = eics.front()->minScan + idxStart;
         return result;
     }
 
@@ -678,7 +795,7 @@ namespace qAlgorithms
         */
 
         calcPeakHeightUncert(mutateReg, mse, scale);
-        if (1 / mutateReg->uncertainty_height <= T_VALUES[df_sum - 5]) // statistical significance of the peak height
+        if (1 / mutateReg->uncertainty_height <= tQuantile(df_sum)) // statistical significance of the peak height
         {
             return;
         }
@@ -701,7 +818,7 @@ namespace qAlgorithms
         // it might be preferential to combine both functions again or store the common matrix somewhere
         calcPeakAreaUncert(mutateReg, mse, scale);
 
-        if (mutateReg->area / mutateReg->uncertainty_area <= T_VALUES[df_sum - 5])
+        if (mutateReg->area / mutateReg->uncertainty_area <= tQuantile(df_sum))
         {
             return; // statistical insignificance of the area
         }
@@ -714,7 +831,7 @@ namespace qAlgorithms
           value in the CHI_SQUARES, the regression is invalid.
         */
         float chiSquare = calcSSE_chisqared(mutateReg->coeffs, intensities, mutateReg->left_limit, mutateReg->right_limit, idx_x0);
-        if (chiSquare < CHI_SQUARES[df_sum - 5])
+        if (chiSquare < chiSquareQuantile(df_sum))
         {
             return; // statistical insignificance of the chi-square value
         }
@@ -740,22 +857,22 @@ namespace qAlgorithms
 
     MultiRegression runningRegression_multi( // add function that combines multiplr eics and updates the peak count
         const MergedEIC *eic,
-        const std::vector<ReducedEIC> *eics,
-        const std::vector<size_t> *selection,
+        const EICView eics,
+        std::span<const ProductSums *const> parts,
         const size_t idxStart,
         const size_t idxEnd,
         // const size_t maxScale,
         const unsigned int numPeaks)
     // const size_t peakFrame)
     {
-        assert(numPeaks < 32);
         size_t peakFrame = (idxEnd - idxStart + 1);
-        size_t maxScale = (peakFrame - 1) / 2 > MAXSCALE ? MAXSCALE : (peakFrame - 1) / 2;
+        // INV_ARRAY only contains the inverse for scales below MAXSCALE
+        size_t maxScale = (peakFrame - 1) / 2 > MAXSCALE - 1 ? MAXSCALE - 1 : (peakFrame - 1) / 2;
 
-        assert(selection->size() == eic->numPeaks);
+        assert(eics.size() == eic->numPeaks);
         assert(eic->numPeaks == numPeaks);
         // regressions for every possible scale and window position
-        std::vector<MultiRegression> regressions = findCoefficients_multi(&(eic->intensity_log), maxScale, numPeaks, peakFrame);
+        std::vector<MultiRegression> regressions = findCoefficients_multi(parts, eics, idxStart, maxScale, numPeaks, peakFrame);
         // bookkeeping: which regressions are viable?
         std::vector<bool> regressionOK(regressions.size(), false);
         // used to decide on the best overall regression
@@ -840,7 +957,11 @@ namespace qAlgorithms
                 }
 
                 // check degrees of fredom again with updated limits
-                df = calcDF(&(eics->at(selection->at(i)).df), testCase.left_limit, testCase.right_limit);
+                df = 0;
+                for (size_t idx = testCase.left_limit; idx < size_t(testCase.right_limit) + 1; idx++)
+                {
+                    df += eics[i]->df[idx];
+                }
                 if (df < 5)
                 {
                     regressionOK[multiReg] = false;
@@ -851,7 +972,7 @@ namespace qAlgorithms
                 regressions[multiReg].idxStart = std::max(size_t(testCase.left_limit), regressions[multiReg].idxStart);
                 regressions[multiReg].idxEnd = std::min(size_t(testCase.right_limit), regressions[multiReg].idxEnd);
 
-                auto selDF = eics->at(selection->at(i)).df;
+                std::span<const unsigned char> selDF = eics[i]->df;
                 int countHits = 0;
                 for (size_t idx = regressions[multiReg].idxStart; idx < regressions[multiReg].idxEnd + 1; idx++)
                 {
@@ -885,10 +1006,10 @@ namespace qAlgorithms
             if (regressionOK[i] && min_MSE > sum_MSE[i])
             {
                 bool regOK = true;
-                for (size_t i = 0; i < selection->size(); i++)
+                for (size_t i = 0; i < eics.size(); i++)
                 {
                     size_t dfCount = 0;
-                    std::vector<bool> df = eics->at(selection->at(i)).df;
+                    std::span<const unsigned char> df = eics[i]->df;
                     for (size_t idx = regressions[i].idxStart; idx < regressions[i].idxEnd + 1; idx++)
                     {
                         dfCount += df[idx] ? 1 : 0;
@@ -912,6 +1033,7 @@ namespace qAlgorithms
             // scale is 0 by default, use that to check
             MultiRegression a;
             a.numPeaks = 0;
+            a.b0_vec.resize(1);
             a.b0_vec[0] = 0;
             return a; // this will lead to problems further down @todo
         }
@@ -920,10 +1042,10 @@ namespace qAlgorithms
 
         assert(bestReg.scale <= MAXSCALE);
 
-        for (size_t i = 0; i < selection->size(); i++)
+        for (size_t i = 0; i < eics.size(); i++)
         {
             size_t dfCount = 0;
-            std::vector<bool> df = eics->at(selection->at(i)).df;
+            std::span<const unsigned char> df = eics[i]->df;
             for (size_t idx = bestReg.idxStart; idx < bestReg.idxEnd + 1; idx++)
             {
                 dfCount += df[idx] ? 1 : 0;
@@ -931,13 +1053,12 @@ namespace qAlgorithms
             assert(dfCount > 4);
         }
 
-        bestReg.cum_RSS = std::vector<float>(eics->front().intensity.size(), 0); // @todo this is ugly
+        bestReg.cum_RSS = std::vector<float>(eics.front()->intensity.size(), 0); // @todo this is ugly
 
         for (size_t i = 0; i < numPeaks; i++)
         {
             RegCoeffs coeff{bestReg.b0_vec[i], bestReg.b1, bestReg.b2, bestReg.b3};
-            auto intensity = eics->at(selection->at(i)).intensity;
-            std::vector<float> cumRSS_local = cumulativeRSS(&intensity, &coeff, bestReg.idx_x0);
+            std::vector<float> cumRSS_local = cumulativeRSS(eics[i]->intensity, &coeff, bestReg.idx_x0);
             // the RSS for one mass trace is not useful for comparing multi-regressions, which is why the sum
             // over all different regressions is used. Sum of cumsums == cumsum of the sums
             vecSum(&bestReg.cum_RSS, &cumRSS_local);
@@ -947,9 +1068,9 @@ namespace qAlgorithms
         bestReg.scanEnd = eic->minScan + bestReg.idxEnd;
 
         // @todo remove diagnostics, add conditions: at least one DF per side of x0, at least five df in total per feature
-        for (size_t i = 0; i < selection->size(); i++)
+        for (size_t i = 0; i < eics.size(); i++)
         {
-            auto selDF = eics->at(selection->at(i)).df;
+            std::span<const unsigned char> selDF = eics[i]->df;
             int countHits = 0;
             for (size_t idx = bestReg.idxStart; idx < bestReg.idxEnd + 1; idx++)
             {
@@ -963,8 +1084,92 @@ namespace qAlgorithms
 
     constexpr auto INV_ARRAY = initialize();
 
+    constexpr MultiInverse calcMultiInverse(size_t scale, size_t numPeaks)
+    {
+        // xTx of the multi-regression is | m*I   1*vT |  with m = 2 * scale + 1 and v, G as in the single-peak xTx.
+        //                                | v*1T  n*G  |
+        // Solving the block system with the single-peak inverse gives C to F and B divided by n, the shared part
+        // of the b0 block is A2 = (a - 1/m) / n and the diagonal is A1 = 1/m + A2.
+        const double a = INV_ARRAY[scale * 6 + 0];
+        const double invPoints = 1.0 / double(2 * scale + 1);
+        const double n = double(numPeaks);
+        MultiInverse inv;
+        inv.A2 = (a - invPoints) / n;
+        inv.A1 = invPoints + inv.A2;
+        inv.B = INV_ARRAY[scale * 6 + 1] / n;
+        inv.C = INV_ARRAY[scale * 6 + 2] / n;
+        inv.D = INV_ARRAY[scale * 6 + 3] / n;
+        inv.E = INV_ARRAY[scale * 6 + 4] / n;
+        inv.F = INV_ARRAY[scale * 6 + 5] / n;
+        return inv;
+    }
+
+    constexpr std::array<MultiInverse, (MAXSCALE + 1) * (MULTI_INV_PEAKS + 1)> initMultiInverse()
+    {
+        // access: scale * (MULTI_INV_PEAKS + 1) + numPeaks. Scales below 2 and less than two peaks are not used
+        std::array<MultiInverse, (MAXSCALE + 1) * (MULTI_INV_PEAKS + 1)> invArray{};
+        for (size_t scale = 2; scale < MAXSCALE; scale++)
+        {
+            for (size_t numPeaks = 2; numPeaks <= MULTI_INV_PEAKS; numPeaks++)
+            {
+                invArray[scale * (MULTI_INV_PEAKS + 1) + numPeaks] = calcMultiInverse(scale, numPeaks);
+            }
+        }
+        return invArray;
+    }
+
+    constexpr auto MULTI_INV_ARRAY = initMultiInverse();
+
+    MultiInverse multiInverse(size_t scale, size_t numPeaks)
+    {
+        assert(scale > 1);
+        assert(scale < MAXSCALE);
+        assert(numPeaks > 1);
+        if (numPeaks <= MULTI_INV_PEAKS) [[likely]]
+        {
+            return MULTI_INV_ARRAY[scale * (MULTI_INV_PEAKS + 1) + numPeaks];
+        }
+        return calcMultiInverse(scale, numPeaks);
+    }
+
+    ProductSums makeProductSums(std::span<const float> intensity_log)
+    {
+        const size_t length = intensity_log.size();
+        ProductSums sums{std::vector<double>(length + 1, 0),
+                         std::vector<double>(length + 1, 0),
+                         std::vector<double>(length + 1, 0)};
+        for (size_t i = 0; i < length; i++)
+        {
+            const double y = intensity_log[i];
+            const double x = i;
+            sums.y[i + 1] = sums.y[i] + y;
+            sums.xy[i + 1] = sums.xy[i] + x * y;
+            sums.xxy[i + 1] = sums.xxy[i] + x * x * y;
+        }
+        return sums;
+    }
+
+    ProductSums combineSums(std::span<const ProductSums *const> parts)
+    {
+        assert(!parts.empty());
+        ProductSums sums = *parts[0];
+        for (size_t part = 1; part < parts.size(); part++)
+        {
+            assert(parts[part]->y.size() == sums.y.size());
+            for (size_t i = 0; i < sums.y.size(); i++)
+            {
+                sums.y[i] += parts[part]->y[i];
+                sums.xy[i] += parts[part]->xy[i];
+                sums.xxy[i] += parts[part]->xxy[i];
+            }
+        }
+        return sums;
+    }
+
     std::vector<MultiRegression> findCoefficients_multi( // @todo add option for a minimum scale
-        const std::vector<float> *intensity_log,
+        std::span<const ProductSums *const> parts,
+        const EICView eics,
+        const size_t idxStart,
         const unsigned int max_scale, // maximum scale that will be checked. Should generally be limited by peakFrame
         const unsigned int numPeaks,
         const unsigned int peakFrame) // how many points are covered per peak? For single-peak data, this is the length of intensity_log
@@ -1007,7 +1212,8 @@ namespace qAlgorithms
   | B   B   B   D  E  F |
   | B   B   B  -D  F  E |
 
-  Note that no more than seven different values are needed per scale.
+  Note that no more than seven different values are needed per scale. They are precalculated for every
+  combination of scale and numPeaks, see multiInverse().
 
   In general, we have two moving actions:
   1) step right through the intensity_log and calculate the convolution with the kernel
@@ -1034,21 +1240,16 @@ namespace qAlgorithms
    for i=10: 3 to 4 => i.e. loop is executed once for scale=3
    for i=11: 3 to 3 => i.e. loop is not executed
    */
-        assert(numPeaks <= 32); // this is the maximum size of the b0 array
         assert(numPeaks > 1);   // this is necessary since the A1 INV_ARRAY value is
         assert(max_scale > 1);
-        assert(max_scale <= MAXSCALE);
+        assert(max_scale < MAXSCALE);
+
+        assert(eics.size() == numPeaks);
+        assert(idxStart + peakFrame < parts[0]->y.size());
 
         const size_t minScale = 2;
         const size_t steps = peakFrame - 2 * minScale; // iteration number at scale 2
 
-        std::vector<float> y_array_sum(peakFrame, 0);
-        for (size_t i = 0; i < intensity_log->size(); i++)
-        {
-            size_t sumIdx = i % peakFrame;               // modulo means that i = peakframe -> sumIdx = 0
-            y_array_sum[sumIdx] += intensity_log->at(i); // total intensity for the combined regression at each RT step
-        }
-
         //   this vector is for the inner loop and looks like:
         //   [scale_min, scale_min +1 , .... scale_max, ... scale_min +1, scale_min]
         //   length of vector: num_steps
@@ -1066,117 +1267,86 @@ namespace qAlgorithms
         size_t iterationCount = std::accumulate(maxInnerLoop.begin(), maxInnerLoop.end(), 0) - maxInnerLoop.size(); // no range check necessary since every entry > 1
 
         std::vector<float> emptyRSS(numPeaks, NAN);
-        MultiRegression localEmpty = {{0}, emptyRSS, 0, 0, 0, 0, 0, 0, numPeaks, NAN, NAN, NAN, NAN};
+        MultiRegression localEmpty = {B0Coeffs(numPeaks), emptyRSS, 0, 0, 0, 0, 0, 0, numPeaks, NAN, NAN, NAN, NAN};
         std::vector<MultiRegression> coeffs(iterationCount, localEmpty);
 
-        // the product sums are the rows of the design matrix (xT) * intensity_log[i:i+4] (dot product)
+        // the product sums are the rows of the design matrix (xT) * intensity_log[a:b] (dot product). They are
+        // calculated from the prefix sums of y, x*y and x^2*y, so every window takes constant time per part and
+        // member. With c as the center of the window, the shared rows are:
+        // b1: sum((x - c) * y) = sum(xy) - c * sum(y)
+        // b2: sum((x - c)^2 * y) for x < c = sum(xxy) - 2c * sum(xy) + c^2 * sum(y), b3 is the same for x > c
         // The first n entries are contained in the b0 vector, one for each peak the regression is performed over.
-        double tmp_product_sum_b0[32]{NAN}; // one fully separate b0 per peak
-        double tmp_product_sum_b1;
-        double tmp_product_sum_b2;
-        double tmp_product_sum_b3;
+        auto windowSum = [](const std::vector<double> &prefix, size_t first, size_t last)
+        { return prefix[last + 1] - prefix[first]; };
+        auto quadSum = [&windowSum](const ProductSums *sums, size_t first, size_t last, double c)
+        {
+            return windowSum(sums->xxy, first, last) - 2 * c * windowSum(sums->xy, first, last) +
+                   c * c * windowSum(sums->y, first, last);
+        };
 
-        double sum_tmp_product_sum_b0 = 0; // sum of all elements in the tmp_product_sum_b0 vector
+        std::vector<double> tmp_product_sum_b0(numPeaks, NAN); // one fully separate b0 per peak
 
         size_t k = 0;
         for (size_t i = 0; i < steps; i++)
         {
-
-            // move along the intensity_log (outer loop)
-            // calculate the convolution with the kernel of the lowest scale (= 2), i.e. xT * intensity_log[i:i+4]
-            // tmp_product_sum_b0 = intensity_log[i:i+5].sum(axis=0) // numPeaks rows of xT * intensity_log[i:i+4]
-            for (size_t b0_elems = 0; b0_elems < numPeaks; b0_elems++)
+            // move along the intensity_log (outer loop), the center of all windows is i + 2
+            const size_t center = idxStart + i + 2;
+            const double c = double(center);
+            for (size_t scale = minScale; scale < maxInnerLoop[i] + 1; scale++)
             {
-                size_t x = b0_elems * peakFrame + i;
-                double tmpval = intensity_log->at(x) + intensity_log->at(x + 1) +
-                                intensity_log->at(x + 2) + intensity_log->at(x + 3) +
-                                intensity_log->at(x + 4); // b0 = 1 for all elements
-                tmp_product_sum_b0[b0_elems] = tmpval;
-                sum_tmp_product_sum_b0 += tmpval;
-            }
-            // sum_tmp_product_sum_b0 = std::accumulate(tmp_product_sum_b0.begin(), tmp_product_sum_b0.end(), 0.0);
-
-            tmp_product_sum_b1 = 2 * (y_array_sum[i + 4] - y_array_sum[i]) + y_array_sum[i + 3] - y_array_sum[i + 1];
-            tmp_product_sum_b2 = 4 * y_array_sum[i] + y_array_sum[i + 1];
-            tmp_product_sum_b3 = 4 * y_array_sum[i + 4] + y_array_sum[i + 3];
-
-            // A1 is modified  by -2 * b / numPeaks and not just /numPeaks
-            // use [12 + ...] since the array is constructed for the accession arry[scale * 6 + (0:5)]
-            const double S2_A1 = INV_ARRAY[12 + 0] - 2 * INV_ARRAY[12 + 1] / numPeaks;
-            // @todo replace the array with a struct and an accessor function
-            const double S2_A2 = -2 * INV_ARRAY[12 + 1] / numPeaks;
-            const double S2_B = INV_ARRAY[12 + 1] / numPeaks;
-            const double S2_C = INV_ARRAY[12 + 2] / numPeaks;
-            const double S2_D = INV_ARRAY[12 + 3] / numPeaks;
-            const double S2_E = INV_ARRAY[12 + 4] / numPeaks;
-            const double S2_F = INV_ARRAY[12 + 5] / numPeaks;
-
-            // this line is: a*t_i + b * sum(t without i)
-            // inv_array starts at scale = 2
-            for (size_t peak = 0; peak < numPeaks; peak++)
-            {
-                coeffs[k].b0_vec[peak] = S2_A2 * sum_tmp_product_sum_b0 + (S2_A1 - S2_A2) * tmp_product_sum_b0[peak] +
-                                         S2_B * (tmp_product_sum_b2 + tmp_product_sum_b3);
-            }
-
-            coeffs[k].b1 = S2_C * tmp_product_sum_b1 + S2_D * (tmp_product_sum_b2 - tmp_product_sum_b3);
-            coeffs[k].b2 = S2_B * sum_tmp_product_sum_b0 + S2_D * tmp_product_sum_b1 + S2_E * tmp_product_sum_b2 + S2_F * tmp_product_sum_b3;
-            coeffs[k].b3 = S2_B * sum_tmp_product_sum_b0 - S2_D * tmp_product_sum_b1 + S2_F * tmp_product_sum_b2 + S2_E * tmp_product_sum_b3;
-
-            coeffs[k].scale = 2;
-            coeffs[k].idxStart = i;
-
-            k += 1;       // update index for the productsums array
-            size_t u = 1; // u is the expansion increment
-            for (size_t scale = 3; scale < maxInnerLoop[i] + 1; scale++)
-            { // minimum scale is 2. so we start with scale + 1 = 3 in the inner loop
+                // minimum scale is 2, all larger scales expand the kernel to the left and right of the intensity_log
+                const size_t first = center - scale;
+                const size_t last = center + scale;
                 coeffs[k].scale = scale;
-                coeffs[k].idxStart = i - u;
-                size_t scale_sqr = scale * scale;
-                // expand the kernel to the left and right of the intensity_log.
-                sum_tmp_product_sum_b0 = 0;
+                coeffs[k].idxStart = first - idxStart;
+
+                double sum_tmp_product_sum_b0 = 0; // sum of all elements in the tmp_product_sum_b0 vector
                 for (size_t peak = 0; peak < numPeaks; peak++)
                 {
-                    tmp_product_sum_b0[peak] += intensity_log->at(i - u) + intensity_log->at(i + 4 + u);
-                    sum_tmp_product_sum_b0 += tmp_product_sum_b0[peak];
+                    double tmpval = windowSum(eics[peak]->productSums->y, first, last); // b0 = 1 for all elements
+                    tmp_product_sum_b0[peak] = tmpval;
+                    sum_tmp_product_sum_b0 += tmpval;
                 }
 
-                tmp_product_sum_b1 += scale * (y_array_sum[i + 4 + u] - y_array_sum[i - u]);
-                tmp_product_sum_b2 += scale_sqr * y_array_sum[i - u];
-                tmp_product_sum_b3 += scale_sqr * y_array_sum[i + 4 + u];
+                double tmp_product_sum_b1 = 0;
+                double tmp_product_sum_b2 = 0;
+                double tmp_product_sum_b3 = 0;
+                for (const ProductSums *sums : parts)
+                {
+                    tmp_product_sum_b1 += windowSum(sums->xy, first, last) - c * windowSum(sums->y, first, last);
+                    tmp_product_sum_b2 += quadSum(sums, first, center - 1, c);
+                    tmp_product_sum_b3 += quadSum(sums, center + 1, last, c);
+                }
 
-                // A1 is not modified if numPeaks is 1. It is, however, modified by -2 * b / numPeaks and not just /numPeaks if numPeaks > 1
-                const double inv_A1 = INV_ARRAY[12 + u * 6 + 0] - 2 * INV_ARRAY[12 + u * 6 + 1] / numPeaks;
-                // A2 is only defined for numPeaks > 1, set it to 0 to avoid conditional in loops
-                const double inv_A2 = -2 * INV_ARRAY[12 + u * 6 + 1] / numPeaks;
-                const double inv_B = INV_ARRAY[12 + u * 6 + 1] / numPeaks;
-                const double inv_C = INV_ARRAY[12 + u * 6 + 2] / numPeaks;
-                const double inv_D = INV_ARRAY[12 + u * 6 + 3] / numPeaks;
-                const double inv_E = INV_ARRAY[12 + u * 6 + 4] / numPeaks;
-                const double inv_F = INV_ARRAY[12 + u * 6 + 5] / numPeaks;
+                const MultiInverse inv = multiInverse(scale, numPeaks);
 
+                // this line is: a*t_i + b * sum(t without i)
                 for (size_t peak = 0; peak < numPeaks; peak++)
                 {
-                    coeffs[k].b0_vec[peak] = inv_A2 * sum_tmp_product_sum_b0 + (inv_A1 - inv_A2) * tmp_product_sum_b0[peak] +
-                                             inv_B * (tmp_product_sum_b2 + tmp_product_sum_b3);
+                    coeffs[k].b0_vec[peak] = inv.A2 * sum_tmp_product_sum_b0 + (inv.A1 - inv.A2) * tmp_product_sum_b0[peak] +
+                                             inv.B * (tmp_product_sum_b2 + tmp_product_sum_b3);
                 }
 
-                coeffs[k].b1 = inv_C * tmp_product_sum_b1 + inv_D * (tmp_product_sum_b2 - tmp_product_sum_b3);
-                coeffs[k].b2 = inv_B * sum_tmp_product_sum_b0 + inv_D * tmp_product_sum_b1 + inv_E * tmp_product_sum_b2 + inv_F * tmp_product_sum_b3;
-                coeffs[k].b3 = inv_B * sum_tmp_product_sum_b0 - inv_D * tmp_product_sum_b1 + inv_F * tmp_product_sum_b2 + inv_E * tmp_product_sum_b3;
+                coeffs[k].b1 = inv.C * tmp_product_sum_b1 + inv.D * (tmp_product_sum_b2 - tmp_product_sum_b3);
+                coeffs[k].b2 = inv.B * sum_tmp_product_sum_b0 + inv.D * tmp_product_sum_b1 + inv.E * tmp_product_sum_b2 + inv.F * tmp_product_sum_b3;
+                coeffs[k].b3 = inv.B * sum_tmp_product_sum_b0 - inv.D * tmp_product_sum_b1 + inv.F * tmp_product_sum_b2 + inv.E * tmp_product_sum_b3;
 
-                u += 1; // update expansion increment
                 k += 1; // update index for the productsums array
             }
         }
+        assert(k == iterationCount);
 
         return coeffs;
     }
 
     // @todo this funtion should be generalised to qPeaks also
-    double residual(const RegCoeffs *coeff, float realInt, size_t index_x0, size_t index, bool left)
+    void residualsHalf(const RegCoeffs *coeff, const float *realInt, double *squares,
+                       size_t index_x0, size_t idxStart, size_t idxEnd, bool left)
     {
-        float b23 = left ? coeff->b2 : coeff->b3;
+        // calculate the residual squares for all points from idxStart to idxEnd (exclusive) that lie on
+        // the same half of the regression. The coefficient and the maximum height are constant within
+        // one half, which removes all branches from the loop body
+        const float b23 = left ? coeff->b2 : coeff->b3;
         float maxHeight = INFINITY;
         if (b23 > 0) [[unlikely]]
         {
@@ -1184,45 +1354,80 @@ namespace qAlgorithms
             float maxPos = -coeff->b1 / (2 * (left ? coeff->b3 : coeff->b3));
             maxHeight = std::exp(coeff->b0 + (coeff->b1 + maxPos * b23) * maxPos); // correct for positive exponential
         }
+        const float b0 = coeff->b0;
+        const float b1 = coeff->b1;
 
-        double new_x = double(index) - double(index_x0);
-        double y_base = std::exp(coeff->b0 + (coeff->b1 + b23 * new_x) * new_x);
-        // in case a positive exponent half is in the new window, we need to prevent excessive distrotion from the exponential part
-        y_base = y_base <= maxHeight ? y_base : maxHeight / (new_x + 1); // halve with the first step from index_x0
-        double RS = (y_base - realInt) * (y_base - realInt);             // residual square
-        assert(RS < INFINITY);
-        return (RS);
+#pragma omp simd
+        for (size_t i = idxStart; i < idxEnd; i++)
+        {
+            double new_x = double(i) - double(index_x0);
+            double y_base = std::exp(b0 + (b1 + b23 * new_x) * new_x);
+            // in case a positive exponent half is in the new window, we need to prevent excessive distrotion from the exponential part
+            y_base = y_base <= maxHeight ? y_base : maxHeight / (new_x + 1); // halve with the first step from index_x0
+            squares[i] = (y_base - realInt[i]) * (y_base - realInt[i]);      // residual square
+        }
     }
 
-    std::vector<float> cumulativeRSS(const std::vector<float> *intensities,
+    std::vector<float> cumulativeRSS(std::span<const float> intensities,
                                      const RegCoeffs *coeff,
                                      size_t index_x0)
     {
-        assert(index_x0 < intensities->size() - 1);
-        std::vector<float> result(intensities->size(), 0);
-
-        result[0] = residual(coeff, intensities->front(), index_x0, 0, true) + 0;
+        const size_t length = intensities.size();
+        assert(index_x0 < length - 1);
+        assert(index_x0 > 0);
 
-        // left half - 1
-        for (size_t i = 1; i < index_x0; i++)
-        {
-            result[i] = residual(coeff, intensities->at(i), index_x0, i, true) + result[i - 1];
-        }
+        // the residuals are calculated separately for both halves, only the cumulative sum is sequential
+        std::vector<double> squares(length, 0);
+        residualsHalf(coeff, intensities.data(), squares.data(), index_x0, 0, index_x0, true);
         // center point
-        float diff = std::exp((coeff->b0)) - intensities->at(index_x0); // this will never be infinity
-        result[index_x0] = diff * diff + result[index_x0 - 1];
-        // right half
-        for (size_t i = index_x0 + 1; i < intensities->size(); i++)
+        float diff = std::exp((coeff->b0)) - intensities[index_x0]; // this will never be infinity
+        squares[index_x0] = diff * diff;
+        residualsHalf(coeff, intensities.data(), squares.data(), index_x0, index_x0 + 1, length, false);
+
+        std::vector<float> result(length, 0);
+        result[0] = squares[0];
+        for (size_t i = 1; i < length; i++)
         {
-            result[i] = residual(coeff, intensities->at(i), index_x0, i, false) + result[i - 1];
+            result[i] = squares[i] + result[i - 1];
         }
         assert(result.back() < INFINITY);
         return result;
     }
 
+    std::vector<ReducedEIC> harmoniseGroup(const PreGrouping *pregroup,
+                                           const unsigned int minScan,
+                                           const unsigned int maxScan,
+                                           EICMatrix *matrix)
+    {
+        const size_t numFeatures = pregroup->features.size();
+        const size_t length = maxScan - minScan + 1;
+        // the matrix is only allocated once per pre-group. Intensities are 0 by default so that all
+        // points which are not transferred from the bin are interpolated, df is set during the transfer
+        matrix->length = length;
+        matrix->intensity.assign(numFeatures * length, 0);
+        matrix->intensity_log.assign(numFeatures * length, 0);
+        matrix->RSS_cum.assign(numFeatures * length, 0);
+        matrix->df.assign(numFeatures * length, 0);
+        // one entry per row, the vector must not be resized afterwards since the EICs point into it
+        matrix->productSums.assign(numFeatures, ProductSums{});
+
+        std::vector<ReducedEIC> eics; // @todo the maximum size of a reduced EIC is the global maxscale + 1!
+        eics.reserve(numFeatures);
+        for (size_t j = 0; j < numFeatures; j++)
+        {
+            eics.push_back(harmoniseEIC(pregroup->features[j], &pregroup->EICs[j], j, matrix, minScan, maxScan));
+            eics.back().feature_ID = j;
+            // the sums are only calculated once per member and reused for every regression it takes part in
+            matrix->productSums[j] = makeProductSums(eics.back().intensity_log);
+            eics.back().productSums = &matrix->productSums[j];
+        }
+        return eics;
+    }
+
     ReducedEIC harmoniseEIC(const FeaturePeak *feature,
-                            const EIC *bin,
-                            const std::vector<float> *RTs,
+                            const BinView *bin,
+                            const size_t row,
+                            EICMatrix *matrix,
                             const unsigned int minScan, // minimum overall scan in the subgroup
                             const unsigned int maxScan) // maximum overall scan in the subgroup
     {
@@ -1234,31 +1439,32 @@ namespace qAlgorithms
         assert(maxScan > bin->scanNumbers.front());
         // this function creates harmonised EICs, meaning that it can be used for the running regression
         // within a component subgroup without further modification. The process is as follows:
-        // 1) create a results vector for every element which is of a size known at the time of function call
+        // 1) select the row of the pre-group matrix, its size is known at the time of function call
 
         const unsigned int length = maxScan - minScan + 1;
         assert(length > 4);
-        assert(RTs->size() == length);
+        assert(matrix->length == length);
+        assert((row + 1) * length <= matrix->intensity.size());
         assert(bin->ints_area[minIdx] != 0);
         assert(bin->ints_area[maxIdx] != 0);
 
+        std::span<float> intensity(matrix->intensity.data() + row * length, length);
+        std::span<float> intensity_log(matrix->intensity_log.data() + row * length, length);
+        std::span<float> RSS_cum(matrix->RSS_cum.data() + row * length, length);
+        std::span<unsigned char> df(matrix->df.data() + row * length, length);
+
         // scan relates to the complete measurement and idx to the position within the bin
 
         // find index_x0 by finding the corresponding retention time
-        // unsigned int featLim_L = bin->scanNumbers[minIdx] - minScan;
-        // unsigned int featLim_R = bin->scanNumbers[maxIdx] - minScan;
-        // assert(featLim_L < featLim_R);
         const unsigned int scanShift = feature->scanPeakStart - minScan; // offset of feature limits relating to the first element of the harmonised EIC
         unsigned int index_x0 = feature->index_x0_offset + scanShift;    // absolute scan of x0 - begin of scan region
         assert(index_x0 < length - 2);
 
         ReducedEIC reduced{
-            std::vector<float>(length, 0),        // intensity
-            std::vector<float>(length, 0),        // log intensity
-            std::vector<unsigned int>(length, 0), // scan number
-            std::vector<float>(length, 0),        // RSS_cum
-            std::vector<bool>(length, true),      // degrees of freedom
-            // std::vector<int>(length, 0),
+            intensity,
+            intensity_log,
+            RSS_cum,
+            df,
             0,               // feature ID is only initialised after function execution
             feature->idxBin, // bin ID
             minScan,
@@ -1270,69 +1476,68 @@ namespace qAlgorithms
             length - 1,
             0};
 
-        std::iota(reduced.scanNo.begin(), reduced.scanNo.end(), minScan);
-
-        // 2) transfer all points that will not be interpolated.
+        // 2) transfer all points that will not be interpolated. The bin is sorted by scans, so the
+        //    first relevant point is found by binary search
 
-        for (size_t i = 0; i < bin->ints_area.size(); i++) // indices in relation to bin without interpolations
+        auto firstScan = std::lower_bound(bin->scanNumbers.begin(), bin->scanNumbers.end(), minScan);
+        for (size_t i = firstScan - bin->scanNumbers.begin(); i < bin->ints_area.size(); i++) // indices in relation to bin without interpolations
         {
             size_t scan = bin->scanNumbers[i];
-            if (scan < minScan)
-            {
-                continue;
-            }
-            else if (scan > maxScan)
+            if (scan > maxScan)
             {
                 break;
             }
 
             size_t relIdx = scan - minScan;
             assert(bin->ints_area[i] > 0);
-            reduced.intensity[relIdx] = bin->ints_area[i];
-            reduced.intensity_log[relIdx] = log(bin->ints_area[i]);
+            intensity[relIdx] = bin->ints_area[i];
+            intensity_log[relIdx] = log(bin->ints_area[i]);
         }
         // add points from outside the window?
 
         // 3) interpolate all intensities at 0
         for (size_t i = 0; i < length; i++)
         {
-            if (reduced.intensity_log[i] == 0)
-            { // value needs to be interpolated
-                float b23 = i < index_x0 ? feature->coefficients.b2 : feature->coefficients.b3;
-                double xval = double(i) - double(index_x0);
-                float predictedInt = feature->coefficients.b0 + xval * feature->coefficients.b1 + xval * xval * b23;
-                if (b23 > 0) [[unlikely]]
+            if (intensity_log[i] != 0)
+            {
+                df[i] = 1;
+                continue;
+            }
+            // value needs to be interpolated
+            float b23 = i < index_x0 ? feature->coefficients.b2 : feature->coefficients.b3;
+            double xval = double(i) - double(index_x0);
+            float predictedInt = feature->coefficients.b0 + xval * feature->coefficients.b1 + xval * xval * b23;
+            if (b23 > 0) [[unlikely]]
+            {
+                // stopgap solution for positive coefficients, this is very likely a suboptimal idea @todo
+                if (i + minScan < feature->scanPeakStart)
                 {
-                    // stopgap solution for positive coefficients, this is very likely a suboptimal idea @todo
-                    if (i + minScan < feature->scanPeakStart)
-                    {
-                        predictedInt = reduced.intensity_log[reduced.featLim_L];
-                    }
-                    else if (i + minScan > feature->scanPeakEnd)
-                    {
-                        predictedInt = reduced.intensity_log[reduced.featLim_R];
-                    }
+                    predictedInt = intensity_log[reduced.featLim_L];
+                }
+                else if (i + minScan > feature->scanPeakEnd)
+                {
+                    predictedInt = intensity_log[reduced.featLim_R];
                 }
-                // @todo this is a poor solution, but probably better than having a baseline at zero
-                predictedInt = predictedInt > lowestAreaLog ? predictedInt : lowestAreaLog;
-
-                reduced.intensity_log[i] = predictedInt;
-                reduced.intensity[i] = std::exp(predictedInt);
-                assert(reduced.intensity[i] > 0);
-                reduced.df[i] = false;
             }
+            // @todo this is a poor solution, but probably better than having a baseline at zero
+            predictedInt = predictedInt > lowestAreaLog ? predictedInt : lowestAreaLog;
+
+            intensity_log[i] = predictedInt;
+            intensity[i] = std::exp(predictedInt);
+            assert(intensity[i] > 0);
         }
         // 4) calculate the RSS for all transferred points against the moved regression and write them into
         //    the 0-filled vector for cumRSS. Then, take the cumsum over the vector.
-        reduced.RSS_cum = cumulativeRSS(&reduced.intensity, &feature->coefficients, index_x0);
-        assert(reduced.RSS_cum.back() != INFINITY);
+        std::vector<float> cumRSS = cumulativeRSS(intensity, &feature->coefficients, index_x0);
+        assert(cumRSS.back() != INFINITY);
+        std::copy(cumRSS.begin(), cumRSS.end(), RSS_cum.begin());
 
         // set the inclusion limits by finding the fifth point from either side that is not interpolated
         {
             size_t realCountL = 0;
             for (size_t i = 0; i < length; i++)
             {
-                if (reduced.df[i])
+                if (df[i])
                 {
                     realCountL++;
                 }
@@ -1345,7 +1550,7 @@ namespace qAlgorithms
             size_t realCountR = 0;
             for (size_t i = length - 1; i > 0; i--)
             {
-                if (reduced.df[i])
+                if (df[i])
                 {
                     realCountR++;
                 }
@@ -1388,52 +1593,57 @@ namespace qAlgorithms
     {
         // @todo there is a failure here despite the simple
         assert(rss_complex < rss_simple);
-        // @todo consider if this part of the code can be sped up by hashing the computations dependent on dfn and dfd
         float alpha = 0.05; // @todo is a set alpha really the best possible solution?
-        // problem: pre-calculation of all relevant f values could result in a very large array
-        // possible max size of 20 seems reasonable, maximum observed is 6
-        int which = 1; // select mode of library function and check computation result
-        double p = 0;  // not required
-        double q = 0;  // return value, equals p - 1
         double F = ((rss_simple - rss_complex) / 3) / (rss_complex / float(n_total - p_complex));
         double dfn = 3;                   // numerator degrees of freedom is always 3, since the simple model has three coeffs less (simplification due to pairwise comparison)
         double dfd = n_total - p_complex; // denominator degrees of freedom
-        int status = 1;                   // result invalid if this is not 0
-        double bound = 0;                 // allows recovery from non-0 status
 
-        // @todo replace with lookup table
+        // the critical values for alpha = 0.05 are precalculated for up to 256 denominator degrees of freedom.
+        // The merged model is not worse than the complex version if F is below the critical value
+        constexpr size_t tableSize = sizeof(F_VALUES_MERGE) / sizeof(F_VALUES_MERGE[0]);
+        if (size_t(dfd) - 1 < tableSize) [[likely]]
+        {
+            return F < F_VALUES_MERGE[size_t(dfd) - 1];
+        }
+
+        int which = 1;    // select mode of library function and check computation result
+        double p = 0;     // not required
+        double q = 0;     // return value, equals p - 1
+        int status = 1;   // result invalid if this is not 0
+        double bound = 0; // allows recovery from non-0 status
+
         cdff(&which, &p, &q, &F, &dfn, &dfd, &status, &bound); // library function, see https://people.math.sc.edu/Burkardt/cpp_src/cdflib/cdflib.html
         assert(status == 0);
 
         return q > alpha; // the merged model is not worse than the complex version, both can be merged
     }
 
-    float simpleRSS(std::vector<float> *RSS_simple_cum,
-                    std::vector<float> *RSS_complex_cum_A,
-                    std::vector<float> *RSS_complex_cum_B,
+    float simpleRSS(std::span<const float> RSS_simple_cum,
+                    std::span<const float> RSS_complex_cum_A,
+                    std::span<const float> RSS_complex_cum_B,
                     size_t idxStart,
                     size_t idxEnd,
                     size_t peakCount,
                     size_t p_complex)
     {
-        if (RSS_simple_cum->empty())
+        if (RSS_simple_cum.empty())
         {
             return INFINITY; // @todo this is a bad idea
         }
 
-        assert(RSS_simple_cum->size() == RSS_complex_cum_A->size());
-        assert(RSS_simple_cum->size() == RSS_complex_cum_B->size());
+        assert(RSS_simple_cum.size() == RSS_complex_cum_A.size());
+        assert(RSS_simple_cum.size() == RSS_complex_cum_B.size());
         assert(idxStart < idxEnd);
 
         bool zero = idxStart == 0;
 
-        float substract_S = zero ? 0 : RSS_simple_cum->at(idxStart - 1);
-        float substract_cA = zero ? 0 : RSS_complex_cum_A->at(idxStart - 1);
-        float substract_cB = zero ? 0 : RSS_complex_cum_B->at(idxStart - 1);
+        float substract_S = zero ? 0 : RSS_simple_cum[idxStart - 1];
+        float substract_cA = zero ? 0 : RSS_complex_cum_A[idxStart - 1];
+        float substract_cB = zero ? 0 : RSS_complex_cum_B[idxStart - 1];
 
-        float RSS_simple = RSS_simple_cum->at(idxEnd) - substract_S;
-        float RSS_complex = RSS_complex_cum_A->at(idxEnd) - substract_cA +
-                            RSS_complex_cum_B->at(idxEnd) - substract_cB;
+        float RSS_simple = RSS_simple_cum[idxEnd] - substract_S;
+        float RSS_complex = RSS_complex_cum_A[idxEnd] - substract_cA +
+                            RSS_complex_cum_B[idxEnd] - substract_cB;
 
         assert(RSS_complex < INFINITY); // @todo this is not a good solution to the positive coefficient problem
 
@@ -1461,33 +1671,33 @@ namespace qAlgorithms
         }
     }
 
-    // helper function: produce scaled intensity vector within the limits
-    inline std::vector<float> euclidianNorm(const std::vector<float> *intensity,
-                                            size_t idxStart,
-                                            size_t idxEnd)
+    // helper function: write the scaled intensity vector within the limits to result
+    inline void euclidianNorm(std::span<const float> intensity,
+                              size_t idxStart,
+                              size_t idxEnd,
+                              std::span<float> result)
     {
         // the vector is normed by dividing every element by the length
         size_t numElements = idxEnd - idxStart + 1;
+        assert(result.size() == numElements);
+        const float *values = intensity.data() + idxStart;
 
         float length = 0;
+#pragma omp simd reduction(+ : length)
         for (size_t i = 0; i < numElements; i++)
         {
-            float int_i = intensity->at(i + idxStart);
-            assert(int_i > 0);
-            length += int_i * int_i;
+            length += values[i] * values[i];
         }
         length = sqrt(length);
 
-        std::vector<float> result(numElements, 0);
+#pragma omp simd
         for (size_t i = 0; i < numElements; i++)
         {
-            result[i] = intensity->at(i + idxStart) / length;
+            result[i] = values[i] / length;
         }
-        return result; // @todo no reason to not mutate the reference / another reference
     }
 
-    float tanimotoScore(const std::vector<ReducedEIC> *eics,
-                        const std::vector<size_t> *selection,
+    float tanimotoScore(const EICView eics,
                         size_t idxStart,
                         size_t idxEnd)
     {
@@ -1502,84 +1712,62 @@ namespace qAlgorithms
 
         // solution to the multi-reg problem: Always take minimum and maximum of all points at a given RT / scan number
 
-        // 1) scale all regressions to vector length 1
+        // 1) scale all regressions to vector length 1 and track the minimum and maximum at every point.
         // this function discards all non-intensity information since no gaps exist in reduced EICs
         assert(idxEnd > idxStart);
-        size_t numFeats = selection->size();
+        size_t numFeats = eics.size();
         assert(numFeats > 1);
-        assert(numFeats <= eics->size());
         size_t length = idxEnd - idxStart + 1;
 
-        std::vector<std::vector<float>> scaledIntensities(numFeats, std::vector<float>(length, 0));
-
         for (size_t i = 0; i < numFeats; i++)
         {
-            size_t id = selection->at(i);
-            scaledIntensities[i] = euclidianNorm(&(eics->at(id).intensity), idxStart, idxEnd);
+            assert(std::all_of(eics[i]->intensity.begin() + idxStart, eics[i]->intensity.begin() + idxEnd + 1,
+                               [](float val)
+                               { return val > 0; }));
         }
 
-        // first attempt: use the square sums || comclusion: not really functional
-        double minSQ = 0;
-        double maxSQ = 0;
-        double minXmax = 0;
-        for (size_t element = 0; element < length; element++)
+        // the features are processed one after another, so that the inner loop runs over contiguous memory
+        std::vector<float> scaled(length, 0);
+        std::vector<float> minScaled(length, INFINITY);
+        std::vector<float> maxScaled(length, 0);
+        for (size_t feat = 0; feat < numFeats; feat++)
         {
-            // min and max of the scaled intensities @todo cache inefficient, consider storing the data differently
-            double min = INFINITY;
-            double max = 0;
-            for (size_t feat = 0; feat < numFeats; feat++)
+            euclidianNorm(eics[feat]->intensity, idxStart, idxEnd, scaled);
+#pragma omp simd
+            for (size_t element = 0; element < length; element++)
             {
-                double val = scaledIntensities[feat][element];
-                min = min < val ? min : val;
-                max = max > val ? max : val;
+                minScaled[element] = minScaled[element] < scaled[element] ? minScaled[element] : scaled[element];
+                maxScaled[element] = maxScaled[element] > scaled[element] ? maxScaled[element] : scaled[element];
             }
-            minSQ += min * min;
-            maxSQ += max * max;
-            minXmax += min * max;
         }
 
+        // first attempt: use the square sums || comclusion: not really functional
         // second attempt: use the unmodified area (harmonised scale means every x is 1, so the area is the mean of i and i+1.
         // since every i is accessed twice, the sum of all minima / maxima - the outermost two values is the final area)
+        // both are calculated in one pass over the extrema
+        double minSQ = 0;
+        double maxSQ = 0;
+        double minXmax = 0;
         double area_min = 0;
         double area_max = 0;
         for (size_t element = 0; element < length; element++)
         {
-            // min and max of the scaled intensities @todo cache inefficient, consider storing the data differently
-            double min = INFINITY;
-            double max = 0;
-            for (size_t feat = 0; feat < numFeats; feat++)
-            {
-                double val = scaledIntensities[feat][element];
-                min = min < val ? min : val;
-                max = max > val ? max : val;
-            }
+            double min = minScaled[element];
+            double max = maxScaled[element];
+            minSQ += min * min;
+            maxSQ += max * max;
+            minXmax += min * max;
             area_min += min;
             area_max += max;
         }
-        {
-            // outer vals
-            double min_L = INFINITY;
-            double max_L = 0;
-            double min_R = INFINITY;
-            double max_R = 0;
-            for (size_t feat = 0; feat < numFeats; feat++)
-            {
-                double val_L = scaledIntensities[feat].front();
-                double val_R = scaledIntensities[feat].back();
-                min_L = min_L < val_L ? min_L : val_L;
-                max_L = max_L > val_L ? max_L : val_L;
-                min_R = min_R < val_R ? min_R : val_R;
-                max_R = max_R > val_R ? max_R : val_R;
-            }
-            area_min += (min_L + min_R) / 2;
-            area_max += (max_L + max_R) / 2;
-        }
+        // outer vals
+        area_min += (double(minScaled.front()) + double(minScaled.back())) / 2;
+        area_max += (double(maxScaled.front()) + double(maxScaled.back())) / 2;
 
         double DQS_new = area_min / area_max;
         // assert(DQS_new < 1);
         if (DQS_new >= 1)
         {
-            ERRORCOUNTER++;
             return -1;
         }
 
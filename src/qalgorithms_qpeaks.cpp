@@ -26,8 +26,7 @@ namespace qAlgorithms
         centroids.push_back({0, 0, 0, 0, 0, 0, 0, 0}); // this centroid will be used for ever missing value
         for (size_t i = 0; i < allPeaks->size(); ++i)
         {
-            CentroidPeak peak = allPeaks->at(i);
-            qCentroid F = qCentroid{peak.mz, peak.mzUncertainty, peak.scanNumber, peak.area, peak.height, peak.DQSC, peak.df, totalCentroids};
+            qCentroid F = binningCentroid(&allPeaks->at(i), totalCentroids);
             assert(F.scanNo > 0);
             centroids.push_back(F);
             ++totalCentroids;
@@ -35,6 +34,11 @@ namespace qAlgorithms
         assert(centroids.size() > 4);
         return centroids;
     }
+
+    qCentroid binningCentroid(const CentroidPeak *peak, unsigned int cenID)
+    {
+        return qCentroid{peak->mz, peak->mzUncertainty, peak->scanNumber, peak->area, peak->height, peak->DQSC, peak->df, cenID};
+    }
 #pragma endregion "pass to qBinning"
 
     constexpr auto INV_ARRAY = initialize(); // this only works with constexpr square roots, which are part of C++26
@@ -671,7 +675,7 @@ namespace qAlgorithms
         */
 
         calcPeakHeightUncert(mutateReg, mse, scale);                   // @todo independent of b0
-        if (1 / mutateReg->uncertainty_height <= T_VALUES[df_sum - 5]) // statistical significance of the peak height
+        if (1 / mutateReg->uncertainty_height <= tQuantile(df_sum)) // statistical significance of the peak height
         {
             return;
         }
@@ -694,7 +698,7 @@ namespace qAlgorithms
         // it might be preferential to combine both functions again or store the common matrix somewhere
         calcPeakAreaUncert(mutateReg, mse, scale);
 
-        if (mutateReg->area / mutateReg->uncertainty_area <= T_VALUES[df_sum - 5])
+        if (mutateReg->area / mutateReg->uncertainty_area <= tQuantile(df_sum))
         {
             return; // statistical insignificance of the area
         }
@@ -707,7 +711,7 @@ namespace qAlgorithms
           value in the CHI_SQUARES, the regression is invalid.
         */
         float chiSquare = calcSSE_chisqared(mutateReg->coeffs, intensities, mutateReg->left_limit, mutateReg->right_limit, idx_x0);
-        if (chiSquare < CHI_SQUARES[df_sum - 5])
+        if (chiSquare < chiSquareQuantile(df_sum))
         {
             return; // statistical insignificance of the chi-square value
         }
@@ -879,8 +883,8 @@ namespace qAlgorithms
         return {float(weighted_mean), float(uncertaintiy)};
     };
 
-    MeanVar weightedMeanAndVariance_EIC(const std::vector<float> *weight,
-                                        const std::vector<float> *values,
+    MeanVar weightedMeanAndVariance_EIC(std::span<const float> weight,
+                                        std::span<const float> values,
                                         size_t left_limit,
                                         size_t right_limit)
     {
@@ -891,9 +895,9 @@ namespace qAlgorithms
         double sum_weight = 0.0;     // sum of weight
         for (size_t j = left_limit; j <= right_limit; j++)
         {
-            mean_weights += (*weight)[j];
-            sum_weighted_x += (*values)[j] * (*weight)[j];
-            sum_weight += (*weight)[j];
+            mean_weights += weight[j];
+            sum_weighted_x += values[j] * weight[j];
+            sum_weight += weight[j];
         }
         mean_weights /= realPoints;
         sum_weighted_x /= mean_weights;
@@ -903,7 +907,7 @@ namespace qAlgorithms
         double sum_Qxxw = 0.0; // sum of (values - mean)^2 * weight
         for (size_t j = left_limit; j <= right_limit; j++)
         {
-            sum_Qxxw += ((*values)[j] - weighted_mean) * ((*values)[j] - weighted_mean) * (*weight)[j];
+            sum_Qxxw += (values[j] - weighted_mean) * (values[j] - weighted_mean) * weight[j];
         }
         float uncertaintiy = std::sqrt(sum_Qxxw / sum_weight / realPoints);
         return {float(weighted_mean), float(uncertaintiy)};
@@ -1354,7 +1358,7 @@ namespace qAlgorithms
         float tValue = std::max(                                   // t-value for the quadratic term
             std::abs(coeff.b2),                                    // t-value for the quadratic term left side of the peak
             std::abs(coeff.b3));                                   // t-value for the quadratic term right side of the peak
-        return tValue > T_VALUES[df_sum - 5] * divisor;            // statistical significance of the quadratic term
+        return tValue > tQuantile(df_sum) * divisor;            // statistical significance of the quadratic term
         // note that the tvalue would have to be divided by the divisor, but this is not always compiled to a multiplication
     }
 #pragma endregion isValidQuadraticTerm
@@ -1416,7 +1420,7 @@ namespace qAlgorithms
             Jacobian_height2[3] = apex_position * apex_position - valley_position * valley_position; // adjust for uncertainty calculation of apex to edge ratio
         }
         float uncertainty_apexToEdge = std::sqrt(mse * multiplyVecMatrixVecTranspose(Jacobian_height2, scale));
-        return (apexToEdge - 2) / (apexToEdge * uncertainty_apexToEdge) > T_VALUES[df_sum - 5];
+        return (apexToEdge - 2) / (apexToEdge * uncertainty_apexToEdge) > tQuantile(df_sum);
     }
 #pragma endregion isValidPeakHeight
 
@@ -1585,7 +1589,7 @@ namespace qAlgorithms
 
         float area_uncertainty_covered = std::sqrt(mse * multiplyVecMatrixVecTranspose(J_covered, doubleScale));
 
-        return J_covered[0] > T_VALUES[df_sum - 5] * area_uncertainty_covered; // statistical significance of the peak area (boolean)
+        return J_covered[0] > tQuantile(df_sum) * area_uncertainty_covered; // statistical significance of the peak area (boolean)
     }
 #pragma endregion isValidPeakArea
 
@@ -0,0 +1,220 @@
+#include "qalgorithms_spectrum_cache.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace qAlgorithms
+{
+    std::filesystem::path spectrumCachePath(const std::filesystem::path &pathSource)
+    {
+        std::filesystem::path pathCache = pathSource;
+        pathCache += ".qcache";
+        return pathCache;
+    }
+
+    bool writeSpectrumCache(StreamCraft::MZML *data, const std::filesystem::path &pathCache, const std::string &sourceHash)
+    {
+        if (sourceHash.size() >= SPECTRUM_CACHE_HASH_LENGTH)
+        {
+            return false;
+        }
+        std::vector<unsigned int> accessor(data->number_spectra, 0);
+        std::iota(accessor.begin(), accessor.end(), 0);
+        const std::vector<size_t> indices = data->get_spectra_index(&accessor);
+        const std::vector<int> levels = data->get_spectra_level(&accessor);
+        const std::vector<bool> modes = data->get_spectra_mode(&accessor);
+        const std::vector<bool> polarities = data->get_spectra_polarity(&accessor);
+        // the retention times and arrays are requested by the index of the spectrum, like in findCentroids_MZML
+        std::vector<unsigned int> selectedIndices(indices.begin(), indices.end());
+        const std::vector<double> retentionTimes = data->get_spectra_RT(&selectedIndices);
+
+        SpectrumCacheHeader header;
+        memcpy(header.magic, SPECTRUM_CACHE_MAGIC, sizeof(header.magic));
+        header.version = SPECTRUM_CACHE_VERSION;
+        memset(header.sourceHash, 0, sizeof(header.sourceHash));
+        memcpy(header.sourceHash, sourceHash.data(), sourceHash.size());
+        header.spectrumCount = indices.size();
+
+        std::vector<SpectrumEntry> entries(indices.size());
+        for (size_t i = 0; i < indices.size(); i++)
+        {
+            entries[i].retentionTime = retentionTimes[i];
+            entries[i].index = indices[i];
+            entries[i].dataOffset = 0;
+            entries[i].pointCount = 0;
+            entries[i].level = levels[i];
+            entries[i].profile = modes[i];
+            entries[i].positive = polarities[i];
+        }
+
+        std::filesystem::path pathTemporary = pathCache;
+        pathTemporary += ".tmp";
+        std::ofstream file_out(pathTemporary, std::ios::out | std::ios::binary);
+        if (!file_out.is_open())
+        {
+            return false;
+        }
+        // the metadata is only complete once all arrays are written, it is written again at the end
+        const size_t metadataSize = sizeof(header) + entries.size() * sizeof(SpectrumEntry);
+        file_out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file_out.write(reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(SpectrumEntry));
+        size_t position = metadataSize;
+        for (size_t i = 0; i < entries.size() && file_out.good(); i++)
+        {
+            if (entries[i].level != 1) // only MS1 spectra are centroided
+            {
+                continue;
+            }
+            const std::vector<std::vector<double>> spectrum = data->get_spectrum(indices[i]);
+            const std::vector<double> *mz = &spectrum.at(0);
+            const std::vector<double> *intensity = &spectrum.at(1);
+            if (mz->size() != intensity->size())
+            {
+                std::cerr << "Warning: spectrum " << indices[i] << " has a different number of m/z and intensity values\n";
+                file_out.setstate(std::ios::failbit);
+                break;
+            }
+            entries[i].dataOffset = position;
+            entries[i].pointCount = mz->size();
+            file_out.write(reinterpret_cast<const char *>(mz->data()), mz->size() * sizeof(double));
+            file_out.write(reinterpret_cast<const char *>(intensity->data()), intensity->size() * sizeof(double));
+            position += 2 * mz->size() * sizeof(double);
+        }
+        file_out.seekp(sizeof(header));
+        file_out.write(reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(SpectrumEntry));
+        file_out.close();
+
+        std::error_code error;
+        if (!file_out.fail())
+        {
+            std::filesystem::rename(pathTemporary, pathCache, error);
+        }
+        if (file_out.fail() || error)
+        {
+            std::filesystem::remove(pathTemporary, error);
+            return false;
+        }
+        return true;
+    }
+
+    SpectrumCache::SpectrumCache(const std::filesystem::path &pathCache, const std::string &sourceHash)
+    {
+        if (!std::filesystem::exists(pathCache))
+        {
+            return;
+        }
+#ifndef _WIN32
+        int fd = open(pathCache.c_str(), O_RDONLY);
+        if (fd != -1)
+        {
+            struct stat info;
+            if (fstat(fd, &info) == 0 && info.st_size > 0)
+            {
+                void *map = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (map != MAP_FAILED)
+                {
+                    data = static_cast<const char *>(map);
+                    size = info.st_size;
+                    mapped = true;
+                }
+            }
+            close(fd);
+        }
+#endif
+        if (!mapped)
+        {
+            std::ifstream file(pathCache, std::ios::binary | std::ios::ate);
+            if (!file.is_open())
+            {
+                std::cerr << "Warning: could not open the spectrum cache " << pathCache << "\n";
+                return;
+            }
+            buffer.resize(file.tellg());
+            file.seekg(0);
+            file.read(buffer.data(), buffer.size());
+            data = buffer.data();
+            size = buffer.size();
+        }
+
+        // a cache of an older version of the file is silently replaced, only damaged files are reported
+        const SpectrumCacheHeader *header = reinterpret_cast<const SpectrumCacheHeader *>(data);
+        bool correct = size >= sizeof(SpectrumCacheHeader) &&
+                       memcmp(header->magic, SPECTRUM_CACHE_MAGIC, sizeof(SPECTRUM_CACHE_MAGIC)) == 0 &&
+                       header->version == SPECTRUM_CACHE_VERSION &&
+                       header->spectrumCount <= (size - sizeof(SpectrumCacheHeader)) / sizeof(SpectrumEntry);
+        if (!correct)
+        {
+            std::cerr << "Warning: " << pathCache << " is not a valid spectrum cache (version "
+                      << SPECTRUM_CACHE_VERSION << "), it is written again\n";
+            release();
+            return;
+        }
+        if (strncmp(header->sourceHash, sourceHash.c_str(), SPECTRUM_CACHE_HASH_LENGTH) != 0)
+        {
+            release();
+            return;
+        }
+        for (const SpectrumEntry &entry : spectra())
+        {
+            const size_t length = 2 * entry.pointCount * sizeof(double);
+            if (entry.dataOffset % alignof(double) != 0 || entry.dataOffset > size ||
+                entry.pointCount > size || length > size - entry.dataOffset)
+            {
+                std::cerr << "Warning: the spectrum cache " << pathCache << " is damaged, it is written again\n";
+                release();
+                return;
+            }
+        }
+    }
+
+    SpectrumCache::~SpectrumCache()
+    {
+        release();
+    }
+
+    void SpectrumCache::release()
+    {
+#ifndef _WIN32
+        if (mapped)
+        {
+            munmap(const_cast<char *>(data), size);
+        }
+#endif
+        mapped = false;
+        data = nullptr;
+        size = 0;
+        buffer.clear();
+    }
+
+    std::span<const SpectrumEntry> SpectrumCache::spectra() const
+    {
+        if (data == nullptr)
+        {
+            return {};
+        }
+        const SpectrumCacheHeader *header = reinterpret_cast<const SpectrumCacheHeader *>(data);
+        return std::span<const SpectrumEntry>(reinterpret_cast<const SpectrumEntry *>(data + sizeof(SpectrumCacheHeader)),
+                                              header->spectrumCount);
+    }
+
+    SpectrumArrays SpectrumCache::spectrum(size_t position) const
+    {
+        const SpectrumEntry *entry = &spectra()[position];
+        if (entry->dataOffset == 0)
+        {
+            return {};
+        }
+        const double *values = reinterpret_cast<const double *>(data + entry->dataOffset);
+        return SpectrumArrays{std::span<const double>(values, entry->pointCount),
+                              std::span<const double>(values + entry->pointCount, entry->pointCount)};
+    }
+}
@@ -0,0 +1,177 @@
+// micro-benchmark of binningCritVal and of the subsetMZ loop that calls it for every candidate split, compared
+// with the previous implementation that calculated the log / sqrt expression in every call.
+// usage: bench_critval [mass traces] [scans]
+// Returns 1 if the critical values or the resulting bins differ.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "../include/qalgorithms_qbin.h"
+#include "../include/qalgorithms_global_vars.h"
+
+using namespace qAlgorithms;
+
+#pragma region "reference implementation"
+
+double referenceCritVal(size_t n, double stdDev)
+{
+    return (OS_CRIT_A + (OS_CRIT_B / std::sqrt(std::log(n + 1)))) * stdDev;
+}
+
+// Bin::subsetMZ with the critical value calculated in every call
+void referenceSubsetMZ(Bin *bin, std::vector<Bin> *bincontainer, std::vector<const qCentroid *> &notInBins,
+                       const std::vector<double> &OS, const std::vector<double> &cumError,
+                       const unsigned int binStartInOS, const unsigned int binEndInOS)
+{
+    const int binsizeInOS = binEndInOS - binStartInOS + 1;
+    auto pmax = std::max_element(OS.begin() + binStartInOS, OS.begin() + binEndInOS);
+    double max = *pmax;
+    double vcrit = referenceCritVal(binsizeInOS, (cumError[binEndInOS] - cumError[binStartInOS]) / binsizeInOS);
+    if (max < vcrit)
+    {
+        Bin output(bin->pointsInBin.begin() + binStartInOS, bin->pointsInBin.begin() + binEndInOS + 1);
+        output.mzMin = output.pointsInBin.front()->mz;
+        output.mzMax = output.pointsInBin.back()->mz;
+        output.unchanged = true;
+        output.medianMZ = output.pointsInBin[output.pointsInBin.size() / 2]->mz;
+        bincontainer->push_back(output);
+        return;
+    }
+    const int cutpos = std::distance(OS.begin() + binStartInOS, pmax);
+    if (cutpos + 1 > 4)
+    {
+        referenceSubsetMZ(bin, bincontainer, notInBins, OS, cumError, binStartInOS, binStartInOS + cutpos);
+    }
+    else
+    {
+        for (int i = 0; i < cutpos + 1; i++)
+        {
+            notInBins.push_back(bin->pointsInBin[binStartInOS + i]);
+        }
+    }
+    if (binEndInOS - binStartInOS - cutpos - 1 > 4)
+    {
+        referenceSubsetMZ(bin, bincontainer, notInBins, OS, cumError, binStartInOS + cutpos + 1, binEndInOS);
+    }
+    else
+    {
+        for (int i = cutpos + 1; i < binsizeInOS; i++)
+        {
+            notInBins.push_back(bin->pointsInBin[binStartInOS + i]);
+        }
+    }
+}
+
+#pragma endregion "reference implementation"
+
+int main(int argc, char *argv[])
+{
+    const size_t traces = argc > 1 ? std::stoull(argv[1]) : 4000;
+    const unsigned int scans = argc > 2 ? std::stoul(argv[2]) : 300;
+    bool identical = true;
+
+    // binningCritVal alone, once for sizes within the table and once for the fallback beyond it
+    double maxDifference = 0;
+    for (size_t i = 1; i < 4000; i++)
+    {
+        maxDifference = std::max(maxDifference, std::abs(binningCritVal(i, 1) - referenceCritVal(i, 1)) / referenceCritVal(i, 1));
+    }
+    identical = maxDifference < 1e-15;
+    printf("binningCritVal: largest relative difference to the previous implementation %g\n", maxDifference);
+    for (const auto &[smallest, largest] : {std::pair<size_t, size_t>(5, 2047), std::pair<size_t, size_t>(2048, 100000)})
+    {
+        const size_t calls = 20000000;
+        std::mt19937 generator(9);
+        std::uniform_int_distribution<size_t> sizes(smallest, largest);
+        std::vector<size_t> n(1 << 16);
+        for (size_t &value : n)
+        {
+            value = sizes(generator);
+        }
+
+        // the loop without any call, the uncertainty changes so the calls cannot be hoisted
+        double sum = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < calls; i++)
+        {
+            sum += n[i & 0xFFFF] * (1e-4 + i * 1e-12);
+        }
+        const std::chrono::duration<double> timeLoop = std::chrono::high_resolution_clock::now() - start;
+        start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < calls; i++)
+        {
+            sum += referenceCritVal(n[i & 0xFFFF], 1e-4 + i * 1e-12);
+        }
+        const std::chrono::duration<double> timeReference = std::chrono::high_resolution_clock::now() - start;
+        start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < calls; i++)
+        {
+            sum -= binningCritVal(n[i & 0xFFFF], 1e-4 + i * 1e-12);
+        }
+        const std::chrono::duration<double> timeTable = std::chrono::high_resolution_clock::now() - start;
+        printf("    n in [%zu, %zu]: loop %5.2f ns, previous %5.2f ns/call, binningCritVal %5.2f ns/call (%g)\n",
+               smallest, largest, 1e9 * timeLoop.count() / calls, 1e9 * timeReference.count() / calls,
+               1e9 * timeTable.count() / calls, sum);
+    }
+
+    // subsetMZ on one bin that contains all mass traces, as at the start of the binning
+    {
+        std::mt19937 generator(10);
+        std::uniform_real_distribution<double> uniform(0, 1);
+        std::vector<qCentroid> centroids;
+        centroids.reserve(traces * scans * 11 / 10);
+        for (size_t trace = 0; trace < traces; trace++)
+        {
+            const double mz = 100 + 900 * uniform(generator);
+            const float mzError = mz * 2e-6;
+            for (unsigned int scan = 2; scan < scans + 2; scan++)
+            {
+                centroids.push_back(qCentroid{mz + mzError * (uniform(generator) - 0.5), mzError, scan, 1, 1, 1, 5, 0});
+                if (uniform(generator) < 0.1) // noise
+                {
+                    const double noise = 100 + 900 * uniform(generator);
+                    centroids.push_back(qCentroid{noise, float(noise * 2e-6), scan, 1, 1, 1, 5, 0});
+                }
+            }
+        }
+        Bin bin;
+        for (const qCentroid &cen : centroids)
+        {
+            bin.pointsInBin.push_back(&cen);
+        }
+        std::sort(bin.pointsInBin.begin(), bin.pointsInBin.end(), [](const qCentroid *lhs, const qCentroid *rhs)
+                  { return lhs->mz < rhs->mz; });
+        const std::vector<double> OS = makeOrderSpace(&bin);
+        const std::vector<double> cumError = makeCumError(&bin.pointsInBin);
+
+        std::vector<Bin> expectedBins, bins;
+        std::vector<const qCentroid *> expectedNotInBins, notInBins;
+        auto start = std::chrono::high_resolution_clock::now();
+        referenceSubsetMZ(&bin, &expectedBins, expectedNotInBins, OS, cumError, 0, OS.size() - 1);
+        const std::chrono::duration<double> timeReference = std::chrono::high_resolution_clock::now() - start;
+        start = std::chrono::high_resolution_clock::now();
+        bin.subsetMZ(&bins, notInBins, OS, cumError, 0, OS.size() - 1);
+        const std::chrono::duration<double> timeTable = std::chrono::high_resolution_clock::now() - start;
+
+        bool sameBins = bins.size() == expectedBins.size() && notInBins == expectedNotInBins;
+        for (size_t i = 0; sameBins && i < bins.size(); i++)
+        {
+            sameBins = bins[i].pointsInBin == expectedBins[i].pointsInBin;
+        }
+        identical = identical && sameBins;
+        printf("subsetMZ on %zu centroids: previous %.4f s, table %.4f s, %zu bins, %zu points not in bins\n",
+               centroids.size(), timeReference.count(), timeTable.count(), bins.size(), notInBins.size());
+    }
+
+    if (!identical)
+    {
+        printf("Error: the results differ from the previous implementation\n");
+        return 1;
+    }
+    printf("the results of both implementations are identical\n");
+    return 0;
+}
@@ -0,0 +1,140 @@
+// benchmark of the centroid csv output: rows per second and peak memory of printCentroids (BufferedWriter)
+// compared with the previous implementation, which built the whole table in a stringstream.
+// usage: bench_csv_writer [rows] [output directory]
+// Every variant runs in its own process, so the peak RSS of one does not hide that of the other. POSIX only.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../include/qalgorithms_input_output.h"
+
+using namespace qAlgorithms;
+
+// printCentroids before the buffered writer, unchanged except for the announcement
+void referencePrintCentroids(const std::vector<CentroidPeak> *peaktable,
+                             const std::vector<float> *convertRT,
+                             std::filesystem::path pathOutput)
+{
+    std::ofstream file_out;
+    std::stringstream output;
+    file_out.open(pathOutput, std::ios::out);
+    output << "cenID,mz,mzUncertainty,scanNumber,retentionTime,area,areaUncertainty,"
+           << "height,heightUncertainty,scale,degreesOfFreedom,DQSC,interpolations,competitors\n";
+    unsigned int counter = 0;
+    for (size_t j = 0; j < peaktable->size(); ++j)
+    {
+        const CentroidPeak peak = peaktable->at(j);
+        char buffer[256];
+        snprintf(buffer, 256, "%d,%0.6f,%0.6f,%d,%0.4f,%0.4f,%0.4f,%0.4f,%0.4f,%d,%u,%0.5f,%d,%d\n",
+                 counter, peak.mz, peak.mzUncertainty, peak.scanNumber, convertRT->at(peak.scanNumber),
+                 peak.area, peak.areaUncertainty, peak.height, peak.heightUncertainty, peak.scale, peak.df, peak.DQSC,
+                 peak.interpolations, peak.numCompetitors);
+        output << buffer;
+        ++counter;
+    }
+
+    file_out << output.str();
+    file_out.close();
+}
+
+// peak resident set size of this process in MB
+double peakRSS()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0; // kB on linux
+}
+
+int main(int argc, char *argv[])
+{
+    const size_t rows = argc > 1 ? std::stoull(argv[1]) : 5000000;
+    const std::filesystem::path directory = argc > 2 ? argv[2] : std::filesystem::temp_directory_path();
+
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<float> values(0, 1);
+    const unsigned int scans = 2000;
+    std::vector<float> convertRT(scans);
+    for (size_t i = 0; i < scans; i++)
+    {
+        convertRT[i] = 0.5 * i;
+    }
+    std::vector<CentroidPeak> centroids(rows);
+    for (size_t i = 0; i < rows; i++)
+    {
+        CentroidPeak *peak = &centroids[i];
+        peak->mz = 100 + 1000 * values(generator);
+        peak->mzUncertainty = 1e-4 * values(generator);
+        peak->scanNumber = i * scans / rows;
+        peak->area = 1e6 * values(generator);
+        peak->areaUncertainty = 1e3 * values(generator);
+        peak->height = 1e5 * values(generator);
+        peak->heightUncertainty = 1e2 * values(generator);
+        peak->scale = 2 + i % 6;
+        peak->df = 3 + i % 9;
+        peak->DQSC = values(generator);
+        peak->interpolations = i % 3;
+        peak->numCompetitors = i % 2;
+    }
+    std::cout << rows << " centroids, table and generator use " << peakRSS() << " MB\n";
+
+    struct Variant
+    {
+        const char *name;
+        bool reference;
+        bool compress;
+    };
+    const std::vector<Variant> variants = {{"stringstream", true, false},
+                                           {"BufferedWriter", false, false},
+                                           {"BufferedWriter gzip", false, true}};
+    const std::filesystem::path pathReference = directory / "bench_stringstream_centroids.csv";
+    for (const Variant &variant : variants)
+    {
+        std::cout.flush();
+        pid_t child = fork();
+        if (child == 0)
+        {
+            const auto start = std::chrono::high_resolution_clock::now();
+            std::filesystem::path pathOutput = pathReference;
+            if (variant.reference)
+            {
+                referencePrintCentroids(&centroids, &convertRT, pathOutput);
+            }
+            else
+            {
+                pathOutput = outputFilePath(directory, "bench_buffered", "_centroids", false, variant.compress);
+                printCentroids(&centroids, &convertRT, directory, "bench_buffered", true, false, false, false, variant.compress);
+            }
+            const std::chrono::duration<double> time = std::chrono::high_resolution_clock::now() - start;
+            printf("%-20s %8.3f s %12.0f rows/s   peak RSS %8.1f MB   %8.1f MB written\n", variant.name, time.count(),
+                   rows / time.count(), peakRSS(), std::filesystem::file_size(pathOutput) / 1048576.0);
+            fflush(stdout);
+            _exit(0);
+        }
+        int status;
+        waitpid(child, &status, 0);
+    }
+
+    // both csv variants must produce the same file
+    const std::filesystem::path pathBuffered = directory / "bench_buffered_centroids.csv";
+    std::ifstream reference(pathReference, std::ios::binary);
+    std::ifstream buffered(pathBuffered, std::ios::binary);
+    const bool same = std::equal(std::istreambuf_iterator<char>(reference), std::istreambuf_iterator<char>(),
+                                 std::istreambuf_iterator<char>(buffered), std::istreambuf_iterator<char>());
+    std::cout << (same ? "the csv files are identical\n" : "Error: the csv files differ\n");
+    std::filesystem::remove(pathReference);
+    std::filesystem::remove(pathBuffered);
+    std::filesystem::remove(outputFilePath(directory, "bench_buffered", "_centroids", false, true));
+    return same ? 0 : 1;
+}
@@ -0,0 +1,199 @@
+// benchmark of Bin::makeDQSB in high-density regions, compared with the previous implementation that scanned
+// the whole score region for every point of the bin. The test data is a polymer series: one bin per repeating
+// unit, surrounded by a growing number of unbinned points in every scan.
+// usage: bench_dqsb [series length] [scans per bin]
+// Returns 1 if the scores of both implementations differ.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "../include/qalgorithms_qbin.h"
+
+using namespace qAlgorithms;
+
+#pragma region "reference implementation"
+
+float referenceCalcDQS(float meanInnerDist, float minOuterDist)
+{
+    float maxInVal = std::max(minOuterDist, meanInnerDist);
+    if (maxInVal == INFINITY)
+    {
+        return 1;
+    }
+    return (minOuterDist - meanInnerDist) / fmal(meanInnerDist, maxInVal, maxInVal);
+}
+
+// Bin::makeDQSB before the sliding window, the bin must be sorted by scans
+std::vector<float> referenceMakeDQSB(const Bin *bin, const std::vector<const qCentroid *> *notInBins)
+{
+    const size_t maxdist = 3;
+    float mz_hardLimit = std::max(0.1, bin->mzMax * 10e-5);
+    size_t expandedDist = maxdist + 2;
+
+    size_t idx_lowerLimit = 0;
+    for (; idx_lowerLimit < notInBins->size(); idx_lowerLimit++)
+    {
+        if ((*notInBins)[idx_lowerLimit]->mz > bin->mzMin - mz_hardLimit)
+        {
+            break;
+        }
+    }
+    size_t idx_upperLimit = idx_lowerLimit;
+    for (; idx_upperLimit < notInBins->size(); idx_upperLimit++)
+    {
+        if ((*notInBins)[idx_upperLimit]->mz > bin->mzMax + mz_hardLimit)
+        {
+            break;
+        }
+    }
+    std::vector<const qCentroid *> scoreRegion;
+    scoreRegion.reserve((idx_upperLimit - idx_lowerLimit) / 2);
+    size_t lowestPossibleScan = bin->scanMin > expandedDist ? bin->scanMin - expandedDist : 0;
+    for (size_t i = idx_lowerLimit; i < idx_upperLimit; i++)
+    {
+        if ((*notInBins)[i]->scanNo > lowestPossibleScan &&
+            (*notInBins)[i]->scanNo < bin->scanMax + expandedDist)
+        {
+            scoreRegion.push_back((*notInBins)[i]);
+        }
+    }
+    std::sort(scoreRegion.begin(), scoreRegion.end(), [](const qCentroid *lhs, const qCentroid *rhs)
+              { return lhs->scanNo < rhs->scanNo; });
+
+    std::vector<float> minOuterDistances(bin->pointsInBin.size());
+    for (size_t i = 0; i < bin->pointsInBin.size(); i++)
+    {
+        int activeScan = bin->pointsInBin[i]->scanNo;
+        float activeMZ = bin->pointsInBin[i]->mz;
+        float currentMin = INFINITY;
+        size_t readVal = 0;
+        for (; readVal < scoreRegion.size(); readVal++)
+        {
+            if (scoreRegion[readVal]->scanNo > activeScan - expandedDist)
+            {
+                break;
+            }
+        }
+        for (; readVal < scoreRegion.size(); readVal++)
+        {
+            if (scoreRegion[readVal]->scanNo > activeScan + expandedDist)
+            {
+                break;
+            }
+            float distanceMZ = std::abs(scoreRegion[readVal]->mz - activeMZ);
+            if (distanceMZ < currentMin)
+            {
+                currentMin = distanceMZ;
+            }
+        }
+        if (currentMin == 0)
+        {
+            currentMin = 1e-100;
+        }
+        minOuterDistances[i] = currentMin;
+    }
+
+    std::vector<float> meanInnerDistances = meanDistanceRegional(&bin->pointsInBin, expandedDist);
+    std::vector<float> DQSB;
+    for (size_t i = 0; i < bin->pointsInBin.size(); i++)
+    {
+        DQSB.push_back(meanInnerDistances[i] == minOuterDistances[i] ? 0 : referenceCalcDQS(meanInnerDistances[i], minOuterDistances[i]));
+    }
+    return DQSB;
+}
+
+#pragma endregion "reference implementation"
+
+int main(int argc, char *argv[])
+{
+    const size_t seriesLength = argc > 1 ? std::stoull(argv[1]) : 40;
+    const unsigned int scans = argc > 2 ? std::stoul(argv[2]) : 400;
+    const unsigned int firstScan = 20; // the previous implementation ignored neighbours below maxdist + 2
+
+    printf("%zu bins of %u points, 44.026 Da apart\n", seriesLength, scans);
+    printf("%12s %14s %12s %12s %9s\n", "points/scan", "score region", "previous", "makeDQSB", "speedup");
+    bool identical = true;
+    for (const size_t density : {2, 10, 50, 200})
+    {
+        std::mt19937 generator(8);
+        std::uniform_real_distribution<double> uniform(-1, 1);
+
+        // every bin has one point per scan, the unbinned points are spread over +- 0.09 around it
+        std::vector<qCentroid> binned;
+        std::vector<qCentroid> unbinned;
+        binned.reserve(seriesLength * scans);
+        unbinned.reserve(seriesLength * scans * density);
+        for (size_t unit = 0; unit < seriesLength; unit++)
+        {
+            const double mz = 200.1 + 44.026 * unit;
+            for (unsigned int scan = firstScan; scan < firstScan + scans; scan++)
+            {
+                binned.push_back(qCentroid{mz + 1e-4 * uniform(generator), -1, scan, 1, 1, 1, 5, 0});
+                for (size_t i = 0; i < density; i++)
+                {
+                    const double offset = 0.09 * uniform(generator);
+                    // keep a minimal gap so the points are not part of the bin
+                    unbinned.push_back(qCentroid{mz + offset + std::copysign(2e-3, offset), -1, scan, 1, 1, 1, 5, 0});
+                }
+            }
+        }
+        std::vector<const qCentroid *> notInBins;
+        for (const qCentroid &cen : unbinned)
+        {
+            notInBins.push_back(&cen);
+        }
+        std::sort(notInBins.begin(), notInBins.end(), [](const qCentroid *lhs, const qCentroid *rhs)
+                  { return lhs->mz < rhs->mz; });
+
+        std::vector<Bin> bins(seriesLength);
+        for (size_t unit = 0; unit < seriesLength; unit++)
+        {
+            Bin *bin = &bins[unit];
+            for (size_t i = unit * scans; i < (unit + 1) * scans; i++)
+            {
+                bin->pointsInBin.push_back(&binned[i]);
+            }
+            const auto [min, max] = std::minmax_element(bin->pointsInBin.begin(), bin->pointsInBin.end(),
+                                                        [](const qCentroid *lhs, const qCentroid *rhs)
+                                                        { return lhs->mz < rhs->mz; });
+            bin->mzMin = (*min)->mz;
+            bin->mzMax = (*max)->mz;
+            bin->scanMin = firstScan;
+            bin->scanMax = firstScan + scans - 1;
+        }
+
+        std::vector<std::vector<float>> expected(seriesLength);
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t unit = 0; unit < seriesLength; unit++)
+        {
+            expected[unit] = referenceMakeDQSB(&bins[unit], &notInBins);
+        }
+        const std::chrono::duration<double> timeReference = std::chrono::high_resolution_clock::now() - start;
+
+        start = std::chrono::high_resolution_clock::now();
+        size_t idx_lowerLimit = 0;
+        for (size_t unit = 0; unit < seriesLength; unit++)
+        {
+            idx_lowerLimit = bins[unit].makeDQSB(&notInBins, idx_lowerLimit);
+        }
+        const std::chrono::duration<double> timeCurrent = std::chrono::high_resolution_clock::now() - start;
+
+        for (size_t unit = 0; unit < seriesLength; unit++)
+        {
+            identical = identical && bins[unit].DQSB_base == expected[unit];
+        }
+        printf("%12zu %14zu %10.4f s %10.4f s %8.1fx\n", density, scans * density, timeReference.count(),
+               timeCurrent.count(), timeReference.count() / timeCurrent.count());
+    }
+    if (!identical)
+    {
+        printf("Error: the scores differ from the previous implementation\n");
+        return 1;
+    }
+    printf("the scores of both implementations are identical\n");
+    return 0;
+}
@@ -0,0 +1,134 @@
+// benchmark of the merge test of the componentisation. preferMerge is compared with the previous implementation,
+// which called cdff for every test. If the checkpoints of a file are given, the complete componentisation
+// (findComponents) is timed on them as well, the merge tests happen during the pair and assignment phases.
+// usage: bench_merge [<checkpoint directory> <file name> [repeats]]
+// the checkpoints are written by "qAlgorithms -i <file> -o <checkpoint directory> -checkpoint", the file name
+// is that of the outputs, for example "measurement_positive".
+// Returns 1 if a merge decision differs from the previous implementation.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../include/qalgorithms_qpattern.h"
+#include "../include/qalgorithms_input_output.h"
+#include "../external/CDFlib/cdflib.hpp"
+
+using namespace qAlgorithms;
+
+#pragma region "reference implementation"
+
+// preferMerge before the table of critical values
+bool referencePreferMerge(float rss_complex, float rss_simple, size_t n_total, size_t p_complex)
+{
+    float alpha = 0.05;
+    double F = ((rss_simple - rss_complex) / 3) / (rss_complex / float(n_total - p_complex));
+    double dfn = 3;
+    double dfd = n_total - p_complex;
+    int which = 1;
+    double p = 0;
+    double q = 0;
+    int status = 1;
+    double bound = 0;
+    cdff(&which, &p, &q, &F, &dfn, &dfd, &status, &bound);
+    return q > alpha;
+}
+
+#pragma endregion "reference implementation"
+
+int main(int argc, char *argv[])
+{
+    // merge tests with 1 to 512 denominator degrees of freedom, half of them are covered by the table.
+    // The RSS of the simple model is chosen so that F is spread around the critical value
+    struct Test
+    {
+        float rss_complex;
+        float rss_simple;
+        size_t n_total;
+        size_t p_complex;
+    };
+    std::mt19937 generator(11);
+    std::uniform_int_distribution<size_t> dfds(1, 512);
+    std::uniform_real_distribution<double> uniform(0, 1);
+    std::vector<Test> tests(200000);
+    for (Test &test : tests)
+    {
+        test.p_complex = 8;
+        test.n_total = test.p_complex + dfds(generator);
+        test.rss_complex = 100 + 1000 * uniform(generator);
+        const double F = 12 * uniform(generator) * uniform(generator);
+        test.rss_simple = test.rss_complex + 3 * F * test.rss_complex / (test.n_total - test.p_complex);
+    }
+
+    std::vector<char> expected(tests.size());
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < tests.size(); i++)
+    {
+        expected[i] = referencePreferMerge(tests[i].rss_complex, tests[i].rss_simple, tests[i].n_total, tests[i].p_complex);
+    }
+    const std::chrono::duration<double> timeReference = std::chrono::high_resolution_clock::now() - start;
+
+    std::vector<char> result(tests.size());
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < tests.size(); i++)
+    {
+        result[i] = preferMerge(tests[i].rss_complex, tests[i].rss_simple, tests[i].n_total, tests[i].p_complex);
+    }
+    const std::chrono::duration<double> timeTable = std::chrono::high_resolution_clock::now() - start;
+
+    size_t differences = 0;
+    size_t merged = 0;
+    for (size_t i = 0; i < tests.size(); i++)
+    {
+        differences += expected[i] != result[i];
+        merged += result[i];
+    }
+    printf("preferMerge: cdff %7.1f ns/test, table %7.1f ns/test, %zu of %zu tests merged, %zu decisions differ\n",
+           1e9 * timeReference.count() / tests.size(), 1e9 * timeTable.count() / tests.size(), merged, tests.size(),
+           differences);
+
+    // the complete componentisation on real data
+    if (argc > 2)
+    {
+        const std::filesystem::path directory = argv[1];
+        const std::string filename = argv[2];
+        const size_t repeats = argc > 3 ? std::stoull(argv[3]) : 3;
+
+        CentroidState centroids;
+        std::vector<FeaturePeak> features;
+        if (!readCheckpoint(checkpointPath(directory, filename, CheckpointStage::centroids), &centroids) ||
+            !readCheckpoint(checkpointPath(directory, filename, CheckpointStage::features), &features))
+        {
+            return 1;
+        }
+        printf("findComponents on %zu features of %s:\n", features.size(), filename.c_str());
+        for (size_t repeat = 0; repeat < repeats; repeat++)
+        {
+            // the component IDs of the features and bins are set by findComponents, every repeat starts from the checkpoint
+            EICStore bins;
+            if (!readCheckpoint(checkpointPath(directory, filename, CheckpointStage::bins), "", &bins))
+            {
+                return 1;
+            }
+            std::vector<FeaturePeak> peaks = features;
+            ComponentStats stats;
+            const auto components = findComponents(&peaks, &bins, &centroids.convertRT, centroids.minCenArea, &stats);
+            printf("    %8.4f s total, pairs %8.4f s, assignment %8.4f s, %zu components, "
+                   "%zu / %zu merges and %zu / %zu additions accepted\n",
+                   stats.time_wall, stats.time_pairs, stats.time_assign, components.size(), stats.mergesAccepted,
+                   stats.mergesAccepted + stats.mergesRejected, stats.growAccepted, stats.growAccepted + stats.growRejected);
+        }
+    }
+    if (differences != 0)
+    {
+        printf("Error: the merge decisions differ from the previous implementation\n");
+        return 1;
+    }
+    printf("the merge decisions of both implementations are identical\n");
+    return 0;
+}
@@ -0,0 +1,151 @@
+// compare the precalculated inverse of the multi-regression (multiInverse) with a numerical inverse of xTx
+// for every scale and peak count that is used during componentisation. Returns 0 if all values agree.
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "../include/qalgorithms_qpattern.h"
+#include "../include/qalgorithms_qpeaks.h"
+
+using namespace qAlgorithms;
+
+// xTx of a multi-regression: one b0 per peak, the other coefficients are shared by all peaks
+std::vector<std::vector<long double>> multiXtX(size_t scale, size_t numPeaks)
+{
+    const size_t dim = numPeaks + 3;
+    std::vector<std::vector<long double>> xtx(dim, std::vector<long double>(dim, 0));
+    for (size_t peak = 0; peak < numPeaks; peak++)
+    {
+        for (long double x = -double(scale); x <= double(scale); x++)
+        {
+            std::vector<long double> row(dim, 0);
+            row[peak] = 1;
+            row[numPeaks] = x;
+            row[numPeaks + 1] = x < 0 ? x * x : 0;
+            row[numPeaks + 2] = x > 0 ? x * x : 0;
+            for (size_t i = 0; i < dim; i++)
+            {
+                for (size_t j = 0; j < dim; j++)
+                {
+                    xtx[i][j] += row[i] * row[j];
+                }
+            }
+        }
+    }
+    return xtx;
+}
+
+// Gauss-Jordan elimination with partial pivoting
+std::vector<std::vector<long double>> invert(std::vector<std::vector<long double>> matrix)
+{
+    const size_t dim = matrix.size();
+    std::vector<std::vector<long double>> inverse(dim, std::vector<long double>(dim, 0));
+    for (size_t i = 0; i < dim; i++)
+    {
+        inverse[i][i] = 1;
+    }
+    for (size_t col = 0; col < dim; col++)
+    {
+        size_t pivot = col;
+        for (size_t row = col + 1; row < dim; row++)
+        {
+            if (std::fabs(matrix[row][col]) > std::fabs(matrix[pivot][col]))
+            {
+                pivot = row;
+            }
+        }
+        std::swap(matrix[col], matrix[pivot]);
+        std::swap(inverse[col], inverse[pivot]);
+        const long double div = matrix[col][col];
+        for (size_t j = 0; j < dim; j++)
+        {
+            matrix[col][j] /= div;
+            inverse[col][j] /= div;
+        }
+        for (size_t row = 0; row < dim; row++)
+        {
+            if (row == col)
+            {
+                continue;
+            }
+            const long double factor = matrix[row][col];
+            for (size_t j = 0; j < dim; j++)
+            {
+                matrix[row][j] -= factor * matrix[col][j];
+                inverse[row][j] -= factor * inverse[col][j];
+            }
+        }
+    }
+    return inverse;
+}
+
+int main()
+{
+    // INV_ARRAY is calculated in single precision, so the tolerance is relative to the largest value of the inverse
+    const double tolerance = 1e-5;
+    size_t failures = 0;
+    double maxError = 0;
+    for (size_t scale = 2; scale < MAXSCALE; scale++)
+    {
+        // the table covers up to MULTI_INV_PEAKS, larger components are calculated at runtime
+        for (size_t numPeaks = 2; numPeaks <= MULTI_INV_PEAKS + 4; numPeaks++)
+        {
+            const auto inverse = invert(multiXtX(scale, numPeaks));
+            const MultiInverse inv = multiInverse(scale, numPeaks);
+            const size_t b1 = numPeaks;
+            const size_t b2 = numPeaks + 1;
+
+            long double largest = 0;
+            for (const auto &row : inverse)
+            {
+                for (long double value : row)
+                {
+                    largest = std::max(largest, std::fabs(value));
+                }
+            }
+            // expected value of every cell, see findCoefficients_multi for the layout
+            auto expected = [&](size_t i, size_t j) -> double
+            {
+                if (i > j)
+                {
+                    std::swap(i, j);
+                }
+                if (j < numPeaks)
+                {
+                    return i == j ? inv.A1 : inv.A2;
+                }
+                if (i < numPeaks)
+                {
+                    return j == b1 ? 0 : inv.B;
+                }
+                if (i == b1)
+                {
+                    return j == b1 ? inv.C : (j == b2 ? inv.D : -inv.D);
+                }
+                return i == j ? inv.E : inv.F;
+            };
+            for (size_t i = 0; i < numPeaks + 3; i++)
+            {
+                for (size_t j = 0; j < numPeaks + 3; j++)
+                {
+                    const double error = std::fabs(expected(i, j) - inverse[i][j]) / largest;
+                    maxError = std::max(maxError, error);
+                    if (error > tolerance)
+                    {
+                        std::cerr << "Error: scale " << scale << ", " << numPeaks << " peaks, cell (" << i << ", " << j
+                                  << "): expected " << double(inverse[i][j]) << ", got " << expected(i, j) << "\n";
+                        failures++;
+                    }
+                }
+            }
+        }
+    }
+    std::cout << "largest relative difference: " << maxError << "\n";
+    if (failures > 0)
+    {
+        std::cerr << failures << " values of the multi-regression inverse are wrong\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,233 @@
+// compare cumulativeRSS and tanimotoScore with the scalar implementations they replaced. The reference
+// versions below are unchanged copies, the inputs are random peaks with noise. Returns 0 if all results agree.
+
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../include/qalgorithms_qpattern.h"
+
+using namespace qAlgorithms;
+
+#pragma region "reference implementation"
+
+double residual(const RegCoeffs *coeff, float realInt, size_t index_x0, size_t index, bool left)
+{
+    float b23 = left ? coeff->b2 : coeff->b3;
+    float maxHeight = INFINITY;
+    if (b23 > 0) [[unlikely]]
+    {
+        // the exponential part is positive, limit the height to the maximum of the other half
+        float maxPos = -coeff->b1 / (2 * (left ? coeff->b3 : coeff->b3));
+        maxHeight = std::exp(coeff->b0 + (coeff->b1 + maxPos * b23) * maxPos); // correct for positive exponential
+    }
+
+    double new_x = double(index) - double(index_x0);
+    double y_base = std::exp(coeff->b0 + (coeff->b1 + b23 * new_x) * new_x);
+    // in case a positive exponent half is in the new window, we need to prevent excessive distrotion from the exponential part
+    y_base = y_base <= maxHeight ? y_base : maxHeight / (new_x + 1); // halve with the first step from index_x0
+    double RS = (y_base - realInt) * (y_base - realInt);             // residual square
+    assert(RS < INFINITY);
+    return (RS);
+}
+
+std::vector<float> referenceCumulativeRSS(std::span<const float> intensities,
+                                          const RegCoeffs *coeff,
+                                          size_t index_x0)
+{
+    assert(index_x0 < intensities.size() - 1);
+    std::vector<float> result(intensities.size(), 0);
+
+    result[0] = residual(coeff, intensities.front(), index_x0, 0, true) + 0;
+
+    // left half - 1
+    for (size_t i = 1; i < index_x0; i++)
+    {
+        result[i] = residual(coeff, intensities[i], index_x0, i, true) + result[i - 1];
+    }
+    // center point
+    float diff = std::exp((coeff->b0)) - intensities[index_x0]; // this will never be infinity
+    result[index_x0] = diff * diff + result[index_x0 - 1];
+    // right half
+    for (size_t i = index_x0 + 1; i < intensities.size(); i++)
+    {
+        result[i] = residual(coeff, intensities[i], index_x0, i, false) + result[i - 1];
+    }
+    assert(result.back() < INFINITY);
+    return result;
+}
+
+std::vector<float> referenceEuclidianNorm(std::span<const float> intensity,
+                                          size_t idxStart,
+                                          size_t idxEnd)
+{
+    // the vector is normed by dividing every element by the length
+    size_t numElements = idxEnd - idxStart + 1;
+
+    float length = 0;
+    for (size_t i = 0; i < numElements; i++)
+    {
+        float int_i = intensity[i + idxStart];
+        assert(int_i > 0);
+        length += int_i * int_i;
+    }
+    length = sqrt(length);
+
+    std::vector<float> result(numElements, 0);
+    for (size_t i = 0; i < numElements; i++)
+    {
+        result[i] = intensity[i + idxStart] / length;
+    }
+    return result;
+}
+
+float referenceTanimotoScore(const EICView eics,
+                             size_t idxStart,
+                             size_t idxEnd)
+{
+    size_t numFeats = eics.size();
+    size_t length = idxEnd - idxStart + 1;
+
+    std::vector<std::vector<float>> scaledIntensities(numFeats, std::vector<float>(length, 0));
+    for (size_t i = 0; i < numFeats; i++)
+    {
+        scaledIntensities[i] = referenceEuclidianNorm(eics[i]->intensity, idxStart, idxEnd);
+    }
+
+    double area_min = 0;
+    double area_max = 0;
+    for (size_t element = 0; element < length; element++)
+    {
+        double min = INFINITY;
+        double max = 0;
+        for (size_t feat = 0; feat < numFeats; feat++)
+        {
+            double val = scaledIntensities[feat][element];
+            min = min < val ? min : val;
+            max = max > val ? max : val;
+        }
+        area_min += min;
+        area_max += max;
+    }
+    {
+        // outer vals
+        double min_L = INFINITY;
+        double max_L = 0;
+        double min_R = INFINITY;
+        double max_R = 0;
+        for (size_t feat = 0; feat < numFeats; feat++)
+        {
+            double val_L = scaledIntensities[feat].front();
+            double val_R = scaledIntensities[feat].back();
+            min_L = min_L < val_L ? min_L : val_L;
+            max_L = max_L > val_L ? max_L : val_L;
+            min_R = min_R < val_R ? min_R : val_R;
+            max_R = max_R > val_R ? max_R : val_R;
+        }
+        area_min += (min_L + min_R) / 2;
+        area_max += (max_L + max_R) / 2;
+    }
+
+    double DQS_new = area_min / area_max;
+    if (DQS_new >= 1)
+    {
+        return -1;
+    }
+    return DQS_new;
+}
+
+#pragma endregion "reference implementation"
+
+// intensities of a noisy asymmetric gaussian peak, all values are positive
+std::vector<float> randomPeak(std::mt19937 &generator, size_t length, RegCoeffs *coeff, size_t *index_x0)
+{
+    std::uniform_real_distribution<float> uniform(0, 1);
+    *index_x0 = 1 + size_t(uniform(generator) * (length - 3));
+    coeff->b0 = 4 + 8 * uniform(generator);
+    coeff->b1 = 0.2f * (uniform(generator) - 0.5f);
+    coeff->b2 = -0.5f * uniform(generator) - 0.01f;
+    coeff->b3 = -0.5f * uniform(generator) - 0.01f;
+    if (uniform(generator) < 0.1) // a positive half is limited to the maximum height
+    {
+        // only the right half, on the left half the limit divides by zero next to index_x0 (@todo in cumulativeRSS)
+        coeff->b3 *= -0.0002f;
+    }
+    std::vector<float> intensity(length);
+    for (size_t i = 0; i < length; i++)
+    {
+        double x = double(i) - double(*index_x0);
+        double b23 = i < *index_x0 ? coeff->b2 : coeff->b3;
+        double noise = 1 + 0.1 * (uniform(generator) - 0.5);
+        intensity[i] = std::max(std::exp(std::min(coeff->b0 + (coeff->b1 + b23 * x) * x, 30.0)) * noise, 1e-3);
+    }
+    return intensity;
+}
+
+int main()
+{
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<size_t> lengths(5, 200);
+    std::uniform_int_distribution<size_t> featureCounts(2, 12);
+    size_t failures = 0;
+    double maxDiffRSS = 0;
+    double maxDiffDQS = 0;
+
+    for (size_t trial = 0; trial < 10000; trial++)
+    {
+        const size_t length = lengths(generator);
+        RegCoeffs coeff;
+        size_t index_x0;
+        std::vector<float> intensity = randomPeak(generator, length, &coeff, &index_x0);
+
+        // the split loop only reorders the calculation of the squares. A vectorised exp can differ in the last bit
+        std::vector<float> expected = referenceCumulativeRSS(intensity, &coeff, index_x0);
+        std::vector<float> result = cumulativeRSS(intensity, &coeff, index_x0);
+        for (size_t i = 0; i < length; i++)
+        {
+            const double diff = std::fabs(double(expected[i]) - double(result[i])) / std::max(1.0, double(std::fabs(expected[i])));
+            maxDiffRSS = std::max(maxDiffRSS, diff);
+            if (diff > 1e-6)
+            {
+                std::cerr << "Error: cumulativeRSS differs at " << i << " of trial " << trial << ": "
+                          << expected[i] << " != " << result[i] << "\n";
+                failures++;
+                break;
+            }
+        }
+
+        // tanimotoScore over a component of several features that share the scan axis
+        const size_t numFeats = featureCounts(generator);
+        std::vector<std::vector<float>> intensities(numFeats);
+        std::vector<ReducedEIC> eics(numFeats);
+        std::vector<const ReducedEIC *> selection(numFeats);
+        for (size_t feat = 0; feat < numFeats; feat++)
+        {
+            RegCoeffs featCoeff;
+            size_t featX0;
+            intensities[feat] = randomPeak(generator, length, &featCoeff, &featX0);
+            eics[feat].intensity = intensities[feat];
+            selection[feat] = &eics[feat];
+        }
+        const size_t idxStart = length / 4;
+        const size_t idxEnd = std::max(idxStart + 1, length - 1 - length / 4);
+        // the summation order changed, so the score can differ in the last digits
+        const float expectedDQS = referenceTanimotoScore(selection, idxStart, idxEnd);
+        const float resultDQS = tanimotoScore(selection, idxStart, idxEnd);
+        const double diff = std::fabs(double(expectedDQS) - double(resultDQS));
+        maxDiffDQS = std::max(maxDiffDQS, diff);
+        if (diff > 1e-5)
+        {
+            std::cerr << "Error: tanimotoScore differs in trial " << trial << ": " << expectedDQS << " != " << resultDQS << "\n";
+            failures++;
+        }
+    }
+    std::cout << "largest difference: cumulativeRSS " << maxDiffRSS << ", tanimotoScore " << maxDiffDQS << "\n";
+    if (failures > 0)
+    {
+        std::cerr << failures << " results differ from the reference implementation\n";
+        return 1;
+    }
+    return 0;
+}
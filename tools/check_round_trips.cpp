@@ -0,0 +1,428 @@
+// write and read back every self-contained file format of qAlgorithms and compare the result with the input:
+// checkpoints, the columnar format, gzip output, the EIC arena and the spectrum cache. All files are written to
+// a temporary directory that is removed afterwards. Returns 0 if all round trips are exact.
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+#include "../include/qalgorithms_input_output.h"
+#include "../include/qalgorithms_eic_store.h"
+#include "../include/qalgorithms_spectrum_cache.h"
+#include "./qalgo_utility.h"
+
+using namespace qAlgorithms;
+
+size_t failures = 0;
+
+void expect(bool correct, const std::string &what)
+{
+    if (!correct)
+    {
+        std::cerr << "Error: " << what << "\n";
+        failures++;
+    }
+}
+
+template <typename T>
+bool equal(std::span<const T> a, std::span<const T> b)
+{
+    return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size_bytes()) == 0);
+}
+
+std::vector<char> readFile(const std::filesystem::path &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// decompress a file of one or more concatenated gzip members
+bool inflateFile(const std::filesystem::path &path, std::vector<char> *result)
+{
+    std::vector<char> compressed = readFile(path);
+    z_stream stream{};
+    if (inflateInit2(&stream, MAX_WBITS + 16) != Z_OK)
+    {
+        return false;
+    }
+    stream.next_in = reinterpret_cast<Bytef *>(compressed.data());
+    stream.avail_in = compressed.size();
+    char buffer[1 << 16];
+    int status = Z_OK;
+    while (stream.avail_in > 0)
+    {
+        stream.next_out = reinterpret_cast<Bytef *>(buffer);
+        stream.avail_out = sizeof(buffer);
+        status = inflate(&stream, Z_NO_FLUSH);
+        if (status != Z_OK && status != Z_STREAM_END)
+        {
+            break;
+        }
+        result->insert(result->end(), buffer, buffer + sizeof(buffer) - stream.avail_out);
+        if (status == Z_STREAM_END && stream.avail_in > 0)
+        {
+            inflateReset(&stream); // the next member starts directly after the trailer
+        }
+    }
+    inflateEnd(&stream);
+    return status == Z_STREAM_END;
+}
+
+// bins with random content, the same seed always produces the same bins
+std::vector<EIC> randomBins(unsigned int seed, size_t count)
+{
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<size_t> lengths(5, 60);
+    std::uniform_real_distribution<float> values(0, 1000);
+    std::vector<EIC> bins;
+    for (size_t binID = 0; binID < count; binID++)
+    {
+        const size_t length = lengths(generator);
+        EIC eic(EICLayout{length, length + 4 + length / 3});
+        for (size_t i = 0; i < length; i++)
+        {
+            eic.scanNumbers()[i] = 2 + i * 2;
+            eic.rententionTimes()[i] = values(generator);
+            eic.mz()[i] = values(generator);
+            eic.predInterval()[i] = values(generator);
+            eic.ints_area()[i] = values(generator);
+            eic.ints_height()[i] = values(generator);
+            eic.df()[i] = generator() % 20;
+            eic.DQSB()[i] = values(generator);
+            eic.DQSC()[i] = values(generator);
+            eic.cenID()[i] = generator();
+        }
+        for (size_t i = 0; i < eic.layout.interpolatedLength; i++)
+        {
+            eic.interpolatedIDs()[i] = generator();
+            eic.interpolatedDQSB()[i] = values(generator);
+        }
+        eic.componentID = binID % 3;
+        eic.interpolations = binID % 2;
+        bins.push_back(std::move(eic));
+    }
+    return bins;
+}
+
+bool equalBins(const BinView &a, const BinView &b)
+{
+    return equal(a.scanNumbers, b.scanNumbers) && equal(a.rententionTimes, b.rententionTimes) && equal(a.mz, b.mz) &&
+           equal(a.predInterval, b.predInterval) && equal(a.ints_area, b.ints_area) &&
+           equal(a.ints_height, b.ints_height) && equal(a.df, b.df) && equal(a.DQSB, b.DQSB) && equal(a.DQSC, b.DQSC) &&
+           equal(a.cenID, b.cenID) && equal(a.interpolatedIDs, b.interpolatedIDs) &&
+           equal(a.interpolatedDQSB, b.interpolatedDQSB) && a.componentID == b.componentID &&
+           a.interpolations == b.interpolations;
+}
+
+void checkEICStore(const std::filesystem::path &directory)
+{
+    // once on the heap and once in a memory-mapped spill file
+    for (const std::filesystem::path &spillDirectory : {std::filesystem::path(), directory})
+    {
+        std::vector<EIC> bins = randomBins(1, 200);
+        std::vector<EIC> packed = randomBins(1, 200);
+        EICStore store(&packed, spillDirectory);
+        expect(packed.empty(), "the bins are not released after they were packed");
+        expect(store.size() == bins.size(), "EICStore contains " + std::to_string(store.size()) + " bins");
+        for (size_t binID = 0; binID < bins.size() && binID < store.size(); binID++)
+        {
+            expect(equalBins(store.at(binID), bins[binID].view()),
+                   "bin " + std::to_string(binID) + " of the EICStore differs from EIC::view()");
+        }
+    }
+}
+
+void checkCheckpoints(const std::filesystem::path &directory)
+{
+    std::mt19937 generator(2);
+    std::uniform_real_distribution<float> values(0, 1000);
+
+    CentroidState state;
+    state.spectrumCount = 321;
+    state.centroidCount = 5000;
+    state.diff_rt = 0.25;
+    state.minCenArea = 12.5;
+    for (size_t i = 0; i < 321; i++)
+    {
+        state.convertRT.push_back(values(generator));
+    }
+    for (size_t i = 0; i < state.centroidCount; i++)
+    {
+        state.centroids.push_back(qCentroid{100 + values(generator) / 3.0, values(generator), unsigned(i / 16),
+                                            values(generator), values(generator), values(generator),
+                                            unsigned(generator() % 12), unsigned(i)});
+    }
+    const std::filesystem::path pathCentroids = checkpointPath(directory, "check", CheckpointStage::centroids);
+    CentroidState readState;
+    expect(writeCheckpoint(pathCentroids, &state), "the centroid checkpoint could not be written");
+    expect(readCheckpoint(pathCentroids, &readState), "the centroid checkpoint could not be read");
+    expect(readState.spectrumCount == state.spectrumCount && readState.centroidCount == state.centroidCount &&
+               readState.diff_rt == state.diff_rt && readState.minCenArea == state.minCenArea,
+           "the counts of the centroid checkpoint differ");
+    expect(readState.convertRT == state.convertRT, "the retention times of the centroid checkpoint differ");
+    bool sameCentroids = readState.centroids.size() == state.centroids.size();
+    for (size_t i = 0; sameCentroids && i < state.centroids.size(); i++)
+    {
+        const qCentroid &a = state.centroids[i];
+        const qCentroid &b = readState.centroids[i];
+        sameCentroids = a.mz == b.mz && a.mzError == b.mzError && a.scanNo == b.scanNo && a.int_area == b.int_area &&
+                        a.int_height == b.int_height && a.DQSCentroid == b.DQSCentroid && a.df == b.df &&
+                        a.cenID == b.cenID;
+    }
+    expect(sameCentroids, "the centroids of the centroid checkpoint differ");
+
+    std::vector<EIC> bins = randomBins(3, 100);
+    std::vector<EIC> packed = randomBins(3, 100);
+    EICStore store(&packed, "");
+    const std::filesystem::path pathBins = checkpointPath(directory, "check", CheckpointStage::bins);
+    EICStore readStore;
+    expect(writeCheckpoint(pathBins, &store), "the bin checkpoint could not be written");
+    expect(readCheckpoint(pathBins, "", &readStore), "the bin checkpoint could not be read");
+    expect(readStore.size() == bins.size(), "the bin checkpoint contains " + std::to_string(readStore.size()) + " bins");
+    for (size_t binID = 0; binID < bins.size() && binID < readStore.size(); binID++)
+    {
+        expect(equalBins(readStore.at(binID), bins[binID].view()),
+               "bin " + std::to_string(binID) + " of the bin checkpoint differs");
+    }
+
+    std::vector<FeaturePeak> features(500);
+    for (size_t i = 0; i < features.size(); i++)
+    {
+        FeaturePeak *peak = &features[i];
+        peak->coefficients = RegCoeffs{values(generator), values(generator), -values(generator), -values(generator)};
+        peak->height = values(generator);
+        peak->area = values(generator);
+        peak->mz = values(generator);
+        peak->retentionTime = values(generator);
+        peak->DQSF = values(generator);
+        peak->componentID = i % 7;
+        peak->idxBin = i;
+        peak->idxBinStart = i % 5;
+        peak->idxBinEnd = i % 5 + 9;
+        peak->apexLeft = i % 2;
+    }
+    const std::filesystem::path pathFeatures = checkpointPath(directory, "check", CheckpointStage::features);
+    std::vector<FeaturePeak> readFeatures;
+    expect(writeCheckpoint(pathFeatures, &features), "the feature checkpoint could not be written");
+    expect(readCheckpoint(pathFeatures, &readFeatures), "the feature checkpoint could not be read");
+    bool sameFeatures = readFeatures.size() == features.size();
+    for (size_t i = 0; sameFeatures && i < features.size(); i++)
+    {
+        const FeaturePeak &a = features[i];
+        const FeaturePeak &b = readFeatures[i];
+        sameFeatures = a.coefficients.b0 == b.coefficients.b0 && a.coefficients.b1 == b.coefficients.b1 &&
+                       a.coefficients.b2 == b.coefficients.b2 && a.coefficients.b3 == b.coefficients.b3 &&
+                       a.height == b.height && a.area == b.area && a.mz == b.mz && a.retentionTime == b.retentionTime &&
+                       a.DQSF == b.DQSF && a.componentID == b.componentID && a.idxBin == b.idxBin &&
+                       a.idxBinStart == b.idxBinStart && a.idxBinEnd == b.idxBinEnd && a.apexLeft == b.apexLeft;
+    }
+    expect(sameFeatures, "the features of the feature checkpoint differ");
+}
+
+void checkColumnar(const std::filesystem::path &directory)
+{
+    std::mt19937 generator(4);
+    std::uniform_real_distribution<double> values(0, 1000);
+    const size_t rows = 70000;
+    std::vector<unsigned int> ID(rows);
+    std::vector<float> mz(rows);
+    std::vector<double> area(rows);
+    std::vector<unsigned char> flag(rows);
+    for (size_t i = 0; i < rows; i++)
+    {
+        ID[i] = i + 1;
+        mz[i] = values(generator);
+        area[i] = values(generator);
+        flag[i] = i % 3 == 0;
+    }
+    const std::vector<BinaryColumn> columns = {binaryColumn("ID", &ID), binaryColumn("mz", &mz),
+                                               binaryColumn("area", &area), binaryColumn("flag", &flag)};
+
+    const std::filesystem::path pathPlain = directory / "check.qcol";
+    expect(writeColumnar(pathPlain, &columns, rows, false), "the columnar file could not be written");
+    {
+        ColumnarFile file(pathPlain);
+        expect(file.valid(), "the columnar file could not be read");
+        expect(file.rowCount() == rows, "the columnar file contains " + std::to_string(file.rowCount()) + " rows");
+        expect(file.columns().size() == columns.size(), "the columnar file has the wrong number of columns");
+        expect(equal(file.column<unsigned int>("ID"), std::span<const unsigned int>(ID)), "the column ID differs");
+        expect(equal(file.column<float>("mz"), std::span<const float>(mz)), "the column mz differs");
+        expect(equal(file.column<double>("area"), std::span<const double>(area)), "the column area differs");
+        expect(equal(file.column<unsigned char>("flag"), std::span<const unsigned char>(flag)), "the column flag differs");
+        expect(file.column<float>("ID").empty(), "a column can be read with the wrong type");
+    }
+
+    // the compressed file contains the same bytes as the uncompressed one
+    const std::filesystem::path pathCompressed = directory / "check.qcol.gz";
+    expect(writeColumnar(pathCompressed, &columns, rows, true), "the compressed columnar file could not be written");
+    std::vector<char> inflated;
+    expect(inflateFile(pathCompressed, &inflated), "the compressed columnar file is not a valid gzip file");
+    expect(inflated == readFile(pathPlain), "the compressed columnar file differs from the uncompressed one");
+}
+
+void checkGzip(const std::filesystem::path &directory)
+{
+    // enough rows for several members per flush and several flushes
+    std::mt19937 generator(5);
+    std::uniform_real_distribution<double> values(0, 1000);
+    const std::filesystem::path pathPlain = directory / "check.csv";
+    const std::filesystem::path pathCompressed = directory / "check.csv.gz";
+    {
+        std::ofstream plainFile(pathPlain, std::ios::out | std::ios::binary);
+        std::ofstream compressedFile(pathCompressed, std::ios::out | std::ios::binary);
+        BufferedWriter plain(&plainFile);
+        BufferedWriter compressed(&compressedFile, true);
+        plain.field("ID,mz,area,name\n");
+        compressed.field("ID,mz,area,name\n");
+        for (int i = 0; i < 400000; i++)
+        {
+            const double mz = values(generator);
+            const double area = values(generator);
+            plain.row(i, Fixed{mz, 8}, Fixed{area, 4}, "check");
+            compressed.row(i, Fixed{mz, 8}, Fixed{area, 4}, "check");
+        }
+    }
+    std::vector<char> inflated;
+    expect(inflateFile(pathCompressed, &inflated), "the gzip output is not a valid gzip file");
+    expect(inflated == readFile(pathPlain), "the gzip output differs from the uncompressed output");
+}
+
+// zlib-compressed and base64-encoded array as it is stored in an mzML
+std::string encodeArray(std::span<const double> values)
+{
+    std::vector<unsigned char> bytes(compressBound(values.size_bytes()));
+    uLongf length = bytes.size();
+    int status = compress(bytes.data(), &length, reinterpret_cast<const Bytef *>(values.data()), values.size_bytes());
+    assert(status == Z_OK);
+
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string encoded;
+    for (size_t i = 0; i < length; i += 3)
+    {
+        const unsigned int block = bytes[i] << 16 | (i + 1 < length ? bytes[i + 1] << 8 : 0) |
+                                   (i + 2 < length ? bytes[i + 2] : 0);
+        encoded += alphabet[block >> 18 & 63];
+        encoded += alphabet[block >> 12 & 63];
+        encoded += i + 1 < length ? alphabet[block >> 6 & 63] : '=';
+        encoded += i + 2 < length ? alphabet[block & 63] : '=';
+    }
+    return encoded;
+}
+
+void checkSpectrumCache(const std::filesystem::path &directory)
+{
+    // a minimal mzML: three MS1 spectra of different polarity and mode and one MS2 spectrum
+    struct Spectrum
+    {
+        int level;
+        bool profile;
+        bool positive;
+        double retentionTime;
+        std::vector<double> mz;
+        std::vector<double> intensity;
+    };
+    std::vector<Spectrum> spectra = {{1, true, true, 30.5, {}, {}}, {2, false, true, 31, {}, {}},
+                                     {1, false, false, 31.5, {}, {}}, {1, true, true, 32, {}, {}}};
+    std::mt19937 generator(6);
+    std::uniform_real_distribution<double> values(0, 1);
+    for (Spectrum &spectrum : spectra)
+    {
+        double mz = 100;
+        for (size_t i = 0; i < 150 + generator() % 100; i++)
+        {
+            mz += 0.001 + values(generator);
+            spectrum.mz.push_back(mz);
+            spectrum.intensity.push_back(1e6 * values(generator));
+        }
+    }
+    const std::filesystem::path pathSource = directory / "check.mzML";
+    {
+        std::ofstream file(pathSource);
+        file << "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<indexedmzML><mzML><run id=\"r\"><spectrumList count=\""
+             << spectra.size() << "\">\n";
+        auto binaryArray = [&](std::span<const double> values, const char *accession, const char *name)
+        {
+            const std::string encoded = encodeArray(values);
+            file << "<binaryDataArray encodedLength=\"" << encoded.size() << "\">"
+                 << "<cvParam cvRef=\"MS\" accession=\"MS:1000523\" name=\"64-bit float\" value=\"\"/>"
+                 << "<cvParam cvRef=\"MS\" accession=\"MS:1000574\" name=\"zlib compression\" value=\"\"/>"
+                 << "<cvParam cvRef=\"MS\" accession=\"" << accession << "\" name=\"" << name << "\" value=\"\"/>"
+                 << "<binary>" << encoded << "</binary></binaryDataArray>";
+        };
+        for (size_t i = 0; i < spectra.size(); i++)
+        {
+            const Spectrum &spectrum = spectra[i];
+            file << "<spectrum index=\"" << i << "\" id=\"scan=" << i + 1 << "\" defaultArrayLength=\"" << spectrum.mz.size() << "\">"
+                 << "<cvParam cvRef=\"MS\" accession=\"MS:1000511\" name=\"ms level\" value=\"" << spectrum.level << "\"/>"
+                 << (spectrum.profile ? "<cvParam cvRef=\"MS\" accession=\"MS:1000128\" name=\"profile spectrum\" value=\"\"/>"
+                                      : "<cvParam cvRef=\"MS\" accession=\"MS:1000127\" name=\"centroid spectrum\" value=\"\"/>")
+                 << (spectrum.positive ? "<cvParam cvRef=\"MS\" accession=\"MS:1000130\" name=\"positive scan\" value=\"\"/>"
+                                       : "<cvParam cvRef=\"MS\" accession=\"MS:1000129\" name=\"negative scan\" value=\"\"/>")
+                 << "<scanList count=\"1\"><scan><cvParam cvRef=\"MS\" accession=\"MS:1000016\" name=\"scan start time\" value=\""
+                 << spectrum.retentionTime << "\" unitName=\"second\"/></scan></scanList><binaryDataArrayList count=\"2\">";
+            binaryArray(spectrum.mz, "MS:1000514", "m/z array");
+            binaryArray(spectrum.intensity, "MS:1000515", "intensity array");
+            file << "</binaryDataArrayList></spectrum>\n";
+        }
+        file << "</spectrumList></run></mzML></indexedmzML>\n";
+    }
+
+    StreamCraft::MZML data(pathSource);
+    const std::filesystem::path pathCache = spectrumCachePath(pathSource);
+    expect(writeSpectrumCache(&data, pathCache, "source-hash"), "the spectrum cache could not be written");
+
+    SpectrumCache cache(pathCache, "source-hash");
+    expect(cache.valid(), "the spectrum cache could not be read");
+    expect(cache.spectra().size() == spectra.size(),
+           "the spectrum cache contains " + std::to_string(cache.spectra().size()) + " spectra");
+    for (size_t i = 0; i < spectra.size() && i < cache.spectra().size(); i++)
+    {
+        const SpectrumEntry &entry = cache.spectra()[i];
+        const Spectrum &spectrum = spectra[i];
+        const std::string name = "spectrum " + std::to_string(i) + " of the spectrum cache: ";
+        expect(entry.index == i && entry.level == spectrum.level && bool(entry.profile) == spectrum.profile &&
+                   bool(entry.positive) == spectrum.positive && entry.retentionTime == spectrum.retentionTime,
+               name + "the metadata differs");
+        const SpectrumArrays arrays = cache.spectrum(i);
+        if (spectrum.level != 1)
+        {
+            expect(entry.dataOffset == 0 && arrays.mz.empty(), name + "the arrays of an MS2 spectrum are stored");
+            continue;
+        }
+        expect(equal(arrays.mz, std::span<const double>(spectrum.mz)), name + "the m/z values differ");
+        expect(equal(arrays.intensity, std::span<const double>(spectrum.intensity)), name + "the intensities differ");
+    }
+
+    SpectrumCache otherSource(pathCache, "other-hash");
+    expect(!otherSource.valid(), "the spectrum cache of a different source is accepted");
+}
+
+int main()
+{
+    std::random_device random;
+    const std::filesystem::path directory =
+        std::filesystem::temp_directory_path() / ("qalgorithms_check_round_trips_" + std::to_string(random()));
+    std::filesystem::create_directories(directory);
+
+    checkCheckpoints(directory);
+    checkColumnar(directory);
+    checkGzip(directory);
+    checkEICStore(directory);
+    checkSpectrumCache(directory);
+
+    std::filesystem::remove_all(directory);
+    if (failures > 0)
+    {
+        std::cerr << failures << " round trips are not exact\n";
+        return 1;
+    }
+    std::cout << "all round trips are exact\n";
+    return 0;
+}
@@ -1,9 +1,195 @@
 #include <filesystem>
 #include <vector>
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <functional>
+#include <string>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include "./qalgo_utility.h"
 
+using namespace qAlgorithms;
+
 void readCSV(const std::filesystem::path)
 {
     // @todo
-}
\ No newline at end of file
+}
+
+#pragma region "columnar files"
+
+ColumnarFile::ColumnarFile(const std::filesystem::path &path)
+{
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd != -1)
+    {
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0)
+        {
+            void *map = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map != MAP_FAILED)
+            {
+                data = static_cast<const char *>(map);
+                size = info.st_size;
+                mapped = true;
+            }
+        }
+        close(fd);
+    }
+#endif
+    if (!mapped)
+    {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file.is_open())
+        {
+            std::cerr << "Error: could not open " << path << "\n";
+            return;
+        }
+        buffer.resize(file.tellg());
+        file.seekg(0);
+        file.read(buffer.data(), buffer.size());
+        data = buffer.data();
+        size = buffer.size();
+    }
+
+    // check the header and that all columns are within the file
+    const ColumnarHeader *header = reinterpret_cast<const ColumnarHeader *>(data);
+    bool correct = size >= sizeof(ColumnarHeader) &&
+                   memcmp(header->magic, COLUMNAR_MAGIC, sizeof(COLUMNAR_MAGIC)) == 0 &&
+                   header->version == COLUMNAR_VERSION &&
+                   size >= sizeof(ColumnarHeader) + header->columnCount * sizeof(ColumnEntry);
+    if (correct)
+    {
+        for (const ColumnEntry &entry : columns())
+        {
+            const size_t length = entry.count * columnTypeSize(entry.type);
+            if (columnTypeSize(entry.type) == 0 || entry.offset % COLUMN_ALIGNMENT != 0 ||
+                entry.offset > size || length > size - entry.offset || entry.name[COLUMN_NAME_LENGTH - 1] != '\0')
+            {
+                correct = false;
+                break;
+            }
+        }
+    }
+    if (!correct)
+    {
+        std::cerr << "Error: " << path << " is not a valid qAlgorithms columnar file (version " << COLUMNAR_VERSION << ")\n";
+        release();
+    }
+}
+
+ColumnarFile::~ColumnarFile()
+{
+    release();
+}
+
+void ColumnarFile::release()
+{
+#ifndef _WIN32
+    if (mapped)
+    {
+        munmap(const_cast<char *>(data), size);
+    }
+#endif
+    mapped = false;
+    data = nullptr;
+    size = 0;
+    buffer.clear();
+}
+
+size_t ColumnarFile::rowCount() const
+{
+    if (!valid())
+    {
+        return 0;
+    }
+    return reinterpret_cast<const ColumnarHeader *>(data)->rowCount;
+}
+
+std::span<const ColumnEntry> ColumnarFile::columns() const
+{
+    if (data == nullptr)
+    {
+        return {};
+    }
+    const ColumnarHeader *header = reinterpret_cast<const ColumnarHeader *>(data);
+    return std::span<const ColumnEntry>(reinterpret_cast<const ColumnEntry *>(data + sizeof(ColumnarHeader)),
+                                        header->columnCount);
+}
+
+const ColumnEntry *ColumnarFile::find(const char *name) const
+{
+    for (const ColumnEntry &entry : columns())
+    {
+        if (strncmp(entry.name, name, COLUMN_NAME_LENGTH) == 0)
+        {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+void printColumnarCSV(const ColumnarFile *file, std::ostream &out)
+{
+    // every printed column is looked up once, the printers write the value of one row
+    std::vector<std::function<void(size_t)>> printers;
+    std::string header;
+    for (const ColumnEntry &entry : file->columns())
+    {
+        if (entry.count != file->rowCount())
+        {
+            continue;
+        }
+        header += (printers.empty() ? "" : ",") + std::string(entry.name);
+        switch (entry.type)
+        {
+        case ColumnType::uint8:
+            printers.push_back([&out, values = file->column<unsigned char>(entry.name)](size_t row)
+                               { out << unsigned(values[row]); });
+            break;
+        case ColumnType::int32:
+            printers.push_back([&out, values = file->column<int>(entry.name)](size_t row)
+                               { out << values[row]; });
+            break;
+        case ColumnType::uint32:
+            printers.push_back([&out, values = file->column<unsigned int>(entry.name)](size_t row)
+                               { out << values[row]; });
+            break;
+        case ColumnType::uint64:
+            printers.push_back([&out, values = file->column<uint64_t>(entry.name)](size_t row)
+                               { out << values[row]; });
+            break;
+        case ColumnType::float32:
+            printers.push_back([&out, values = file->column<float>(entry.name)](size_t row)
+                               { out << values[row]; });
+            break;
+        case ColumnType::float64:
+            printers.push_back([&out, values = file->column<double>(entry.name)](size_t row)
+                               { out << values[row]; });
+            break;
+        }
+    }
+    out << header << "\n";
+
+    for (size_t row = 0; row < file->rowCount(); row++)
+    {
+        for (size_t col = 0; col < printers.size(); col++)
+        {
+            if (col != 0)
+            {
+                out << ",";
+            }
+            printers[col](row);
+        }
+        out << "\n";
+    }
+}
+
+#pragma endregion "columnar files"
@@ -2,7 +2,76 @@
 #define QALGORITHMS_TOOLS_UTILS_H
 
 #include <filesystem>
+#include <vector>
+#include <span>
+#include <ostream>
+#include <type_traits>
+
+#include "../include/qalgorithms_columnar.h"
 
 void readCSV(const std::filesystem::path);
 
-#endif
\ No newline at end of file
+/// @brief read-only view on a file in the columnar binary format (.qcol), see include/qalgorithms_columnar.h
+/// @details the file is memory-mapped where possible, so columns are accessed without copying or parsing.
+/// If the file cannot be opened or is not a valid .qcol file, an error is printed and valid() returns false.
+class ColumnarFile
+{
+public:
+    explicit ColumnarFile(const std::filesystem::path &path);
+    ~ColumnarFile();
+    ColumnarFile(const ColumnarFile &) = delete;
+    ColumnarFile &operator=(const ColumnarFile &) = delete;
+
+    bool valid() const { return data != nullptr; }
+    size_t rowCount() const;
+    std::span<const qAlgorithms::ColumnEntry> columns() const;
+
+    // returns nullptr if no column with this name exists
+    const qAlgorithms::ColumnEntry *find(const char *name) const;
+
+    /// @brief access the values of a column without copying them
+    /// @return an empty span if the column does not exist or is not of type T
+    template <typename T>
+    std::span<const T> column(const char *name) const
+    {
+        const qAlgorithms::ColumnEntry *entry = find(name);
+        if (entry == nullptr || !matchesType<T>(entry->type))
+        {
+            return {};
+        }
+        return std::span<const T>(reinterpret_cast<const T *>(data + entry->offset), entry->count);
+    }
+
+private:
+    void release();
+
+    template <typename T>
+    static bool matchesType(qAlgorithms::ColumnType type)
+    {
+        using qAlgorithms::ColumnType;
+        if constexpr (std::is_same_v<T, unsigned char>)
+            return type == ColumnType::uint8;
+        else if constexpr (std::is_same_v<T, int>)
+            return type == ColumnType::int32;
+        else if constexpr (std::is_same_v<T, unsigned int>)
+            return type == ColumnType::uint32;
+        else if constexpr (std::is_same_v<T, uint64_t>)
+            return type == ColumnType::uint64;
+        else if constexpr (std::is_same_v<T, float>)
+            return type == ColumnType::float32;
+        else if constexpr (std::is_same_v<T, double>)
+            return type == ColumnType::float64;
+        return false;
+    }
+
+    const char *data = nullptr;
+    size_t size = 0;
+    bool mapped = false;
+    std::vector<char> buffer; // only used if the file could not be mapped
+};
+
+/// @brief write all columns with one value per row as csv, for example to check a file by hand
+/// @details columns with a different number of values (the b0 of components) are skipped
+void printColumnarCSV(const ColumnarFile *file, std::ostream &out);
+
+#endif